@@ -0,0 +1,87 @@
+/*
+ * This file is part of the libpayload project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <arch/lib_helpers.h>
+#include <arch/sha.h>
+
+#define CPACR_FPEN		(0x3 << 20)
+#define CPTR_EL2_TFP		(1 << 10)
+
+enum {
+	SHA_CE_UNKNOWN = -1,
+	SHA_CE_SHA1 = 1 << 0,
+	SHA_CE_SHA256 = 1 << 1,
+};
+
+static int sha_ce_features = SHA_CE_UNKNOWN;
+
+static int sha_ce_probe(void)
+{
+	const uint64_t isar0 = raw_read_aa64isar0_el1();
+	int features = 0;
+
+	if ((isar0 >> ID_AA64ISAR0_SHA1_SHIFT) & ID_AA64ISAR0_FIELD_MASK)
+		features |= SHA_CE_SHA1;
+	if ((isar0 >> ID_AA64ISAR0_SHA2_SHIFT) & ID_AA64ISAR0_FIELD_MASK)
+		features |= SHA_CE_SHA256;
+	if (!features)
+		return 0;
+
+	/* The instructions use SIMD registers, make sure they don't trap. */
+	switch (get_current_el()) {
+	case EL1:
+		raw_write_cpacr_el1(raw_read_cpacr_el1() | CPACR_FPEN);
+		break;
+	case EL2:
+		raw_write_cptr_el2(raw_read_cptr_el2() & ~CPTR_EL2_TFP);
+		break;
+	default:
+		break;
+	}
+	isb();
+
+	return features;
+}
+
+static int sha_ce_has(const int feature)
+{
+	if (sha_ce_features == SHA_CE_UNKNOWN)
+		sha_ce_features = sha_ce_probe();
+	return !!(sha_ce_features & feature);
+}
+
+int sha1_ce_available(void)
+{
+	return sha_ce_has(SHA_CE_SHA1);
+}
+
+int sha256_ce_available(void)
+{
+	return sha_ce_has(SHA_CE_SHA256);
+}
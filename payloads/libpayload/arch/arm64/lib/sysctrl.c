@@ -549,6 +549,16 @@ uint64_t raw_read_aa64pfr0_el1(void)
 	return aa64pfr0_el1;
 }
 
+/* AA64ISAR0 */
+uint64_t raw_read_aa64isar0_el1(void)
+{
+	uint64_t aa64isar0_el1;
+
+	__asm__ __volatile__("mrs %0, ID_AA64ISAR0_EL1\n\t" : "=r" (aa64isar0_el1) :  : "memory");
+
+	return aa64isar0_el1;
+}
+
 /* MAIR */
 uint64_t raw_read_mair_el1(void)
 {
@@ -22,6 +22,9 @@
 
 #include <libpayload-config.h>
 #include <libpayload.h>
+#ifdef CONFIG_LP_ARM64_SHA_CE
+#include <arch/sha.h>
+#endif
 
 typedef u8 u_int8_t;
 typedef u32 u_int32_t;
@@ -117,6 +120,23 @@ SHA1Transform(u_int32_t state[5], const u_int8_t buffer[SHA1_BLOCK_LENGTH])
 }
 
 
+/*
+ * Hash full blocks, using the CPU's SHA instructions if there are any.
+ */
+static void
+sha1_blocks(u_int32_t state[5], const u_int8_t *data, size_t blocks)
+{
+#ifdef CONFIG_LP_ARM64_SHA_CE
+	if (blocks && sha1_ce_available()) {
+		sha1_ce_transform(state, data, blocks);
+		return;
+	}
+#endif
+	for (; blocks; blocks--, data += SHA1_BLOCK_LENGTH)
+		SHA1Transform(state, data);
+}
+
+
 /*
  * SHA1Init - Initialize new context
  */
@@ -140,15 +160,16 @@ SHA1Init(SHA1_CTX *context)
 void
 SHA1Update(SHA1_CTX *context, const u_int8_t *data, size_t len)
 {
-	size_t i, j;
+	size_t i, j, blocks;
 
 	j = (size_t)((context->count >> 3) & 63);
 	context->count += (len << 3);
 	if ((j + len) > 63) {
 		(void)memcpy(&context->buffer[j], data, (i = 64-j));
-		SHA1Transform(context->state, context->buffer);
-		for ( ; i + 63 < len; i += 64)
-			SHA1Transform(context->state, (u_int8_t *)&data[i]);
+		sha1_blocks(context->state, context->buffer, 1);
+		blocks = (len - i) / SHA1_BLOCK_LENGTH;
+		sha1_blocks(context->state, &data[i], blocks);
+		i += blocks * SHA1_BLOCK_LENGTH;
 		j = 0;
 	} else {
 		i = 0;
@@ -0,0 +1,215 @@
+/*
+ * This file is part of the libpayload project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * SHA-256 as specified in FIPS PUB 180-4, with the same interface as
+ * the SHA-1 implementation.
+ *
+ * Test Vectors
+ * "abc"
+ *   BA7816BF 8F01CFEA 414140DE 5DAE2223 B00361A3 96177A9C B410FF61 F20015AD
+ * "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"
+ *   248D6A61 D20638B8 E5C02693 0C3E6039 A33CE459 64FF2167 F6ECEDD4 19DB06C1
+ */
+
+#include <libpayload-config.h>
+#include <libpayload.h>
+#ifdef CONFIG_LP_ARM64_SHA_CE
+#include <arch/sha.h>
+#endif
+
+static const u32 k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define ror(value, bits) (((value) >> (bits)) | ((value) << (32 - (bits))))
+
+#define S0(x)	(ror(x, 2) ^ ror(x, 13) ^ ror(x, 22))
+#define S1(x)	(ror(x, 6) ^ ror(x, 11) ^ ror(x, 25))
+#define s0(x)	(ror(x, 7) ^ ror(x, 18) ^ ((x) >> 3))
+#define s1(x)	(ror(x, 17) ^ ror(x, 19) ^ ((x) >> 10))
+#define Ch(x, y, z)	(((x) & (y)) ^ (~(x) & (z)))
+#define Maj(x, y, z)	(((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+
+/*
+ * Hash a single 512-bit block.
+ */
+void SHA256Transform(u32 state[8], const u8 buffer[SHA256_BLOCK_LENGTH])
+{
+	u32 w[64];
+	u32 a, b, c, d, e, f, g, h, t1, t2;
+	int i;
+
+	for (i = 0; i < 16; i++)
+		w[i] = (u32)buffer[4 * i] << 24 |
+		       (u32)buffer[4 * i + 1] << 16 |
+		       (u32)buffer[4 * i + 2] << 8 |
+		       (u32)buffer[4 * i + 3];
+	for (i = 16; i < 64; i++)
+		w[i] = s1(w[i - 2]) + w[i - 7] + s0(w[i - 15]) + w[i - 16];
+
+	a = state[0];
+	b = state[1];
+	c = state[2];
+	d = state[3];
+	e = state[4];
+	f = state[5];
+	g = state[6];
+	h = state[7];
+
+	for (i = 0; i < 64; i++) {
+		t1 = h + S1(e) + Ch(e, f, g) + k[i] + w[i];
+		t2 = S0(a) + Maj(a, b, c);
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+	state[5] += f;
+	state[6] += g;
+	state[7] += h;
+}
+
+/* Hash full blocks, using the CPU's SHA instructions if there are any. */
+static void sha256_blocks(u32 state[8], const u8 *data, size_t blocks)
+{
+#ifdef CONFIG_LP_ARM64_SHA_CE
+	if (blocks && sha256_ce_available()) {
+		sha256_ce_transform(state, data, blocks);
+		return;
+	}
+#endif
+	for (; blocks; blocks--, data += SHA256_BLOCK_LENGTH)
+		SHA256Transform(state, data);
+}
+
+void SHA256Init(SHA256_CTX *context)
+{
+	context->count = 0;
+	context->state[0] = 0x6a09e667;
+	context->state[1] = 0xbb67ae85;
+	context->state[2] = 0x3c6ef372;
+	context->state[3] = 0xa54ff53a;
+	context->state[4] = 0x510e527f;
+	context->state[5] = 0x9b05688c;
+	context->state[6] = 0x1f83d9ab;
+	context->state[7] = 0x5be0cd19;
+}
+
+void SHA256Update(SHA256_CTX *context, const u8 *data, size_t len)
+{
+	size_t used = (context->count >> 3) % SHA256_BLOCK_LENGTH;
+
+	context->count += (u64)len << 3;
+
+	if (used) {
+		const size_t fill = MIN(len, SHA256_BLOCK_LENGTH - used);
+		memcpy(&context->buffer[used], data, fill);
+		data += fill;
+		len -= fill;
+		if (used + fill < SHA256_BLOCK_LENGTH)
+			return;
+		sha256_blocks(context->state, context->buffer, 1);
+	}
+
+	sha256_blocks(context->state, data, len / SHA256_BLOCK_LENGTH);
+	data += len & ~(SHA256_BLOCK_LENGTH - 1);
+	len &= SHA256_BLOCK_LENGTH - 1;
+
+	memcpy(context->buffer, data, len);
+}
+
+void SHA256Final(u8 digest[SHA256_DIGEST_LENGTH], SHA256_CTX *context)
+{
+	size_t used = (context->count >> 3) % SHA256_BLOCK_LENGTH;
+	int i;
+
+	context->buffer[used++] = 0x80;
+	if (used > SHA256_BLOCK_LENGTH - 8) {
+		memset(&context->buffer[used], 0, SHA256_BLOCK_LENGTH - used);
+		sha256_blocks(context->state, context->buffer, 1);
+		used = 0;
+	}
+	memset(&context->buffer[used], 0, SHA256_BLOCK_LENGTH - 8 - used);
+	for (i = 0; i < 8; i++)
+		context->buffer[SHA256_BLOCK_LENGTH - 1 - i] =
+			(u8)(context->count >> (i * 8));
+	sha256_blocks(context->state, context->buffer, 1);
+
+	for (i = 0; i < SHA256_DIGEST_LENGTH; i++)
+		digest[i] = (u8)(context->state[i >> 2] >> ((3 - (i & 3)) * 8));
+	memset(context, 0, sizeof(*context));
+}
+
+/**
+ * Compute the SHA-256 hash of the given data as specified by the 'data' and
+ * 'len' arguments, and place the result -- 256 bits (32 bytes) -- into the
+ * specified output buffer 'buf'.
+ *
+ * @param data Pointer to the input data that shall be hashed.
+ * @param len Length of the input data (in bytes).
+ * @param buf Buffer which will hold the resulting hash (must be at
+ * 	      least 32 bytes in size).
+ * @return Pointer to the output buffer where the hash is stored.
+ */
+u8 *sha256(const u8 *data, size_t len, u8 *buf)
+{
+	SHA256_CTX ctx;
+
+	SHA256Init(&ctx);
+	SHA256Update(&ctx, data, len);
+	SHA256Final(buf, &ctx);
+
+	return buf;
+}
@@ -135,62 +135,65 @@ static int ahci_error_recovery(ahci_dev_t *const dev, const u32 intr_status)
 }
 
 /** Give a buffer with even address. */
-static u8 *ahci_prdbuf_init(ahci_dev_t *const dev,
+static u8 *ahci_prdbuf_init(ahci_dev_t *const dev, const int slotnum,
 			    u8 *const user_buf, const size_t len,
 			    const int out)
 {
 	if ((u32)user_buf & 1) {
 		printf("ahci: Odd buffer pointer (%p).\n", user_buf);
-		if (dev->buf) /* orphaned buffer */
-			free((void *)dev->buf - *(dev->buf - 1));
-		dev->buf = malloc(len + 2);
-		if (!dev->buf)
+		u8 **const buf = &dev->slot[slotnum].buf;
+		if (*buf) /* orphaned buffer */
+			free((void *)*buf - *(*buf - 1));
+		*buf = malloc(len + 2);
+		if (!*buf)
 			return NULL;
-		dev->user_buf = user_buf;
-		dev->write_back = !out;
-		dev->buflen = len;
-		if ((u32)dev->buf & 1) {
-			dev->buf[0] = 1;
-			dev->buf += 1;
+		dev->slot[slotnum].user_buf = user_buf;
+		dev->slot[slotnum].write_back = !out;
+		dev->slot[slotnum].buflen = len;
+		if ((u32)*buf & 1) {
+			(*buf)[0] = 1;
+			*buf += 1;
 		} else {
-			dev->buf[0] = 1;
-			dev->buf[1] = 2;
-			dev->buf += 2;
+			(*buf)[0] = 1;
+			(*buf)[1] = 2;
+			*buf += 2;
 		}
 		if (out)
-			memcpy(dev->buf, user_buf, len);
-		return dev->buf;
+			memcpy(*buf, user_buf, len);
+		return *buf;
 	} else {
 		return user_buf;
 	}
 }
 
-static void ahci_prdbuf_finalize(ahci_dev_t *const dev)
+static void ahci_prdbuf_finalize(ahci_dev_t *const dev, const int slotnum)
 {
-	if (dev->buf) {
-		if (dev->write_back)
-			memcpy(dev->user_buf, dev->buf, dev->buflen);
-		free((void *)dev->buf - *(dev->buf - 1));
+	u8 *const buf = dev->slot[slotnum].buf;
+	if (buf) {
+		if (dev->slot[slotnum].write_back)
+			memcpy(dev->slot[slotnum].user_buf, buf,
+				dev->slot[slotnum].buflen);
+		free((void *)buf - *(buf - 1));
 	}
-	dev->buf = NULL;
-	dev->user_buf = NULL;
-	dev->write_back = 0;
-	dev->buflen = 0;
+	dev->slot[slotnum].buf = NULL;
+	dev->slot[slotnum].user_buf = NULL;
+	dev->slot[slotnum].write_back = 0;
+	dev->slot[slotnum].buflen = 0;
 }
 
 static ssize_t ahci_cmdslot_exec(ahci_dev_t *const dev)
 {
-	const int slotnum = 0; /* We always use the first slot. */
+	const int slotnum = 0; /* Synchronous commands use the first slot. */
 
 	if (!(dev->port->cmd_stat & HBA_PxCMD_CR))
 		return -1;
 
 	/* Trigger command execution. */
-	dev->port->cmd_issue |= (1 << slotnum);
+	dev->port->cmd_issue |= (1u << slotnum);
 
 	/* Wait for the controller to finish command execution. */
 	int timeout = 50000; /* Time out after 50000 * 100us == 5s. */
-	while ((dev->port->cmd_issue & (1 << slotnum)) &&
+	while ((dev->port->cmd_issue & (1u << slotnum)) &&
 			!(dev->port->intr_status & HBA_PxIS_TFES) &&
 			timeout--)
 		udelay(100);
@@ -199,7 +202,7 @@ static ssize_t ahci_cmdslot_exec(ahci_dev_t *const dev)
 		return -1;
 	}
 
-	ahci_prdbuf_finalize(dev);
+	ahci_prdbuf_finalize(dev, slotnum);
 
 	const u32 intr_status = ahci_clear_status(dev->port, intr_status);
 	if (intr_status & (HBA_PxIS_FATAL | HBA_PxIS_PCS)) {
@@ -210,20 +213,20 @@ static ssize_t ahci_cmdslot_exec(ahci_dev_t *const dev)
 	}
 }
 
-static size_t ahci_cmdslot_prepare(ahci_dev_t *const dev,
+static size_t ahci_cmdslot_prepare(ahci_dev_t *const dev, const int slotnum,
 				   u8 *const user_buf, size_t buf_len,
 				   const int out)
 {
-	const int slotnum = 0; /* We always use the first slot. */
+	cmdtable_t *const cmdtable = &dev->cmdtables[slotnum];
 
 	size_t read_count = 0;
 
 	memset((void *)&dev->cmdlist[slotnum],
 			'\0', sizeof(dev->cmdlist[slotnum]));
-	memset((void *)dev->cmdtable,
-			'\0', sizeof(*dev->cmdtable));
+	memset((void *)cmdtable,
+			'\0', sizeof(*cmdtable));
 	dev->cmdlist[slotnum].cmd = CMD_CFL(FIS_H2D_FIS_LEN);
-	dev->cmdlist[slotnum].cmdtable_base = virt_to_phys(dev->cmdtable);
+	dev->cmdlist[slotnum].cmdtable_base = virt_to_phys(cmdtable);
 
 	if (buf_len > 0) {
 		size_t prdt_len;
@@ -231,7 +234,7 @@ static size_t ahci_cmdslot_prepare(ahci_dev_t *const dev,
 		int i;
 
 		prdt_len = ((buf_len - 1) >> BYTES_PER_PRD_SHIFT) + 1;
-		const size_t max_prdt_len = ARRAY_SIZE(dev->cmdtable->prdt);
+		const size_t max_prdt_len = ARRAY_SIZE(cmdtable->prdt);
 		if (prdt_len > max_prdt_len) {
 			prdt_len = max_prdt_len;
 			buf_len = prdt_len << BYTES_PER_PRD_SHIFT;
@@ -240,15 +243,15 @@ static size_t ahci_cmdslot_prepare(ahci_dev_t *const dev,
 		dev->cmdlist[slotnum].prdt_length = prdt_len;
 		read_count = buf_len;
 
-		buf = ahci_prdbuf_init(dev, user_buf, buf_len, out);
+		buf = ahci_prdbuf_init(dev, slotnum, user_buf, buf_len, out);
 		if (!buf)
 			return 0;
 		for (i = 0; i < prdt_len; ++i) {
 			const size_t bytes =
 				(buf_len < BYTES_PER_PRD)
 				? buf_len : BYTES_PER_PRD;
-			dev->cmdtable->prdt[i].data_base = virt_to_phys(buf);
-			dev->cmdtable->prdt[i].flags = PRD_TABLE_BYTES(bytes);
+			cmdtable->prdt[i].data_base = virt_to_phys(buf);
+			cmdtable->prdt[i].flags = PRD_TABLE_BYTES(bytes);
 			buf_len -= bytes;
 			buf += bytes;
 		}
@@ -257,59 +260,230 @@ static size_t ahci_cmdslot_prepare(ahci_dev_t *const dev,
 	return read_count;
 }
 
-static ssize_t ahci_ata_read_sectors(ata_dev_t *const ata_dev,
-				     const lba_t start, size_t count,
-				     u8 *const buf)
+/** Check (and clip) a read request against the limits of the command. */
+static int ahci_check_read_range(const u8 read_cmd, const lba_t start,
+				 size_t *const count)
 {
-	ahci_dev_t *const dev = (ahci_dev_t *)ata_dev;
-
-	if (count == 0)
-		return 0;
-
-	if (ata_dev->read_cmd == ATA_READ_DMA) {
+	if (read_cmd == ATA_READ_DMA) {
 		if (start >= (1 << 28)) {
 		       printf("ahci: Sector is not 28-bit addressable.\n");
 		       return -1;
-		} else if (count > 256) {
+		} else if (*count > 256) {
 		       printf("ahci: Sector count too high (max. 256).\n");
-		       count = 256;
+		       *count = 256;
 		}
 #ifdef CONFIG_LP_STORAGE_64BIT_LBA
-	} else if (ata_dev->read_cmd == ATA_READ_DMA_EXT) {
+	} else if (read_cmd == ATA_READ_DMA_EXT) {
 		if (start >= (1ULL << 48)) {
 			printf("ahci: Sector is not 48-bit addressable.\n");
 			return -1;
-		} else if (count > (64 * 1024)) {
+		} else if (*count > (64 * 1024)) {
 		       printf("ahci: Sector count too high (max. 65536).\n");
-		       count = 64 * 1024;
+		       *count = 64 * 1024;
 		}
 #endif
+	} else if (read_cmd == ATA_READ_FPDMA_QUEUED) {
+		/* Queued reads are always 48-bit; no need to complain
+		   about the count, the caller just sees a short read. */
+		if (*count > (64 * 1024))
+			*count = 64 * 1024;
 	} else {
 		printf("ahci: Unsupported ATA read command (0x%x).\n",
-			ata_dev->read_cmd);
+			read_cmd);
 		return -1;
 	}
+	return 0;
+}
+
+static void ahci_read_fis(ahci_dev_t *const dev, const int slotnum,
+			  const u8 read_cmd, const lba_t start,
+			  const size_t sectors)
+{
+	volatile u8 *const fis = dev->cmdtables[slotnum].fis;
+
+	fis[ 0] = FIS_HOST_TO_DEVICE;
+	fis[ 1] = FIS_H2D_CMD;
+	fis[ 2] = read_cmd;
+	fis[ 4] = (start >>  0) & 0xff;
+	fis[ 5] = (start >>  8) & 0xff;
+	fis[ 6] = (start >> 16) & 0xff;
+	fis[ 7] = FIS_H2D_DEV_LBA;
+	fis[ 8] = (start >> 24) & 0xff;
+#ifdef CONFIG_LP_STORAGE_64BIT_LBA
+	if (read_cmd != ATA_READ_DMA) {
+		fis[ 9] = (start >> 32) & 0xff;
+		fis[10] = (start >> 40) & 0xff;
+	}
+#endif
+	if (read_cmd == ATA_READ_FPDMA_QUEUED) {
+		/* Sector count goes into the features registers,
+		   the count register carries the tag. */
+		fis[ 3] = (sectors >>  0) & 0xff;
+		fis[11] = (sectors >>  8) & 0xff;
+		fis[12] = slotnum << FIS_H2D_NCQ_TAG_SHIFT;
+	} else {
+		fis[12] = (sectors >>  0) & 0xff;
+		fis[13] = (sectors >>  8) & 0xff;
+	}
+}
+
+static inline int ahci_use_ncq(const ahci_dev_t *const dev)
+{
+	return (dev->ctrl->caps & HBA_CAPS_SNCQ) &&
+		dev->ata_dev.queue_depth > 1;
+}
+
+/** Fail all outstanding asynchronous requests. */
+static void ahci_fail_requests(ahci_dev_t *const dev)
+{
+	int slotnum;
+
+	for (slotnum = 0; slotnum < dev->slots; ++slotnum) {
+		if (!(dev->slots_busy & (1u << slotnum)))
+			continue;
+		ahci_prdbuf_finalize(dev, slotnum);
+		storage_complete_request(dev->slot[slotnum].req, -1);
+		dev->slot[slotnum].req = NULL;
+	}
+	dev->slots_busy = 0;
+	dev->slots_ncq = 0;
+}
+
+static int ahci_ata_submit_read(ata_dev_t *const ata_dev,
+				storage_req_t *const req)
+{
+	ahci_dev_t *const dev = (ahci_dev_t *)ata_dev;
+
+	const int ncq = ahci_use_ncq(dev);
+	const int depth = ncq ? MIN(dev->slots, ata_dev->queue_depth)
+			      : dev->slots;
+	const u8 read_cmd = ncq ? ATA_READ_FPDMA_QUEUED : ata_dev->read_cmd;
+
+	int slotnum;
+	for (slotnum = 0; slotnum < depth; ++slotnum)
+		if (!(dev->slots_busy & (1u << slotnum)))
+			break;
+	if (slotnum == depth)
+		return 1;
+
+	const size_t shift = ata_dev->sector_size_shift - 9;
+	const lba_t start = req->start >> shift;
+	size_t count = req->count >> shift;
+
+	if (count == 0) {
+		storage_complete_request(req, 0);
+		return 0;
+	}
+	if (ahci_check_read_range(read_cmd, start, &count))
+		return -1;
+	if (!(dev->port->cmd_stat & HBA_PxCMD_CR))
+		return -1;
 
 	const size_t bytes = count << ata_dev->sector_size_shift;
-	const size_t bytes_feasible = ahci_cmdslot_prepare(dev, buf, bytes, 0);
+	const size_t bytes_feasible =
+		ahci_cmdslot_prepare(dev, slotnum, req->buf, bytes, 0);
+	if (!bytes_feasible)
+		return -1;
 	const size_t sectors = bytes_feasible >> ata_dev->sector_size_shift;
 
-	dev->cmdtable->fis[ 0] = FIS_HOST_TO_DEVICE;
-	dev->cmdtable->fis[ 1] = FIS_H2D_CMD;
-	dev->cmdtable->fis[ 2] = ata_dev->read_cmd;
-	dev->cmdtable->fis[ 4] = (start >>  0) & 0xff;
-	dev->cmdtable->fis[ 5] = (start >>  8) & 0xff;
-	dev->cmdtable->fis[ 6] = (start >> 16) & 0xff;
-	dev->cmdtable->fis[ 7] = FIS_H2D_DEV_LBA;
-	dev->cmdtable->fis[ 8] = (start >> 24) & 0xff;
-#ifdef CONFIG_LP_STORAGE_64BIT_LBA
-	if (ata_dev->read_cmd == ATA_READ_DMA_EXT) {
-		dev->cmdtable->fis[ 9] = (start >> 32) & 0xff;
-		dev->cmdtable->fis[10] = (start >> 40) & 0xff;
+	ahci_read_fis(dev, slotnum, read_cmd, start, sectors);
+
+	dev->slot[slotnum].req = req;
+	dev->slot[slotnum].bytes = sectors << ata_dev->sector_size_shift;
+	dev->slot[slotnum].issued = timer_us(0);
+	dev->slots_busy |= 1u << slotnum;
+	if (ncq) {
+		dev->slots_ncq |= 1u << slotnum;
+		dev->port->sata_active = 1u << slotnum;
 	}
-#endif
-	dev->cmdtable->fis[12] = (sectors >>  0) & 0xff;
-	dev->cmdtable->fis[13] = (sectors >>  8) & 0xff;
+	dev->port->cmd_issue = 1u << slotnum;
+
+	return 0;
+}
+
+static int ahci_process_requests(ata_dev_t *const ata_dev)
+{
+	ahci_dev_t *const dev = (ahci_dev_t *)ata_dev;
+	int slotnum, pending = 0;
+
+	if (!dev->slots_busy)
+		return 0;
+
+	const u32 intr_status = ahci_clear_status(dev->port, intr_status);
+	if (intr_status & (HBA_PxIS_FATAL | HBA_PxIS_PCS)) {
+		/* An error aborts all outstanding queued commands. */
+		printf("ahci: Error during queued command execution.\n");
+		ahci_fail_requests(dev);
+		ahci_error_recovery(dev, intr_status);
+		return 0;
+	}
+
+	const u32 running = dev->port->cmd_issue |
+			    (dev->port->sata_active & dev->slots_ncq);
+
+	for (slotnum = 0; slotnum < dev->slots; ++slotnum) {
+		const u32 bit = 1u << slotnum;
+		if (!(dev->slots_busy & bit))
+			continue;
+
+		if (running & bit) {
+			/* Non-queued commands execute one at a time, so
+			   one only starts when the one before it is done. */
+			u64 started = dev->slot[slotnum].issued;
+			if (!(dev->slots_ncq & bit))
+				started = MAX(started, dev->last_done);
+			if (timer_us(started) > 5000000) {
+				printf("ahci: Timeout during queued "
+					"command execution.\n");
+				ahci_fail_requests(dev);
+				ahci_error_recovery(dev, 0);
+				return 0;
+			}
+			++pending;
+			continue;
+		}
+
+		/* PRDBC isn't required to be updated for queued commands,
+		   so we report the requested size on success. */
+		ahci_prdbuf_finalize(dev, slotnum);
+		dev->slots_busy &= ~bit;
+		dev->slots_ncq &= ~bit;
+		dev->last_done = timer_us(0);
+		storage_complete_request(dev->slot[slotnum].req,
+					 dev->slot[slotnum].bytes >> 9);
+		dev->slot[slotnum].req = NULL;
+	}
+
+	return pending;
+}
+
+static void ahci_wait_requests(ahci_dev_t *const dev)
+{
+	while (dev->slots_busy && ahci_process_requests(&dev->ata_dev) > 0)
+		udelay(1);
+}
+
+static ssize_t ahci_ata_read_sectors(ata_dev_t *const ata_dev,
+				     const lba_t start, size_t count,
+				     u8 *const buf)
+{
+	ahci_dev_t *const dev = (ahci_dev_t *)ata_dev;
+
+	if (count == 0)
+		return 0;
+
+	if (ahci_check_read_range(ata_dev->read_cmd, start, &count))
+		return -1;
+
+	/* Queued commands have to finish before we use slot 0. */
+	ahci_wait_requests(dev);
+
+	const size_t bytes = count << ata_dev->sector_size_shift;
+	const size_t bytes_feasible =
+		ahci_cmdslot_prepare(dev, 0, buf, bytes, 0);
+	const size_t sectors = bytes_feasible >> ata_dev->sector_size_shift;
+
+	ahci_read_fis(dev, 0, ata_dev->read_cmd, start, sectors);
 
 	if (ahci_cmdslot_exec(dev) < 0)
 		return -1;
@@ -328,17 +502,17 @@ static ssize_t ahci_packet_read_cmd(atapi_dev_t *const _dev,
 		return -1;
 	}
 
-	const size_t len = ahci_cmdslot_prepare(dev, buf, buflen, 0);
+	const size_t len = ahci_cmdslot_prepare(dev, 0, buf, buflen, 0);
 	u16 byte_limit = MIN(len, 63 * 1024); /* like Linux */
 	if (byte_limit & 1) ++byte_limit; /* even limit */
 
 	dev->cmdlist[0].cmd |= CMD_ATAPI;
-	dev->cmdtable->fis[0] = FIS_HOST_TO_DEVICE;
-	dev->cmdtable->fis[1] = FIS_H2D_CMD;
-	dev->cmdtable->fis[2] = ATA_PACKET;
-	dev->cmdtable->fis[5] = byte_limit & 0xff;
-	dev->cmdtable->fis[6] = byte_limit >> 8;
-	memcpy((void *)dev->cmdtable->atapi_cmd, cmd, cmdlen);
+	dev->cmdtables[0].fis[0] = FIS_HOST_TO_DEVICE;
+	dev->cmdtables[0].fis[1] = FIS_H2D_CMD;
+	dev->cmdtables[0].fis[2] = ATA_PACKET;
+	dev->cmdtables[0].fis[5] = byte_limit & 0xff;
+	dev->cmdtables[0].fis[6] = byte_limit >> 8;
+	memcpy((void *)dev->cmdtables[0].atapi_cmd, cmd, cmdlen);
 
 	return ahci_cmdslot_exec(dev);
 }
@@ -347,11 +521,12 @@ static int ahci_identify_device(ata_dev_t *const ata_dev, u8 *const buf)
 {
 	ahci_dev_t *const dev = (ahci_dev_t *)ata_dev;
 
-	ahci_cmdslot_prepare(dev, buf, 512, 0);
+	ahci_wait_requests(dev);
+	ahci_cmdslot_prepare(dev, 0, buf, 512, 0);
 
-	dev->cmdtable->fis[0] = FIS_HOST_TO_DEVICE;
-	dev->cmdtable->fis[1] = FIS_H2D_CMD;
-	dev->cmdtable->fis[2] = ata_dev->identify_cmd;
+	dev->cmdtables[0].fis[0] = FIS_HOST_TO_DEVICE;
+	dev->cmdtables[0].fis[1] = FIS_H2D_CMD;
+	dev->cmdtables[0].fis[2] = ata_dev->identify_cmd;
 
 	if ((ahci_cmdslot_exec(dev) < 0) || (dev->cmdlist->prd_bytes != 512))
 		return -1;
@@ -367,16 +542,16 @@ static int ahci_dev_init(hba_ctrl_t *const ctrl,
 
 	const int ncs = HBA_CAPS_DECODE_NCS(ctrl->caps);
 
-	/* Allocate command list, one command table and received FIS. */
+	/* Allocate command list, a command table per slot and received FIS. */
 	cmd_t *const cmdlist = memalign(1024, ncs * sizeof(cmd_t));
-	cmdtable_t *const cmdtable = memalign(128, sizeof(cmdtable_t));
+	cmdtable_t *const cmdtables = memalign(128, ncs * sizeof(cmdtable_t));
 	rcvd_fis_t *const rcvd_fis = memalign(256, sizeof(rcvd_fis_t));
 	/* Allocate our device structure. */
 	ahci_dev_t *const dev = calloc(1, sizeof(ahci_dev_t));
-	if (!cmdlist || !cmdtable || !rcvd_fis || !dev)
+	if (!cmdlist || !cmdtables || !rcvd_fis || !dev)
 		goto _cleanup_ret;
 	memset((void *)cmdlist, '\0', ncs * sizeof(cmd_t));
-	memset((void *)cmdtable, '\0', sizeof(*cmdtable));
+	memset((void *)cmdtables, '\0', ncs * sizeof(cmdtable_t));
 	memset((void *)rcvd_fis, '\0', sizeof(*rcvd_fis));
 
 	/* Set command list base and received FIS base. */
@@ -392,8 +567,9 @@ static int ahci_dev_init(hba_ctrl_t *const ctrl,
 	dev->ctrl = ctrl;
 	dev->port = port;
 	dev->cmdlist = cmdlist;
-	dev->cmdtable = cmdtable;
+	dev->cmdtables = cmdtables;
 	dev->rcvd_fis = rcvd_fis;
+	dev->slots = ncs;
 
 	/* Wait for D2H Register FIS with device' signature. */
 	int timeout = 200; /* Time out after 200 * 10ms == 2s. */
@@ -407,6 +583,8 @@ static int ahci_dev_init(hba_ctrl_t *const ctrl,
 #ifdef CONFIG_LP_STORAGE_ATA
 		dev->ata_dev.identify = ahci_identify_device;
 		dev->ata_dev.read_sectors = ahci_ata_read_sectors;
+		dev->ata_dev.submit_read = ahci_ata_submit_read;
+		dev->ata_dev.process_requests = ahci_process_requests;
 		return ata_attach_device(&dev->ata_dev, PORT_TYPE_SATA);
 #endif
 		break;
@@ -434,8 +612,8 @@ _cleanup_ret:
 		port->frameinfo_base = 0;
 		if (rcvd_fis)
 			free((void *)rcvd_fis);
-		if (cmdtable)
-			free((void *)cmdtable);
+		if (cmdtables)
+			free((void *)cmdtables);
 		if (cmdlist)
 			free((void *)cmdlist);
 	}
@@ -108,6 +108,8 @@ typedef volatile struct {
 	hba_port_t ports[32];
 } hba_ctrl_t;
 
+#define HBA_CAPS_SNCQ		(1 << 30) /* SNCQ - Supports Native Command
+					     Queuing */
 #define HBA_CAPS_SSS		(1 << 27) /* SSS - Supports Staggered Spin-up */
 #define HBA_CAPS_NCS_SHIFT	8	/* NCS - Number of Command Slots */
 #define HBA_CAPS_NCS_MASK	(0x1f << HBA_CAPS_NCS_SHIFT)
@@ -175,6 +177,7 @@ enum {
 #define FIS_H2D_CMD	(1 << 7)
 #define FIS_H2D_FIS_LEN	20
 #define FIS_H2D_DEV_LBA	(1 << 6)
+#define FIS_H2D_NCQ_TAG_SHIFT	3
 
 #define PRD_TABLE_I		(1 << 31) /* I - Interrupt on Completion */
 #define PRD_TABLE_BYTES_MASK	0x3fffff
@@ -190,12 +193,23 @@ typedef struct {
 	hba_port_t *port;
 
 	cmd_t *cmdlist;
-	cmdtable_t *cmdtable;
+	cmdtable_t *cmdtables;	/* one per command slot */
 	rcvd_fis_t *rcvd_fis;
 
-	u8 *buf, *user_buf;
-	int write_back;
-	size_t buflen;
+	int slots;		/* number of command slots */
+	u32 slots_busy;		/* slots with outstanding asynchronous reads */
+	u32 slots_ncq;		/* busy slots that carry queued commands */
+	u64 last_done;		/* timer_us(0) at the last completion */
+
+	struct {
+		storage_req_t *req;
+		size_t bytes;	/* size of the issued read */
+		u64 issued;	/* timer_us(0) at issue time */
+
+		u8 *buf, *user_buf;
+		int write_back;
+		size_t buflen;
+	} slot[32];
 } ahci_dev_t;
 
 #endif
@@ -144,10 +144,38 @@ static ssize_t ata_write512(storage_dev_t *const dev,
 	return -1;
 }
 
+static int ata_submit_read512(storage_dev_t *const _dev,
+			      storage_req_t *const req)
+{
+	ata_dev_t *const dev = (ata_dev_t *)_dev;
+
+	/* Requests not aligned to the sector size are done synchronously. */
+	const size_t mask = (dev->sector_size >> 9) - 1;
+	if ((dev->sector_size < 512) ||
+			(req->start & mask) || (req->count & mask)) {
+		storage_complete_request(req, ata_read512(
+				_dev, req->start, req->count, req->buf));
+		return 0;
+	}
+
+	return dev->submit_read(dev, req);
+}
+
+static int ata_process_requests(storage_dev_t *const _dev)
+{
+	ata_dev_t *const dev = (ata_dev_t *)_dev;
+
+	return dev->process_requests(dev);
+}
+
 void ata_initialize_storage_ops(ata_dev_t *const dev)
 {
 	dev->storage_dev.read_blocks512 = ata_read512;
 	dev->storage_dev.write_blocks512 = ata_write512;
+	if (dev->submit_read && dev->process_requests) {
+		dev->storage_dev.submit_read_blocks512 = ata_submit_read512;
+		dev->storage_dev.process_requests = ata_process_requests;
+	}
 }
 
 int ata_set_sector_size(ata_dev_t *const dev, u32 sector_size)
@@ -223,6 +251,16 @@ int ata_attach_device(ata_dev_t *const dev, const storage_port_t port_type)
 	dev->read_cmd = ATA_READ_DMA;
 #endif
 
+	/* Word 76 is only valid for SATA devices (0 or 0xffff otherwise). */
+	if (id[ATA_ID_SATA_CAPS] != 0xffff &&
+			(id[ATA_ID_SATA_CAPS] & (1 << 8))) {
+		dev->queue_depth = (id[ATA_ID_QUEUE_DEPTH] & 0x1f) + 1;
+		printf("ata: NCQ supported (queue depth %u).\n",
+			dev->queue_depth);
+	} else {
+		dev->queue_depth = 0;
+	}
+
 	if (ata_decode_sector_size(dev, id))
 		return -1;
 
@@ -0,0 +1,438 @@
+/*
+ * This file is part of the libpayload project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <libpayload.h>
+#include <stdint.h>
+#include <string.h>
+#include <storage/blockcache.h>
+
+#define BLOCK_SIZE		512
+/* Initial and maximum read-ahead window in blocks. */
+#define READAHEAD_MIN		8
+#define READAHEAD_MAX		256
+/* Number of devices we track sequential access for. */
+#define STREAMS			8
+
+struct entry {
+	const void *dev;
+	lba_t lba;
+	struct entry *hnext;		/* hash chain */
+	struct entry *prev, *next;	/* LRU list, most recent first */
+	unsigned char *data;
+};
+
+struct stream {
+	const void *dev;
+	lba_t next_lba;			/* where a sequential read would start */
+	size_t window;			/* current read-ahead in blocks */
+};
+
+static struct {
+	struct entry *entries;
+	unsigned char *data;
+	size_t count;
+
+	struct entry **hash;
+	size_t hash_mask;
+
+	struct entry lru;		/* list head */
+
+	struct stream streams[STREAMS];
+	size_t next_stream;
+
+	struct blockcache_stats stats;
+
+	int initialized;		/* a budget has been set */
+} cache;
+
+static inline size_t hash(const void *const dev, const lba_t lba)
+{
+	return ((uintptr_t)dev / sizeof(void *) * 31 + lba) & cache.hash_mask;
+}
+
+static void lru_unlink(struct entry *const e)
+{
+	e->prev->next = e->next;
+	e->next->prev = e->prev;
+}
+
+static void lru_push_front(struct entry *const e)
+{
+	e->next = cache.lru.next;
+	e->prev = &cache.lru;
+	cache.lru.next->prev = e;
+	cache.lru.next = e;
+}
+
+static void lru_push_back(struct entry *const e)
+{
+	e->prev = cache.lru.prev;
+	e->next = &cache.lru;
+	cache.lru.prev->next = e;
+	cache.lru.prev = e;
+}
+
+static struct entry *lookup(const void *const dev, const lba_t lba)
+{
+	struct entry *e;
+
+	for (e = cache.hash[hash(dev, lba)]; e; e = e->hnext)
+		if (e->dev == dev && e->lba == lba)
+			return e;
+	return NULL;
+}
+
+static void hash_remove(struct entry *const e)
+{
+	struct entry **p = &cache.hash[hash(e->dev, e->lba)];
+
+	while (*p != e)
+		p = &(*p)->hnext;
+	*p = e->hnext;
+	e->dev = NULL;
+}
+
+/** Drop an entry and make it the first candidate for reuse. */
+static void drop(struct entry *const e)
+{
+	hash_remove(e);
+	lru_unlink(e);
+	lru_push_back(e);
+}
+
+static void insert(const void *const dev, const lba_t lba,
+		   const unsigned char *const data)
+{
+	struct entry *e = lookup(dev, lba);
+
+	if (!e) {
+		/* Reuse the least recently used entry. */
+		e = cache.lru.prev;
+		if (e->dev) {
+			hash_remove(e);
+			cache.stats.evictions++;
+		}
+		e->dev = dev;
+		e->lba = lba;
+		e->hnext = cache.hash[hash(dev, lba)];
+		cache.hash[hash(dev, lba)] = e;
+	}
+	memcpy(e->data, data, BLOCK_SIZE);
+	lru_unlink(e);
+	lru_push_front(e);
+}
+
+static void blockcache_free(void)
+{
+	free(cache.hash);
+	free(cache.data);
+	free(cache.entries);
+	cache.hash = NULL;
+	cache.data = NULL;
+	cache.entries = NULL;
+	cache.count = 0;
+	cache.stats.budget = 0;
+}
+
+/**
+ * Set the amount of memory used for caching
+ *
+ * Drops all cached blocks and reallocates the cache. A budget of 0
+ * disables caching.
+ *
+ * @bytes memory budget including bookkeeping
+ * @return 0 on success, -1 if the memory couldn't be allocated
+ */
+int blockcache_set_budget(const size_t bytes)
+{
+	size_t i, buckets;
+
+	/* An explicit budget, even 0, replaces the configured default. */
+	cache.initialized = 1;
+	blockcache_free();
+	memset(cache.streams, 0, sizeof(cache.streams));
+
+	const size_t count = bytes / (BLOCK_SIZE + sizeof(struct entry) +
+				      sizeof(struct entry *));
+	if (count < READAHEAD_MIN)
+		return 0;
+
+	/* Use a power of two number of buckets, about one per entry. */
+	for (buckets = 1; buckets < count; buckets <<= 1)
+		;
+	buckets >>= 1;
+
+	cache.entries = malloc(count * sizeof(struct entry));
+	cache.data = memalign(64, count * BLOCK_SIZE);
+	cache.hash = calloc(buckets, sizeof(struct entry *));
+	if (!cache.entries || !cache.data || !cache.hash) {
+		printf("blockcache: Couldn't allocate %zu bytes.\n", bytes);
+		blockcache_free();
+		return -1;
+	}
+	cache.count = count;
+	cache.hash_mask = buckets - 1;
+	cache.stats.budget = count * BLOCK_SIZE +
+			     count * sizeof(struct entry) +
+			     buckets * sizeof(struct entry *);
+
+	cache.lru.next = cache.lru.prev = &cache.lru;
+	for (i = 0; i < count; ++i) {
+		cache.entries[i].dev = NULL;
+		cache.entries[i].data = cache.data + i * BLOCK_SIZE;
+		lru_push_back(&cache.entries[i]);
+	}
+
+	return 0;
+}
+
+static int blockcache_ensure_init(void)
+{
+	if (!cache.initialized)
+		return blockcache_set_budget(
+			CONFIG_LP_STORAGE_BLOCKCACHE_SIZE * 1024);
+	return 0;
+}
+
+/** Track sequential access and return how many blocks to read ahead. */
+static size_t readahead(const void *const dev, const lba_t start,
+			const size_t count)
+{
+	struct stream *s = NULL;
+	size_t i;
+
+	for (i = 0; i < STREAMS; ++i) {
+		if (cache.streams[i].dev == dev) {
+			s = &cache.streams[i];
+			break;
+		}
+	}
+	if (!s) {
+		s = &cache.streams[cache.next_stream];
+		cache.next_stream = (cache.next_stream + 1) % STREAMS;
+		s->dev = dev;
+		s->next_lba = start + count;
+		s->window = 0;
+		return 0;
+	}
+
+	/* Reads inside the last read-ahead window are sequential too. */
+	if (start >= s->next_lba && start <= s->next_lba + s->window)
+		s->window = s->window ? MIN(s->window * 2, READAHEAD_MAX)
+				      : READAHEAD_MIN;
+	else
+		s->window = 0;
+	s->next_lba = start + count;
+
+	return MIN(s->window, cache.count / 4);
+}
+
+/**
+ * Read 512-byte blocks through the cache
+ *
+ * Cached blocks are copied from memory, runs of missing blocks are read
+ * from the device in one request. If the access pattern is sequential,
+ * the last run is extended by a read-ahead window. Requests larger than
+ * a quarter of the cache go straight to the device.
+ *
+ * @dev opaque device handle, used as part of the cache key
+ * @read callback that reads from the device
+ * @start number of first block to read from
+ * @count number of blocks to read
+ * @buf buffer where the read data should be written
+ * @return number of blocks read or -1 on error
+ */
+ssize_t blockcache_read(void *const dev, const blockcache_read_t read,
+			const lba_t start, const size_t count,
+			unsigned char *const buf)
+{
+	size_t i = 0;
+
+	blockcache_ensure_init();
+
+	if (!cache.count || count > cache.count / 4) {
+		if (cache.count)
+			readahead(dev, start, count);
+		cache.stats.bypassed += count;
+		return read(dev, start, count, buf);
+	}
+
+	const size_t ra = readahead(dev, start, count);
+
+	while (i < count) {
+		struct entry *const e = lookup(dev, start + i);
+		if (e) {
+			memcpy(buf + i * BLOCK_SIZE, e->data, BLOCK_SIZE);
+			lru_unlink(e);
+			lru_push_front(e);
+			cache.stats.hits++;
+			++i;
+			continue;
+		}
+
+		/* Find the run of missing blocks. */
+		size_t run = 1;
+		while (i + run < count && !lookup(dev, start + i + run))
+			++run;
+		size_t extra = (i + run == count) ? ra : 0;
+
+		unsigned char *bounce = malloc((run + extra) * BLOCK_SIZE);
+		if (!bounce) {
+			/* Read without caching rather than failing. */
+			const ssize_t ret = read(dev, start + i, run,
+						 buf + i * BLOCK_SIZE);
+			if (ret < 0)
+				return -1;
+			cache.stats.misses += ret;
+			if (ret < run)
+				return i + ret;
+			i += run;
+			continue;
+		}
+
+		ssize_t ret = read(dev, start + i, run + extra, bounce);
+		if (ret < 0 && extra) {
+			/* Read-ahead may run past the end of the device. */
+			extra = 0;
+			ret = read(dev, start + i, run, bounce);
+		}
+		if (ret < 0) {
+			free(bounce);
+			return -1;
+		}
+
+		size_t j;
+		for (j = 0; j < ret; ++j)
+			insert(dev, start + i + j, bounce + j * BLOCK_SIZE);
+		const size_t got = MIN(ret, run);
+		memcpy(buf + i * BLOCK_SIZE, bounce, got * BLOCK_SIZE);
+		free(bounce);
+
+		cache.stats.misses += got;
+		cache.stats.readahead += ret - got;
+		i += got;
+		if (got < run)
+			break;
+	}
+
+	return i;
+}
+
+/**
+ * Read 512-byte blocks only if all of them are cached
+ *
+ * Doesn't touch the device or the read-ahead state. Used by callers that
+ * would otherwise read asynchronously.
+ *
+ * @dev opaque device handle
+ * @start number of first block to read from
+ * @count number of blocks to read
+ * @buf buffer where the read data should be written
+ * @return 1 if the blocks were copied to buf, 0 if some weren't cached
+ */
+int blockcache_read_cached(const void *const dev,
+			   const lba_t start, const size_t count,
+			   unsigned char *const buf)
+{
+	size_t i;
+
+	blockcache_ensure_init();
+
+	if (!count || count > cache.count)
+		return 0;
+	for (i = 0; i < count; ++i)
+		if (!lookup(dev, start + i))
+			return 0;
+
+	for (i = 0; i < count; ++i) {
+		struct entry *const e = lookup(dev, start + i);
+		memcpy(buf + i * BLOCK_SIZE, e->data, BLOCK_SIZE);
+		lru_unlink(e);
+		lru_push_front(e);
+	}
+	cache.stats.hits += count;
+	return 1;
+}
+
+/**
+ * Drop cached blocks of a device
+ *
+ * Has to be called when blocks are written behind the cache's back.
+ *
+ * @dev device handle
+ * @start first block to drop
+ * @count number of blocks to drop
+ */
+void blockcache_invalidate(const void *const dev,
+			   const lba_t start, const size_t count)
+{
+	size_t i;
+
+	if (!cache.count)
+		return;
+
+	for (i = 0; i < count; ++i) {
+		struct entry *const e = lookup(dev, start + i);
+		if (e)
+			drop(e);
+	}
+}
+
+/**
+ * Drop all cached blocks of a device
+ *
+ * Has to be called when a device is detached, as the handle may be
+ * reused for another one.
+ *
+ * @dev device handle
+ */
+void blockcache_invalidate_dev(const void *const dev)
+{
+	size_t i;
+
+	for (i = 0; i < cache.count; ++i)
+		if (cache.entries[i].dev == dev)
+			drop(&cache.entries[i]);
+	for (i = 0; i < STREAMS; ++i)
+		if (cache.streams[i].dev == dev)
+			cache.streams[i].dev = NULL;
+}
+
+void blockcache_get_stats(struct blockcache_stats *const stats)
+{
+	*stats = cache.stats;
+}
+
+void blockcache_reset_stats(void)
+{
+	const size_t budget = cache.stats.budget;
+
+	memset(&cache.stats, 0, sizeof(cache.stats));
+	cache.stats.budget = budget;
+}
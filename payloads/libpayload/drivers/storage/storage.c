@@ -32,6 +32,9 @@
 # include <storage/ahci.h>
 #endif
 #include <storage/storage.h>
+#ifdef CONFIG_LP_STORAGE_BLOCKCACHE
+# include <storage/blockcache.h>
+#endif
 
 
 static storage_dev_t **devices = NULL;
@@ -84,22 +87,180 @@ storage_poll_t storage_probe(const size_t dev_num)
  * Read 512-byte blocks
  *
  * Reads count blocks of 512 bytes from block start of drive dev_num
- * into buf.
+ * into buf. With CONFIG_LP_STORAGE_BLOCKCACHE reads go through the
+ * block cache.
  *
  * @dev_num device number counted from 0
  * @start number of first block to read from
  * @count number of blocks to read
  * @buf buffer where the read data should be written
  */
+#ifdef CONFIG_LP_STORAGE_BLOCKCACHE
+static ssize_t storage_read_uncached(void *const dev,
+				     const lba_t start, const size_t count,
+				     unsigned char *const buf)
+{
+	storage_dev_t *const sdev = dev;
+
+	return sdev->read_blocks512(sdev, start, count, buf);
+}
+#endif
+
 ssize_t storage_read_blocks512(const size_t dev_num,
 			       const lba_t start, const size_t count,
 			       unsigned char *const buf)
 {
 	if ((dev_num < dev_count) && devices[dev_num]->read_blocks512)
+#ifdef CONFIG_LP_STORAGE_BLOCKCACHE
+		return blockcache_read(devices[dev_num], storage_read_uncached,
+				       start, count, buf);
+#else
 		return devices[dev_num]->read_blocks512(
 				devices[dev_num], start, count, buf);
+#endif
+	else
+		return -1;
+}
+
+/**
+ * Write 512-byte blocks
+ *
+ * Writes count blocks of 512 bytes from buf to block start of drive
+ * dev_num. With CONFIG_LP_STORAGE_BLOCKCACHE the written range is
+ * dropped from the block cache, even if the write failed part way.
+ *
+ * @dev_num device number counted from 0
+ * @start number of first block to write to
+ * @count number of blocks to write
+ * @buf buffer holding the data to write
+ * @return number of blocks written or -1 on error
+ */
+ssize_t storage_write_blocks512(const size_t dev_num,
+				const lba_t start, const size_t count,
+				const unsigned char *const buf)
+{
+	if ((dev_num >= dev_count) || !devices[dev_num]->write_blocks512)
+		return -1;
+
+	const ssize_t ret = devices[dev_num]->write_blocks512(
+			devices[dev_num], start, count, buf);
+#ifdef CONFIG_LP_STORAGE_BLOCKCACHE
+	blockcache_invalidate(devices[dev_num], start, count);
+#endif
+	return ret;
+}
+
+/**
+ * Finish a request
+ *
+ * Called by drivers to record the result of a request and to notify
+ * the submitter.
+ *
+ * @req the finished request
+ * @result number of blocks read or -1 on error
+ */
+void storage_complete_request(storage_req_t *const req, const ssize_t result)
+{
+	req->result = result;
+	req->status = (result < 0) ? REQ_ERROR : REQ_DONE;
+	if (req->complete)
+		req->complete(req);
+}
+
+/**
+ * Submit an asynchronous read of 512-byte blocks
+ *
+ * Queues req on drive dev_num. Devices without an asynchronous interface
+ * execute the read immediately and complete the request before returning.
+ * So does a read that is entirely in the block cache. Other reads go to
+ * the device and don't fill the cache.
+ *
+ * @dev_num device number counted from 0
+ * @req the request, start, count and buf have to be set
+ * @return 0 if queued, 1 if the device queue is full, -1 on error
+ */
+int storage_submit_read_blocks512(const size_t dev_num,
+				  storage_req_t *const req)
+{
+	if (dev_num >= dev_count)
+		return -1;
+
+	storage_dev_t *const dev = devices[dev_num];
+	req->status = REQ_PENDING;
+	req->result = 0;
+#ifdef CONFIG_LP_STORAGE_BLOCKCACHE
+	if (blockcache_read_cached(dev, req->start, req->count, req->buf)) {
+		storage_complete_request(req, req->count);
+		return 0;
+	}
+#endif
+	if (dev->submit_read_blocks512)
+		return dev->submit_read_blocks512(dev, req);
+
+	if (!dev->read_blocks512)
+		return -1;
+	storage_complete_request(req, dev->read_blocks512(
+			dev, req->start, req->count, req->buf));
+	return 0;
+}
+
+/**
+ * Complete finished asynchronous requests
+ *
+ * @dev_num device number counted from 0
+ * @return number of requests still in flight or -1 on error
+ */
+int storage_process_requests(const size_t dev_num)
+{
+	if (dev_num >= dev_count)
+		return -1;
+	else if (devices[dev_num]->process_requests)
+		return devices[dev_num]->process_requests(devices[dev_num]);
 	else
+		return 0;
+}
+
+/**
+ * Read a vector of 512-byte block ranges
+ *
+ * Submits all requests, keeping the device queue as full as possible,
+ * and waits for all of them to complete.
+ *
+ * @dev_num device number counted from 0
+ * @reqs array of requests, start, count and buf have to be set
+ * @count number of requests
+ * @return total number of blocks read or -1 if any request failed
+ */
+ssize_t storage_read_blocks512_vec(const size_t dev_num,
+				   storage_req_t *const reqs,
+				   const size_t count)
+{
+	size_t i;
+	ssize_t total = 0;
+
+	for (i = 0; i < count; ++i) {
+		int ret;
+		while ((ret = storage_submit_read_blocks512(
+					dev_num, &reqs[i])) == 1) {
+			if (storage_process_requests(dev_num) < 0)
+				return -1;
+		}
+		if (ret < 0)
+			storage_complete_request(&reqs[i], -1);
+	}
+
+	int pending;
+	while ((pending = storage_process_requests(dev_num)) > 0)
+		;
+	if (pending < 0)
 		return -1;
+
+	for (i = 0; i < count; ++i) {
+		if (reqs[i].status != REQ_DONE)
+			return -1;
+		total += reqs[i].result;
+	}
+	return total;
 }
 
 /**
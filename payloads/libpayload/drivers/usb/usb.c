@@ -34,6 +34,10 @@
 
 #define DR_DESC gen_bmRequestType(device_to_host, standard_type, dev_recp)
 
+/* Devices without interrupt-in endpoints, like root hubs, are polled at
+   this rate. So are those whose endpoints have intervals over 128ms. */
+#define USB_POLL_INTERVAL_US	10000
+
 hci_t *usb_hcs = 0;
 
 hci_t *
@@ -80,7 +84,9 @@ usb_exit (void)
 }
 
 /**
- * Polls all hubs on all USB controllers, to find out about device changes
+ * Polls all devices on all USB controllers that are due, to find out about
+ * device changes and to fetch input. Each device is polled at most once
+ * per poll_interval, which is derived from its interrupt endpoints.
  */
 void
 usb_poll (void)
@@ -91,14 +97,49 @@ usb_poll (void)
 	while (controller != NULL) {
 		int i;
 		for (i = 0; i < 128; i++) {
-			if (controller->devices[i] != 0) {
-				controller->devices[i]->poll (controller->devices[i]);
-			}
+			usbdev_t *const dev = controller->devices[i];
+			if (dev == 0)
+				continue;
+			const u64 now = timer_us(0);
+			if (now < dev->next_poll)
+				continue;
+			dev->poll (dev);
+			/* poll() may have detached the device */
+			if (controller->devices[i] == dev)
+				dev->next_poll = now + dev->poll_interval;
 		}
 		controller = controller->next;
 	}
 }
 
+/**
+ * Returns the time until usb_poll() has work to do, in microseconds
+ *
+ * Idle loops can sleep this long before calling usb_poll() again.
+ * Returns 0 if a device is due already and ~0ULL if there are none.
+ */
+u64
+usb_poll_timeout_us (void)
+{
+	u64 timeout = ~0ULL;
+	const u64 now = timer_us(0);
+	hci_t *controller;
+
+	for (controller = usb_hcs; controller; controller = controller->next) {
+		int i;
+		for (i = 0; i < 128; i++) {
+			const usbdev_t *const dev = controller->devices[i];
+			if (dev == 0)
+				continue;
+			if (dev->next_poll <= now)
+				return 0;
+			if (dev->next_poll - now < timeout)
+				timeout = dev->next_poll - now;
+		}
+	}
+	return timeout;
+}
+
 usbdev_t *
 init_device_entry (hci_t *controller, int i)
 {
@@ -116,6 +157,7 @@ init_device_entry (hci_t *controller, int i)
 	dev->port = -1;
 	dev->init = usb_nop_init;
 	dev->init (controller->devices[i]);
+	dev->poll_interval = USB_POLL_INTERVAL_US;
 	return dev;
 }
 
@@ -461,6 +503,7 @@ set_address (hci_t *controller, usb_speed speed, int hubport, int hubaddr)
 	}
 
 	/* Gather up all endpoints belonging to this inteface */
+	unsigned int interval = ~0U;
 	dev->num_endp = 1;
 	for (; ptr + 2 <= end && ptr[0] && ptr + ptr[0] <= end; ptr += ptr[0]) {
 		if (ptr[1] == DT_INTF || ptr[1] == DT_CFG ||
@@ -488,7 +531,12 @@ set_address (hci_t *controller, usb_speed speed, int hubport, int hubaddr)
 		ep->type = desc->bmAttributes & 0x3;
 		ep->interval = usb_decode_interval (dev->speed, ep->type,
 						    desc->bInterval);
+		if (ep->type == INTERRUPT && ep->direction == IN &&
+				ep->interval <= 10)
+			interval = MIN(interval, 125U << ep->interval);
 	}
+	if (interval != ~0U)
+		dev->poll_interval = interval;
 
 	if ((controller->finish_device_config &&
 			controller->finish_device_config(dev)) ||
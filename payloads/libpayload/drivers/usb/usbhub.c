@@ -45,6 +45,36 @@
 /* request type (USB 3.0 hubs only) */
 #define SET_HUB_DEPTH 12
 
+typedef struct {
+	endpoint_t *ep;		/* status change endpoint */
+	void *queue;		/* interrupt queue on it, if we have one */
+	int rescan;		/* scan all ports on next poll */
+} usb_hub_t;
+
+#define USB_HUB(usbdev) ((usb_hub_t *)GEN_HUB(usbdev)->data)
+
+/*
+ * The hub reports on its status change endpoint whenever a change bit
+ * is set. If we listen there, we don't have to query every port on
+ * every poll.
+ */
+static int
+usb_hub_status_changed(usbdev_t *const dev)
+{
+	usb_hub_t *const uhub = USB_HUB(dev);
+	int changed = 0;
+
+	if (!uhub || !uhub->queue || uhub->rescan) {
+		if (uhub)
+			uhub->rescan = 0;
+		return 1;
+	}
+
+	while (dev->controller->poll_intr_queue(uhub->queue))
+		changed = 1;
+	return changed;
+}
+
 static int
 usb_hub_port_status_changed(usbdev_t *const dev, const int port)
 {
@@ -146,7 +176,7 @@ static void usb_hub_set_hub_depth(usbdev_t *const dev)
 }
 
 static const generic_hub_ops_t usb_hub_ops = {
-	.hub_status_changed	= NULL,
+	.hub_status_changed	= usb_hub_status_changed,
 	.port_status_changed	= usb_hub_port_status_changed,
 	.port_connected		= usb_hub_port_connected,
 	.port_in_reset		= usb_hub_port_in_reset,
@@ -158,6 +188,52 @@ static const generic_hub_ops_t usb_hub_ops = {
 	.reset_port		= generic_hub_resetport,
 };
 
+static void
+usb_hub_destroy(usbdev_t *const dev)
+{
+	usb_hub_t *const uhub = GEN_HUB(dev) ? USB_HUB(dev) : NULL;
+
+	generic_hub_destroy(dev);
+	if (uhub) {
+		if (uhub->queue)
+			dev->controller->destroy_intr_queue(uhub->ep,
+							    uhub->queue);
+		free(uhub);
+	}
+}
+
+static void
+usb_hub_init_status_queue(usbdev_t *const dev, const int num_ports)
+{
+	usb_hub_t *uhub;
+	int i;
+
+	dev->destroy = usb_hub_destroy;
+	uhub = xzalloc(sizeof(*uhub));
+	uhub->rescan = 1;
+	GEN_HUB(dev)->data = uhub;
+
+	if (!dev->controller->create_intr_queue)
+		return;
+	for (i = 1; i < dev->num_endp; i++) {
+		if (dev->endpoints[i].type == INTERRUPT &&
+				dev->endpoints[i].direction == IN)
+			break;
+	}
+	if (i >= dev->num_endp)
+		return;
+
+	/* One bit for the hub and one per port, polled every 1..32ms */
+	const int reqsize = (num_ports + 1 + 7) / 8;
+	const int frames = (1 << dev->endpoints[i].interval) / 8;
+	const int reqtiming = frames < 1 ? 1 : MIN(frames, 32);
+	uhub->ep = &dev->endpoints[i];
+	uhub->queue = dev->controller->create_intr_queue(
+			uhub->ep, reqsize, 4, reqtiming);
+	if (!uhub->queue)
+		usb_debug("usbhub: No status change queue, polling ports\n");
+}
+
 void
 usb_hub_init(usbdev_t *const dev)
 {
@@ -172,5 +248,7 @@ usb_hub_init(usbdev_t *const dev)
 
 	if (dev->speed == SUPER_SPEED)
 		usb_hub_set_hub_depth(dev);
-	generic_hub_init(dev, desc.bNbrPorts, &usb_hub_ops);
+	if (generic_hub_init(dev, desc.bNbrPorts, &usb_hub_ops) < 0)
+		return;
+	usb_hub_init_status_queue(dev, desc.bNbrPorts);
 }
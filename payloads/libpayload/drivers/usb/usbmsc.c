@@ -32,6 +32,9 @@
 #include <usb/usb.h>
 #include <usb/usbmsc.h>
 #include <usb/usbdisk.h>
+#ifdef CONFIG_LP_STORAGE_BLOCKCACHE
+#include <storage/blockcache.h>
+#endif
 
 enum {
 	msc_subclass_rbc = 0x1,
@@ -88,6 +91,9 @@ usb_msc_destroy (usbdev_t *dev)
 {
 	if (dev->data) {
 		usb_msc_remove_disk (dev);
+#ifdef CONFIG_LP_STORAGE_BLOCKCACHE
+		blockcache_invalidate_dev (dev);
+#endif
 		free (dev->data);
 	}
 	dev->data = 0;
@@ -309,6 +315,26 @@ typedef struct {
 	unsigned char control;	//5
 } __attribute__ ((packed)) cmdblock6_t;
 
+static int
+readwrite_blocks_512_uncached (usbdev_t *dev, int start, int n,
+	cbw_direction dir, u8 *buf)
+{
+	int blocksize_divider = MSC_INST(dev)->blocksize / 512;
+	return readwrite_blocks (dev, start / blocksize_divider,
+		n / blocksize_divider, dir, buf);
+}
+
+#ifdef CONFIG_LP_STORAGE_BLOCKCACHE
+static ssize_t
+read_blocks_512_uncached (void *dev, lba_t start, size_t n, unsigned char *buf)
+{
+	if (readwrite_blocks_512_uncached (dev, start, n,
+					   cbw_direction_data_in, buf))
+		return -1;
+	return n;
+}
+#endif
+
 /**
  * Like readwrite_blocks, but for soft-sectors of 512b size. Converts the
  * start and count from 512b units.
@@ -326,9 +352,14 @@ int
 readwrite_blocks_512 (usbdev_t *dev, int start, int n,
 	cbw_direction dir, u8 *buf)
 {
-	int blocksize_divider = MSC_INST(dev)->blocksize / 512;
-	return readwrite_blocks (dev, start / blocksize_divider,
-		n / blocksize_divider, dir, buf);
+#ifdef CONFIG_LP_STORAGE_BLOCKCACHE
+	/* The cache works on single 512b blocks, which only fits
+	   devices with 512b sectors. */
+	if (dir == cbw_direction_data_in && MSC_INST(dev)->blocksize == 512)
+		return blockcache_read (dev, read_blocks_512_uncached,
+					start, n, buf) != n;
+#endif
+	return readwrite_blocks_512_uncached (dev, start, n, dir, buf);
 }
 
 /**
@@ -385,6 +416,14 @@ readwrite_blocks (usbdev_t *dev, int start, int n, cbw_direction dir, u8 *buf)
 	int chunk_size = MAX_CHUNK_BYTES / MSC_INST(dev)->blocksize;
 	int chunk;
 
+#ifdef CONFIG_LP_STORAGE_BLOCKCACHE
+	if (dir == cbw_direction_data_out) {
+		int blocksize_multiplier = MSC_INST(dev)->blocksize / 512;
+		blockcache_invalidate (dev, start * blocksize_multiplier,
+				       n * blocksize_multiplier);
+	}
+#endif
+
 	/* Read as many full chunks as needed. */
 	for (chunk = 0; chunk < (n / chunk_size); chunk++) {
 		if (readwrite_chunk (dev, start + (chunk * chunk_size),
@@ -285,6 +285,7 @@ void raw_write_far(uint64_t far, uint32_t el);
 uint64_t raw_read_hcr_el2(void);
 void raw_write_hcr_el2(uint64_t hcr_el2);
 uint64_t raw_read_aa64pfr0_el1(void);
+uint64_t raw_read_aa64isar0_el1(void);
 uint64_t raw_read_mair_el1(void);
 void raw_write_mair_el1(uint64_t mair_el1);
 uint64_t raw_read_mair_el2(void);
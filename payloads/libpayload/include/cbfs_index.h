@@ -0,0 +1,59 @@
+/*
+ * This file is part of the libpayload project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _CBFS_INDEX_H_
+#define _CBFS_INDEX_H_
+
+#include <stddef.h>
+#include <cbfs_core.h>
+
+/*
+ * A CBFS index walks the file chain once and keeps a hashed directory of
+ * all files, so lookups don't have to scan the media again. File data is
+ * handed out as pointers that stay valid until the index is destroyed:
+ * on memory-mapped media they point into the mapping, otherwise into a
+ * copy the index reads on first use.
+ */
+
+struct cbfs_index;
+
+/* media->map() returns pointers that stay valid, never copy file data. */
+#define CBFS_INDEX_MAPPED	(1 << 0)
+
+struct cbfs_index *cbfs_index_create(struct cbfs_media *media, int flags);
+void cbfs_index_destroy(struct cbfs_index *index);
+
+struct cbfs_file *cbfs_index_get_file(struct cbfs_index *index,
+				      const char *name);
+void *cbfs_index_get_file_content(struct cbfs_index *index, const char *name,
+				  int type, size_t *size);
+int cbfs_index_prefetch(struct cbfs_index *index, const char *const names[],
+			size_t count);
+
+#endif  /* _CBFS_INDEX_H_ */
@@ -203,6 +203,8 @@ struct cb_range {
 #define CB_TAG_ACPI_GNVS	0x0024
 #define CB_TAG_WIFI_CALIBRATION	0x0027
 #define CB_TAG_MTC		0x002b
+#define CB_TAG_VPD		0x002c
+#define CB_TAG_VPD_INDEX	0x0031
 struct cb_cbmem_tab {
 	uint32_t tag;
 	uint32_t size;
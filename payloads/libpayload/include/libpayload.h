@@ -386,6 +386,19 @@ void SHA1Update(SHA1_CTX *context, const u8 *data, size_t len);
 void SHA1Pad(SHA1_CTX *context);
 void SHA1Final(u8 digest[SHA1_DIGEST_LENGTH], SHA1_CTX *context);
 u8 *sha1(const u8 *data, size_t len, u8 *buf);
+
+#define SHA256_BLOCK_LENGTH	64
+#define SHA256_DIGEST_LENGTH	32
+typedef struct {
+	u32 state[8];
+	u64 count;
+	u8 buffer[SHA256_BLOCK_LENGTH];
+} SHA256_CTX;
+void SHA256Init(SHA256_CTX *context);
+void SHA256Transform(u32 state[8], const u8 buffer[SHA256_BLOCK_LENGTH]);
+void SHA256Update(SHA256_CTX *context, const u8 *data, size_t len);
+void SHA256Final(u8 digest[SHA256_DIGEST_LENGTH], SHA256_CTX *context);
+u8 *sha256(const u8 *data, size_t len, u8 *buf);
 /** @} */
 
 /**
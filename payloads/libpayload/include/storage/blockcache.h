@@ -0,0 +1,66 @@
+/*
+ * This file is part of the libpayload project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _STORAGE_BLOCKCACHE_H
+#define _STORAGE_BLOCKCACHE_H
+
+#include <stdint.h>
+#include <unistd.h>
+
+#include "storage.h"
+
+/*
+ * LRU cache of 512-byte blocks keyed by (device, LBA). The device is an
+ * opaque pointer, the actual read is done by the given callback which has
+ * to return the number of blocks read or -1 on error.
+ */
+
+typedef ssize_t (*blockcache_read_t)(void *dev, lba_t start, size_t count,
+				     unsigned char *buf);
+
+struct blockcache_stats {
+	u32 hits;		/* blocks served from the cache */
+	u32 misses;		/* blocks read from the device on request */
+	u32 readahead;		/* blocks read from the device speculatively */
+	u32 bypassed;		/* blocks of requests too large to cache */
+	u32 evictions;		/* blocks dropped to make room */
+	size_t budget;		/* memory in use by the cache (bytes) */
+};
+
+int blockcache_set_budget(size_t bytes);
+ssize_t blockcache_read(void *dev, blockcache_read_t read,
+			lba_t start, size_t count, unsigned char *buf);
+int blockcache_read_cached(const void *dev, lba_t start, size_t count,
+			   unsigned char *buf);
+void blockcache_invalidate(const void *dev, lba_t start, size_t count);
+void blockcache_invalidate_dev(const void *dev);
+void blockcache_get_stats(struct blockcache_stats *stats);
+void blockcache_reset_stats(void);
+
+#endif
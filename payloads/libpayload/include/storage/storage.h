@@ -56,23 +56,66 @@ typedef enum {
 } storage_poll_t;
 
 
+typedef enum {
+	REQ_ERROR		= -1,
+	REQ_PENDING		=  0,
+	REQ_DONE		=  1,
+} storage_req_status_t;
+
+/*
+ * An asynchronous read request of 512-byte blocks. The submitter fills
+ * in start, count and buf (and optionally complete/data), the driver
+ * sets status and result (number of blocks read or -1) on completion.
+ */
+struct storage_req;
+typedef struct storage_req {
+	lba_t start;
+	size_t count;
+	unsigned char *buf;
+
+	volatile storage_req_status_t status;
+	ssize_t result;
+
+	void (*complete)(struct storage_req *);
+	void *data;
+} storage_req_t;
+
 struct storage_dev;
 
 typedef struct storage_dev {
 	storage_port_t port_type;
 
 	storage_poll_t (*poll)(struct storage_dev *);
+	/*
+	 * Use storage_read_blocks512() and storage_write_blocks512()
+	 * rather than calling these directly, they keep the block cache
+	 * coherent.
+	 */
 	ssize_t (*read_blocks512)(struct storage_dev *, lba_t start, size_t count, unsigned char *buf);
 	ssize_t (*write_blocks512)(struct storage_dev *, lba_t start, size_t count, const unsigned char *buf);
 
+	/*
+	 * Optional asynchronous interface. submit_read_blocks512() returns
+	 * 0 if the request was queued, 1 if the device queue is full and
+	 * -1 on error. process_requests() completes finished requests and
+	 * returns the number of requests still in flight.
+	 */
+	int (*submit_read_blocks512)(struct storage_dev *, storage_req_t *req);
+	int (*process_requests)(struct storage_dev *);
+
 	void (*detach_device)(struct storage_dev *);
 } storage_dev_t;
 
 int storage_device_count(void);
 int storage_attach_device(storage_dev_t *dev);
+void storage_complete_request(storage_req_t *req, ssize_t result);
 
 
 storage_poll_t storage_probe(size_t dev_num);
 ssize_t storage_read_blocks512(size_t dev_num, lba_t start, size_t count, unsigned char *buf);
+ssize_t storage_write_blocks512(size_t dev_num, lba_t start, size_t count, const unsigned char *buf);
+int storage_submit_read_blocks512(size_t dev_num, storage_req_t *req);
+int storage_process_requests(size_t dev_num);
+ssize_t storage_read_blocks512_vec(size_t dev_num, storage_req_t *reqs, size_t count);
 
 #endif
@@ -127,6 +127,8 @@ struct sysinfo_t {
 	uint32_t cbfs_header_offset;
 	uint64_t mtc_start;
 	uint32_t mtc_size;
+	void	*vpd;
+	void	*vpd_index;
 };
 
 extern struct sysinfo_t lib_sysinfo;
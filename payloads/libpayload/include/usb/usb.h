@@ -205,6 +205,8 @@ struct usbdev {
 	void (*init) (usbdev_t *dev);
 	void (*destroy) (usbdev_t *dev);
 	void (*poll) (usbdev_t *dev);
+	u64 next_poll;		// timer_us() value when poll() is due
+	u32 poll_interval;	// time between poll() calls in microseconds
 };
 
 typedef enum { OHCI = 0, UHCI = 1, EHCI = 2, XHCI = 3, DWC2 = 4} hc_type;
@@ -259,6 +261,7 @@ hci_t *usb_add_mmio_hc(hc_type type, void *bar);
 hci_t *new_controller (void);
 void detach_controller (hci_t *controller);
 void usb_poll (void);
+u64 usb_poll_timeout_us (void);
 usbdev_t *init_device_entry (hci_t *controller, int num);
 
 int usb_decode_mps0 (usb_speed speed, u8 bMaxPacketSize0);
@@ -0,0 +1,84 @@
+/*
+ * This file is part of the libpayload project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _VPD_H_
+#define _VPD_H_
+
+#include <stdint.h>
+
+/*
+ * The ChromeOS VPD as coreboot leaves it in CBMEM, see
+ * src/vendorcode/google/chromeos/cros_vpd.h in coreboot. lib_sysinfo.vpd
+ * points at a struct vpd_cbmem and lib_sysinfo.vpd_index, if coreboot
+ * built one, at a struct vpd_index.
+ */
+#define VPD_CBMEM_MAGIC		0x43524f53
+#define VPD_INDEX_MAGIC		0x56504449
+
+/* The index hashes keys with 32-bit FNV-1a. */
+#define VPD_INDEX_HASH_INIT	2166136261u
+#define VPD_INDEX_HASH_PRIME	16777619u
+
+struct vpd_cbmem {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t ro_size;
+	uint32_t rw_size;
+	/* RO data (0 .. ro_size), then RW (ro_size .. ro_size + rw_size) */
+	uint8_t blob[0];
+};
+
+/*
+ * The RO VPD strings, sorted by key hash and, for equal hashes, by
+ * position in the blob. The first match is the one that comes first in
+ * the VPD.
+ */
+struct vpd_index_entry {
+	uint32_t hash;		/* FNV-1a of the key */
+	uint32_t key;		/* offsets into the blob */
+	uint32_t value;
+	uint32_t key_len;
+	uint32_t value_len;
+};
+
+struct vpd_index {
+	uint32_t magic;
+	uint32_t count;
+	struct vpd_index_entry entries[0];
+};
+
+/*
+ * Find an RO VPD string by key through the index coreboot passed in the
+ * coreboot table. Returns a pointer to the value, which is not
+ * terminated, and stores its length in *size. Returns NULL if the key is
+ * not there, or if there is no VPD or no index.
+ */
+const void *vpd_find(const char *key, int *size);
+
+#endif
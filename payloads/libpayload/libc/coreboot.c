@@ -195,6 +195,18 @@ static void cb_parse_wifi_calibration(void *ptr, struct sysinfo_t *info)
 	info->wifi_calibration = phys_to_virt(cbmem->cbmem_tab);
 }
 
+static void cb_parse_vpd(void *ptr, struct sysinfo_t *info)
+{
+	struct cb_cbmem_tab *const cbmem = (struct cb_cbmem_tab *)ptr;
+	info->vpd = phys_to_virt(cbmem->cbmem_tab);
+}
+
+static void cb_parse_vpd_index(void *ptr, struct sysinfo_t *info)
+{
+	struct cb_cbmem_tab *const cbmem = (struct cb_cbmem_tab *)ptr;
+	info->vpd_index = phys_to_virt(cbmem->cbmem_tab);
+}
+
 static void cb_parse_ramoops(void *ptr, struct sysinfo_t *info)
 {
 	struct cb_range *ramoops = (struct cb_range *)ptr;
@@ -384,6 +396,12 @@ int cb_parse_header(void *addr, int len, struct sysinfo_t *info)
 		case CB_TAG_MTC:
 			cb_parse_mtc(ptr, info);
 			break;
+		case CB_TAG_VPD:
+			cb_parse_vpd(ptr, info);
+			break;
+		case CB_TAG_VPD_INDEX:
+			cb_parse_vpd_index(ptr, info);
+			break;
 		case CB_TAG_BOOT_MEDIA_PARAMS:
 			cb_parse_boot_media_params(ptr, info);
 			break;
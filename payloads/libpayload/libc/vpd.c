@@ -0,0 +1,79 @@
+/*
+ * This file is part of the libpayload project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <libpayload.h>
+#include <vpd.h>
+
+static uint32_t vpd_key_hash(const char *key, size_t key_len)
+{
+	uint32_t hash = VPD_INDEX_HASH_INIT;
+
+	while (key_len--) {
+		hash ^= (uint8_t)*key++;
+		hash *= VPD_INDEX_HASH_PRIME;
+	}
+	return hash;
+}
+
+const void *vpd_find(const char *key, int *size)
+{
+	const struct vpd_cbmem *vpd = lib_sysinfo.vpd;
+	const struct vpd_index *index = lib_sysinfo.vpd_index;
+	const struct vpd_index_entry *e;
+	const size_t key_len = strlen(key);
+	const uint32_t hash = vpd_key_hash(key, key_len);
+	uint32_t lo = 0, hi, mid;
+
+	if (!vpd || vpd->magic != VPD_CBMEM_MAGIC ||
+	    !index || index->magic != VPD_INDEX_MAGIC)
+		return NULL;
+
+	/* Binary search for the first entry with the key's hash. */
+	hi = index->count;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (index->entries[mid].hash < hash)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (e = &index->entries[lo];
+	     e < &index->entries[index->count] && e->hash == hash; e++) {
+		if (e->key_len != key_len || key_len > vpd->ro_size ||
+		    e->key > vpd->ro_size - key_len ||
+		    e->value > vpd->ro_size ||
+		    e->value_len > vpd->ro_size - e->value ||
+		    memcmp(vpd->blob + e->key, key, key_len))
+			continue;
+		*size = e->value_len;
+		return vpd->blob + e->value;
+	}
+	return NULL;
+}
@@ -0,0 +1,459 @@
+/*
+ * This file is part of the libpayload project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <libpayload-config.h>
+#include <cbfs.h>
+#include <cbfs_index.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysinfo.h>
+
+/* Files closer together than this are read with a single request. */
+#define PREFETCH_MERGE_GAP	4096
+
+struct entry {
+	char *name;
+	uint32_t hash;
+	uint32_t offset;		/* of the file header on the media */
+	uint32_t data_offset;		/* file data, relative to the header */
+	uint32_t len;
+	uint32_t type;
+	struct cbfs_file *file;		/* header and data, NULL if not loaded */
+	struct entry *hnext;
+};
+
+/* Memory holding copies of one or more files. */
+struct chunk {
+	struct chunk *next;
+	uint8_t data[0];
+};
+
+struct cbfs_index {
+	struct cbfs_media media;
+	int flags;
+
+	struct entry *entries;
+	size_t count;
+
+	struct entry **hash;
+	size_t hash_mask;
+
+	struct chunk *chunks;
+};
+
+static uint32_t hash_name(const char *name)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*name)
+		hash = (hash ^ (uint8_t)*name++) * 16777619;
+	return hash;
+}
+
+static struct entry *lookup(struct cbfs_index *index, const char *name)
+{
+	const uint32_t hash = hash_name(name);
+	struct entry *e;
+
+	for (e = index->hash[hash & index->hash_mask]; e; e = e->hnext)
+		if (e->hash == hash && !strcmp(e->name, name))
+			return e;
+	return NULL;
+}
+
+static void *alloc_chunk(struct cbfs_index *index, size_t size)
+{
+	struct chunk *chunk = malloc(sizeof(*chunk) + size);
+
+	if (!chunk)
+		return NULL;
+	chunk->next = index->chunks;
+	index->chunks = chunk;
+	return chunk->data;
+}
+
+static int read_header(struct cbfs_media *media, int is_default,
+		       struct cbfs_header *header)
+{
+	const struct cbfs_header *mapped;
+
+	/* Avoid the trip to the end of the image if coreboot told us. */
+	if (is_default && lib_sysinfo.cbfs_header_offset) {
+		media->open(media);
+		const size_t got = media->read(media, header,
+					       lib_sysinfo.cbfs_header_offset,
+					       sizeof(*header));
+		media->close(media);
+		if (got == sizeof(*header) &&
+		    ntohl(header->magic) == CBFS_HEADER_MAGIC)
+			return 0;
+	}
+
+	mapped = cbfs_get_header(media);
+	if (mapped == CBFS_HEADER_INVALID_ADDRESS)
+		return -1;
+	memcpy(header, mapped, sizeof(*header));
+	return 0;
+}
+
+static int add_entry(struct cbfs_index *index, size_t *allocated,
+		     const struct entry *e)
+{
+	if (index->count == *allocated) {
+		const size_t n = *allocated ? *allocated * 2 : 64;
+		struct entry *entries = realloc(index->entries,
+						n * sizeof(*entries));
+		if (!entries)
+			return -1;
+		index->entries = entries;
+		*allocated = n;
+	}
+	index->entries[index->count++] = *e;
+	return 0;
+}
+
+static int scan(struct cbfs_index *index, const struct cbfs_header *header)
+{
+	struct cbfs_media *const media = &index->media;
+	uint32_t offset, align, romsize;
+	size_t allocated = 0;
+	struct cbfs_file file;
+
+	offset = ntohl(header->offset);
+	align = ntohl(header->align);
+	romsize = ntohl(header->romsize);
+	if (!align)
+		return -1;
+
+	/* Same end of CBFS data as in cbfs_locate_file(). */
+#if defined(CONFIG_LP_ARCH_X86) && CONFIG_LP_ARCH_X86
+	romsize -= ntohl(header->bootblocksize);
+	if ((ntohl(header->bootblocksize) % align))
+		romsize -= (align - (ntohl(header->bootblocksize) % align));
+	else
+		romsize -= 1;
+#endif
+
+	media->open(media);
+	while (offset < romsize &&
+	       media->read(media, &file, offset, sizeof(file)) ==
+	       sizeof(file)) {
+		struct entry e;
+
+		if (memcmp(CBFS_FILE_MAGIC, file.magic, sizeof(file.magic))) {
+			offset += align - (offset % align);
+			continue;
+		}
+
+		e.offset = offset;
+		e.data_offset = ntohl(file.offset);
+		e.len = ntohl(file.len);
+		e.type = ntohl(file.type);
+		e.file = NULL;
+		e.hnext = NULL;
+
+		/* A header that overlaps its own name can't be trusted to
+		 * find the next one either; resync on the alignment. */
+		if (e.data_offset < sizeof(file)) {
+			printf("ERROR: cbfs_index: bad data offset at %#x.\n",
+			       offset);
+			offset += align - (offset % align);
+			continue;
+		}
+
+		/* A length past the end would wrap offset and restart the
+		 * scan further up; stop at the first one. */
+		if (e.data_offset > romsize - offset ||
+		    e.len > romsize - offset - e.data_offset) {
+			printf("ERROR: cbfs_index: bad length at %#x.\n",
+			       offset);
+			break;
+		}
+
+		const size_t name_len = e.data_offset - sizeof(file);
+		e.name = malloc(name_len + 1);
+		if (!e.name) {
+			media->close(media);
+			return -1;
+		}
+		if (media->read(media, e.name, offset + sizeof(file),
+				name_len) != name_len) {
+			free(e.name);
+			break;
+		}
+		e.name[name_len] = '\0';
+
+		if (!e.name[0] || add_entry(index, &allocated, &e))
+			free(e.name);
+
+		offset += e.data_offset + e.len;
+		if (offset % align)
+			offset += align - (offset % align);
+	}
+	media->close(media);
+
+	return 0;
+}
+
+static int build_hash(struct cbfs_index *index)
+{
+	size_t buckets, i;
+
+	for (buckets = 1; buckets < index->count; buckets <<= 1)
+		;
+	index->hash = calloc(buckets, sizeof(*index->hash));
+	if (!index->hash)
+		return -1;
+	index->hash_mask = buckets - 1;
+
+	for (i = 0; i < index->count; i++) {
+		struct entry *const e = &index->entries[i];
+		struct entry **p;
+
+		e->hash = hash_name(e->name);
+		/* Like a linear scan, the first file of a name wins. */
+		if (lookup(index, e->name))
+			continue;
+		for (p = &index->hash[e->hash & index->hash_mask]; *p;
+		     p = &(*p)->hnext)
+			;
+		*p = e;
+	}
+	return 0;
+}
+
+/**
+ * Build an index of all files in a CBFS
+ *
+ * @media media to index, or CBFS_DEFAULT_MEDIA
+ * @flags CBFS_INDEX_MAPPED if the media is memory-mapped
+ * @return the index, or NULL on error
+ */
+struct cbfs_index *cbfs_index_create(struct cbfs_media *media, int flags)
+{
+	struct cbfs_header header;
+	struct cbfs_index *index;
+
+	index = calloc(1, sizeof(*index));
+	if (!index)
+		return NULL;
+
+	if (media == CBFS_DEFAULT_MEDIA) {
+		if (init_default_cbfs_media(&index->media)) {
+			printf("ERROR: cbfs_index: no default media.\n");
+			free(index);
+			return NULL;
+		}
+	} else {
+		index->media = *media;
+	}
+	index->flags = flags;
+
+	if (read_header(&index->media, media == CBFS_DEFAULT_MEDIA, &header) ||
+	    scan(index, &header) || build_hash(index)) {
+		printf("ERROR: cbfs_index: couldn't index CBFS.\n");
+		cbfs_index_destroy(index);
+		return NULL;
+	}
+
+	return index;
+}
+
+void cbfs_index_destroy(struct cbfs_index *index)
+{
+	size_t i;
+
+	if (!index)
+		return;
+
+	while (index->chunks) {
+		struct chunk *const next = index->chunks->next;
+		free(index->chunks);
+		index->chunks = next;
+	}
+	for (i = 0; i < index->count; i++)
+		free(index->entries[i].name);
+	free(index->entries);
+	free(index->hash);
+	free(index);
+}
+
+static struct cbfs_file *load(struct cbfs_index *index, struct entry *e)
+{
+	struct cbfs_media *const media = &index->media;
+	const size_t size = e->data_offset + e->len;
+	void *data;
+
+	if (e->file)
+		return e->file;
+
+	media->open(media);
+	if (index->flags & CBFS_INDEX_MAPPED) {
+		data = media->map(media, e->offset, size);
+		if (data == CBFS_MEDIA_INVALID_MAP_ADDRESS)
+			data = NULL;
+	} else {
+		data = alloc_chunk(index, size);
+		if (data && media->read(media, data, e->offset, size) != size)
+			data = NULL;
+	}
+	media->close(media);
+
+	if (!data)
+		printf("ERROR: cbfs_index: couldn't load '%s'.\n", e->name);
+	e->file = data;
+	return e->file;
+}
+
+/**
+ * Look up a file
+ *
+ * @return pointer to the file header, followed by name and data, or NULL
+ */
+struct cbfs_file *cbfs_index_get_file(struct cbfs_index *index,
+				      const char *name)
+{
+	struct entry *const e = lookup(index, name);
+
+	if (!e)
+		return NULL;
+	return load(index, e);
+}
+
+/**
+ * Look up the data of a file of the given type
+ *
+ * @size if not NULL, set to the size of the data
+ * @return pointer to the data, or NULL
+ */
+void *cbfs_index_get_file_content(struct cbfs_index *index, const char *name,
+				  int type, size_t *size)
+{
+	struct entry *const e = lookup(index, name);
+
+	if (!e) {
+		printf("ERROR: Could not find file '%s'.\n", name);
+		return NULL;
+	}
+	if (e->type != type) {
+		printf("ERROR: File '%s' is of type %x, but we requested %x.\n",
+		       name, e->type, type);
+		return NULL;
+	}
+	if (!load(index, e))
+		return NULL;
+
+	if (size)
+		*size = e->len;
+	return (uint8_t *)e->file + e->data_offset;
+}
+
+static int compare_offset(const void *a, const void *b)
+{
+	const struct entry *const ea = *(const struct entry *const *)a;
+	const struct entry *const eb = *(const struct entry *const *)b;
+
+	return ea->offset < eb->offset ? -1 : ea->offset > eb->offset;
+}
+
+/**
+ * Load a set of files in one pass over the media
+ *
+ * Files are read in the order they are stored, and files close to each
+ * other are read with a single request. On memory-mapped media nothing
+ * needs to be read and the files are just mapped.
+ *
+ * @names names of the files to load
+ * @count number of names
+ * @return number of files found, or -1 if reading failed
+ */
+int cbfs_index_prefetch(struct cbfs_index *index, const char *const names[],
+			size_t count)
+{
+	struct cbfs_media *const media = &index->media;
+	struct entry **todo;
+	size_t i, j, n = 0;
+	int found = 0;
+
+	todo = malloc(count * sizeof(*todo));
+	if (!todo)
+		return -1;
+
+	for (i = 0; i < count; i++) {
+		struct entry *const e = lookup(index, names[i]);
+		if (!e)
+			continue;
+		found++;
+		if (e->file)
+			continue;
+		if (index->flags & CBFS_INDEX_MAPPED) {
+			if (!load(index, e))
+				goto error;
+			continue;
+		}
+		/* The same name may be asked for more than once. */
+		for (j = 0; j < n && todo[j] != e; j++)
+			;
+		if (j == n)
+			todo[n++] = e;
+	}
+
+	qsort(todo, n, sizeof(*todo), compare_offset);
+
+	media->open(media);
+	for (i = 0; i < n; i = j) {
+		const uint32_t start = todo[i]->offset;
+		uint32_t end = start + todo[i]->data_offset + todo[i]->len;
+		uint8_t *data;
+
+		for (j = i + 1; j < n &&
+		     todo[j]->offset <= end + PREFETCH_MERGE_GAP; j++)
+			end = todo[j]->offset + todo[j]->data_offset +
+			      todo[j]->len;
+
+		data = alloc_chunk(index, end - start);
+		if (!data ||
+		    media->read(media, data, start, end - start) != end - start) {
+			media->close(media);
+			goto error;
+		}
+		for (; i < j; i++)
+			todo[i]->file = (void *)(data + todo[i]->offset - start);
+	}
+	media->close(media);
+
+	free(todo);
+	return found;
+
+error:
+	printf("ERROR: cbfs_index: prefetch failed.\n");
+	free(todo);
+	return -1;
+}
@@ -0,0 +1,193 @@
+/*
+ * Queued reads in the AHCI driver: slot allocation, completion and the
+ * command timeout.
+ *
+ * The driver is built into this file against the libpayload headers.
+ * Its port registers are plain memory and the test plays the HBA: it
+ * sets PxCI bits when the driver issues a command and clears them to
+ * complete it. Time only advances when the test says so.
+ */
+
+#include "../drivers/storage/ahci.c"
+
+unsigned long virtual_offset;
+
+static u64 now;
+static int failures;
+
+uint64_t timer_us(uint64_t base) { return now - base; }
+void udelay(unsigned int n) { now += n; }
+void mdelay(unsigned int n) { now += n * 1000ULL; }
+void delay(unsigned int n) { now += n * 1000000ULL; }
+
+u16 pci_read_config16(u32 device, u16 reg) { return 0xffff; }
+u32 pci_read_config32(u32 device, u16 reg) { return 0xffffffff; }
+int ata_attach_device(ata_dev_t *dev, storage_port_t port) { return -1; }
+int atapi_attach_device(atapi_dev_t *dev, storage_port_t port) { return -1; }
+
+void storage_complete_request(storage_req_t *const req, const ssize_t result)
+{
+	req->result = result;
+	req->status = (result < 0) ? REQ_ERROR : REQ_DONE;
+}
+
+#define CHECK(cond) do {						\
+	if (!(cond)) {							\
+		printf("%s:%d: check failed: %s\n",			\
+		       __func__, __LINE__, #cond);			\
+		failures++;						\
+	}								\
+} while (0)
+
+static hba_ctrl_t ctrl;
+static hba_port_t port;
+static ahci_dev_t dev;
+static storage_req_t reqs[40];
+static u8 buf[512] __attribute__((aligned(4)));
+
+static void setup(const int ncq)
+{
+	static cmd_t cmdlist[32];
+	static cmdtable_t cmdtables[32];
+
+	memset((void *)&ctrl, 0, sizeof(ctrl));
+	memset((void *)&port, 0, sizeof(port));
+	memset(&dev, 0, sizeof(dev));
+	memset(reqs, 0, sizeof(reqs));
+
+	ctrl.caps = ncq ? HBA_CAPS_SNCQ : 0;
+	port.cmd_stat = HBA_PxCMD_CR;
+
+	dev.ctrl = &ctrl;
+	dev.port = &port;
+	dev.cmdlist = cmdlist;
+	dev.cmdtables = cmdtables;
+	dev.slots = 32;
+	dev.ata_dev.read_cmd = ATA_READ_DMA;
+	dev.ata_dev.sector_size_shift = 9;
+	dev.ata_dev.queue_depth = ncq ? 4 : 0;
+}
+
+/* Submit reqs[i] like a caller would, PxCI and PxSACT are write-1-to-set. */
+static int submit(const int i)
+{
+	const u32 ci = port.cmd_issue, sact = port.sata_active;
+
+	reqs[i].start = i;
+	reqs[i].count = 1;
+	reqs[i].buf = buf;
+	port.cmd_issue = 0;
+	port.sata_active = 0;
+	const int ret = ahci_ata_submit_read(&dev.ata_dev, &reqs[i]);
+	port.cmd_issue |= ci;
+	port.sata_active |= sact;
+	return ret;
+}
+
+static void complete(const int slot)
+{
+	port.cmd_issue &= ~(1u << slot);
+	port.sata_active &= ~(1u << slot);
+}
+
+static void test_slots(void)
+{
+	int i;
+
+	setup(0);
+	for (i = 0; i < 32; ++i)
+		CHECK(submit(i) == 0);
+	CHECK(dev.slots_busy == 0xffffffff);
+	CHECK(port.cmd_issue == 0xffffffff);
+	CHECK(dev.slot[31].req == &reqs[31]);
+	CHECK(dev.cmdtables[31].fis[2] == ATA_READ_DMA);
+	CHECK(dev.cmdtables[31].fis[4] == 31);
+	CHECK(submit(32) == 1);
+
+	/* The top slot completes first. */
+	complete(31);
+	CHECK(ahci_process_requests(&dev.ata_dev) == 31);
+	CHECK(reqs[31].status == REQ_DONE && reqs[31].result == 1);
+	CHECK(reqs[30].status == REQ_PENDING);
+	CHECK(dev.slots_busy == 0x7fffffff);
+
+	/* The freed slot is reused, nothing else is free. */
+	CHECK(submit(32) == 0);
+	CHECK(dev.slot[31].req == &reqs[32]);
+	CHECK(submit(33) == 1);
+
+	for (i = 0; i < 32; ++i)
+		complete(i);
+	CHECK(ahci_process_requests(&dev.ata_dev) == 0);
+	CHECK(dev.slots_busy == 0);
+	for (i = 0; i <= 32; ++i)
+		CHECK(reqs[i].status == REQ_DONE);
+}
+
+static void test_ncq(void)
+{
+	int i;
+
+	setup(1);
+	for (i = 0; i < 4; ++i)
+		CHECK(submit(i) == 0);
+	CHECK(submit(4) == 1);
+	CHECK(dev.slots_ncq == 0xf);
+	CHECK(port.sata_active == 0xf);
+	CHECK(dev.cmdtables[3].fis[2] == ATA_READ_FPDMA_QUEUED);
+	CHECK(dev.cmdtables[3].fis[12] == 3 << FIS_H2D_NCQ_TAG_SHIFT);
+
+	/* The HBA clears PxCI when the drive accepted a queued command. */
+	port.cmd_issue = 0;
+	CHECK(ahci_process_requests(&dev.ata_dev) == 4);
+	complete(2);
+	CHECK(ahci_process_requests(&dev.ata_dev) == 3);
+	CHECK(reqs[2].status == REQ_DONE);
+	CHECK(dev.slots_ncq == 0xb);
+
+	/* Queued commands all run at once, their time starts at issue. */
+	now += 6000000;
+	CHECK(ahci_process_requests(&dev.ata_dev) == 0);
+	CHECK(reqs[0].status == REQ_ERROR && reqs[3].status == REQ_ERROR);
+	CHECK(dev.slots_busy == 0 && dev.slots_ncq == 0);
+}
+
+static void test_timeout(void)
+{
+	int i;
+
+	/* Non-queued commands run one after the other. A slot waiting
+	   behind slow ones must not time out. */
+	setup(0);
+	for (i = 0; i < 3; ++i)
+		CHECK(submit(i) == 0);
+	now += 4000000;
+	complete(0);
+	CHECK(ahci_process_requests(&dev.ata_dev) == 2);
+	now += 4000000;
+	complete(1);
+	CHECK(ahci_process_requests(&dev.ata_dev) == 1);
+	now += 4000000;
+	CHECK(ahci_process_requests(&dev.ata_dev) == 1);
+	CHECK(reqs[2].status == REQ_PENDING);
+
+	/* But one that runs for too long does. */
+	now += 2000000;
+	CHECK(ahci_process_requests(&dev.ata_dev) == 0);
+	CHECK(reqs[2].status == REQ_ERROR);
+	CHECK(dev.slots_busy == 0);
+}
+
+int main(int argc, char **argv)
+{
+	test_slots();
+	test_ncq();
+	test_timeout();
+
+	if (failures) {
+		printf("%d failure(s)\n", failures);
+		return 1;
+	}
+	printf("ahci tests passed\n");
+	return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * CBFS index: lookups on a valid image, a missing file, and a file whose
+ * length runs past the end of the image.
+ *
+ * Built against the libpayload headers together with cbfs_index.c. The
+ * image is put together in memory and read through a media that gives
+ * up after too many reads, so a scan that doesn't terminate fails.
+ */
+
+#include <libpayload.h>
+#include <cbfs.h>
+#include <cbfs_index.h>
+#include <sysinfo.h>
+
+#define IMAGE_SIZE	(64 * 1024)
+#define ALIGN_CBFS	64
+#define FIRST_FILE	0x40
+#define MAX_READS	(2 * IMAGE_SIZE / ALIGN_CBFS)
+
+struct sysinfo_t lib_sysinfo;
+
+static uint8_t image[IMAGE_SIZE] __attribute__((aligned(8)));
+static int reads, failures;
+
+const struct cbfs_header *cbfs_get_header(struct cbfs_media *media)
+{
+	return (const struct cbfs_header *)image;
+}
+
+int init_default_cbfs_media(struct cbfs_media *media)
+{
+	return -1;
+}
+
+static int image_open(struct cbfs_media *media) { return 0; }
+static int image_close(struct cbfs_media *media) { return 0; }
+static void *image_unmap(struct cbfs_media *media, const void *address)
+{
+	return NULL;
+}
+
+static void *image_map(struct cbfs_media *media, size_t offset, size_t count)
+{
+	if (offset > IMAGE_SIZE || count > IMAGE_SIZE - offset)
+		return CBFS_MEDIA_INVALID_MAP_ADDRESS;
+	return image + offset;
+}
+
+static size_t image_read(struct cbfs_media *media, void *dest, size_t offset,
+			 size_t count)
+{
+	if (++reads > MAX_READS) {
+		printf("scan doesn't terminate\n");
+		exit(1);
+	}
+	if (offset > IMAGE_SIZE || count > IMAGE_SIZE - offset)
+		return 0;
+	memcpy(dest, image + offset, count);
+	return count;
+}
+
+static struct cbfs_media media = {
+	.open = image_open,
+	.close = image_close,
+	.map = image_map,
+	.unmap = image_unmap,
+	.read = image_read,
+};
+
+#define CHECK(cond) do {						\
+	if (!(cond)) {							\
+		printf("%s:%d: check failed: %s\n",			\
+		       __func__, __LINE__, #cond);			\
+		failures++;						\
+	}								\
+} while (0)
+
+/* Add a file at offset and return the offset of the next one. */
+static uint32_t add_file(uint32_t offset, const char *name,
+			 const char *data, uint32_t len)
+{
+	struct cbfs_file *const file = (struct cbfs_file *)(image + offset);
+	const uint32_t data_offset = ALIGN_UP(sizeof(*file) +
+					      strlen(name) + 1, 16);
+
+	memcpy(file->magic, CBFS_FILE_MAGIC, sizeof(file->magic));
+	file->len = htonl(len);
+	file->type = htonl(CBFS_TYPE_RAW);
+	file->offset = htonl(data_offset);
+	strcpy((char *)(file + 1), name);
+	memcpy(image + offset + data_offset, data, len);
+
+	return ALIGN_UP(offset + data_offset + len, ALIGN_CBFS);
+}
+
+static void build_image(void)
+{
+	struct cbfs_header *const header = (struct cbfs_header *)image;
+	uint32_t offset = FIRST_FILE;
+
+	memset(image, 0xff, sizeof(image));
+	header->magic = htonl(CBFS_HEADER_MAGIC);
+	header->version = htonl(CBFS_HEADER_VERSION);
+	header->romsize = htonl(IMAGE_SIZE);
+	header->bootblocksize = 0;
+	header->align = htonl(ALIGN_CBFS);
+	header->offset = htonl(FIRST_FILE);
+
+	offset = add_file(offset, "first", "one", 4);
+	offset = add_file(offset, "second", "two", 4);
+	offset = add_file(offset, "first", "dup", 4);
+	offset = add_file(offset, "third", "three", 6);
+}
+
+static void test_valid(void)
+{
+	struct cbfs_index *index;
+	size_t size;
+	char *data;
+
+	build_image();
+	reads = 0;
+	index = cbfs_index_create(&media, 0);
+	CHECK(index);
+	if (!index)
+		return;
+
+	data = cbfs_index_get_file_content(index, "second", CBFS_TYPE_RAW,
+					   &size);
+	CHECK(data && size == 4 && !strcmp(data, "two"));
+	data = cbfs_index_get_file_content(index, "third", CBFS_TYPE_RAW,
+					   &size);
+	CHECK(data && size == 6 && !strcmp(data, "three"));
+
+	/* The first of two files with the same name wins. */
+	data = cbfs_index_get_file_content(index, "first", CBFS_TYPE_RAW,
+					   NULL);
+	CHECK(data && !strcmp(data, "one"));
+
+	CHECK(!cbfs_index_get_file(index, "missing"));
+	CHECK(!cbfs_index_get_file_content(index, "second", CBFS_TYPE_STAGE,
+					   NULL));
+	cbfs_index_destroy(index);
+}
+
+static void test_corrupt_length(void)
+{
+	struct cbfs_index *index;
+	struct cbfs_file *file;
+	uint32_t offset;
+
+	/* Make the length of "second" wrap the offset back to "first". */
+	build_image();
+	offset = ALIGN_UP(FIRST_FILE + ntohl(((struct cbfs_file *)
+			(image + FIRST_FILE))->offset) + 4, ALIGN_CBFS);
+	file = (struct cbfs_file *)(image + offset);
+	file->len = htonl(FIRST_FILE - offset - ntohl(file->offset));
+
+	reads = 0;
+	index = cbfs_index_create(&media, 0);
+	CHECK(index);
+	if (!index)
+		return;
+
+	/* Files before it are still found, the rest can't be trusted. */
+	CHECK(cbfs_index_get_file(index, "first"));
+	CHECK(!cbfs_index_get_file(index, "second"));
+	CHECK(!cbfs_index_get_file(index, "third"));
+	cbfs_index_destroy(index);
+}
+
+int main(int argc, char **argv)
+{
+	test_valid();
+	test_corrupt_length();
+
+	if (failures) {
+		printf("%d failure(s)\n", failures);
+		return 1;
+	}
+	printf("cbfs_index tests passed\n");
+	return 0;
+}
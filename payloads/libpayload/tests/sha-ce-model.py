@@ -0,0 +1,291 @@
+#!/usr/bin/env python3
+#
+# sha-ce-model.py - check sha_ce.S without an arm64 machine
+#
+# Runs sha1_ce_transform() and sha256_ce_transform() on a model of the
+# few AArch64 instructions they use and compares the result with the
+# FIPS 180-4 block functions. The SHA instructions follow the pseudocode
+# in the ARMv8 ARM. The input is the output of llvm-mc, which assembles
+# the file and expands its macros, see the sha-ce-check target.
+#
+# This checks the algorithm, the register use and the message schedule,
+# not the instruction encodings. Those are only checked by llvm-mc.
+
+import hashlib, os, re, struct, sys
+
+M32 = 0xffffffff
+M128 = (1 << 128) - 1
+def rol(x, n): return ((x << n) | (x >> (32 - n))) & M32
+def ror(x, n): return ((x >> n) | (x << (32 - n))) & M32
+def lane(v, i): return (v >> (32 * i)) & M32
+def mk(l): return sum((x & M32) << (32 * i) for i, x in enumerate(l))
+def lanes(v): return [lane(v, i) for i in range(4)]
+def ch(x, y, z): return ((y ^ z) & x) ^ z
+def par(x, y, z): return x ^ y ^ z
+def maj(x, y, z): return (x & y) | ((x | y) & z)
+
+def sha1op(X, Y, W, f):
+    for e in range(4):
+        x = lanes(X)
+        t = f(x[1], x[2], x[3])
+        Y = (Y + rol(x[0], 5) + t + lane(W, e)) & M32
+        x[1] = rol(x[1], 30)
+        X = mk(x)
+        big = (Y << 128) | X
+        big = ((big << 32) | (big >> 128)) & ((1 << 160) - 1)
+        Y, X = big >> 128, big & M128
+    return X
+
+def S0(x): return ror(x, 2) ^ ror(x, 13) ^ ror(x, 22)
+def S1(x): return ror(x, 6) ^ ror(x, 11) ^ ror(x, 25)
+
+def sha256hash(X, Y, W, part1):
+    for e in range(4):
+        x, y = lanes(X), lanes(Y)
+        chs = ch(y[0], y[1], y[2])
+        mj = maj(x[0], x[1], x[2])
+        T1 = (y[3] + S1(y[0]) + chs + lane(W, e)) & M32
+        x[3] = (T1 + x[3]) & M32
+        y[3] = (T1 + S0(x[0]) + mj) & M32
+        X, Y = mk(x), mk(y)
+        big = (Y << 128) | X
+        big = ((big << 32) | (big >> 224)) & ((1 << 256) - 1)
+        Y, X = big >> 128, big & M128
+    return X if part1 else Y
+
+class CPU:
+    def __init__(self, lines, mem):
+        self.x = [0] * 32
+        self.v = [0] * 32
+        self.mem = mem
+        self.prog, self.labels = [], {}
+        for l in lines:
+            l = l.split('//')[0].strip()
+            if not l or l.startswith('.'):
+                m = re.match(r'^(\.?\w+):$', l)
+                if m:
+                    self.labels[m.group(1)] = len(self.prog)
+                continue
+            m = re.match(r'^(\w+):$', l)
+            if m:
+                self.labels[m.group(1)] = len(self.prog)
+                continue
+            op, _, args = l.partition('\t')
+            self.prog.append((op.strip(), args.strip()))
+
+    def rd(self, addr, n): return self.mem.read(addr, n)
+    def wr(self, addr, b): self.mem.write(addr, b)
+
+    def reg(self, s):
+        return int(s[1:].split('.')[0])
+
+    def imm(self, s):
+        s = s.lstrip('#')
+        return int(s, 0)
+
+    def vlist(self, s):
+        return [self.reg(r.strip()) for r in s.strip('{} ').split(',')]
+
+    def run(self, name, args, syms):
+        self.x[:len(args)] = args
+        pc = self.labels[name]
+        steps = 0
+        while True:
+            steps += 1
+            op, a = self.prog[pc]
+            pc += 1
+            ops = [t.strip() for t in re.split(r',\s*(?![^{]*})(?![^\[]*\])', a)] if a else []
+            if op == 'ret':
+                return steps
+            elif op == 'cbz':
+                if self.x[self.reg(ops[0])] == 0:
+                    pc = self.labels[ops[1]]
+            elif op == 'b.ne':
+                if not self.z:
+                    pc = self.labels[ops[0]]
+            elif op == 'subs':
+                d = self.reg(ops[0])
+                r = (self.x[self.reg(ops[1])] - self.imm(ops[2])) & ((1 << 64) - 1)
+                self.x[d] = r
+                self.z = r == 0
+            elif op == 'mov' and ops[0][0] == 'w':
+                self.x[self.reg(ops[0])] = self.imm(ops[1])
+            elif op == 'movk':
+                d = self.reg(ops[0])
+                sh = int(ops[2].split('#')[1]) if len(ops) > 2 else 0
+                self.x[d] = (self.x[d] & ~(0xffff << sh) & M32) | (self.imm(ops[1]) << sh)
+            elif op == 'dup':
+                self.v[self.reg(ops[0])] = mk([self.x[self.reg(ops[1])] & M32] * 4)
+            elif op == 'adrp':
+                self.x[self.reg(ops[0])] = syms[ops[1]] & ~0xfff
+            elif op == 'add' and ops[0][0] == 'x':
+                sym = ops[2].split(':lo12:')[1]
+                self.x[self.reg(ops[0])] = self.x[self.reg(ops[1])] + (syms[sym] & 0xfff)
+            elif op == 'add':
+                d, n, m = (self.reg(o) for o in ops)
+                r = mk([(p + q) & M32 for p, q in zip(lanes(self.v[n]), lanes(self.v[m]))])
+                if ops[0].endswith('.2s'):
+                    r &= (1 << 64) - 1
+                self.v[d] = r
+            elif op == 'mov':
+                self.v[self.reg(ops[0])] = self.v[self.reg(ops[1])]
+            elif op == 'ld1' or op == 'st1':
+                regs = self.vlist(ops[0])
+                base = self.reg(ops[1].strip('[]'))
+                addr = self.x[base]
+                for i, r in enumerate(regs):
+                    if op == 'ld1':
+                        self.v[r] = int.from_bytes(self.rd(addr + 16 * i, 16), 'little')
+                    else:
+                        self.wr(addr + 16 * i, self.v[r].to_bytes(16, 'little'))
+                if len(ops) > 2:
+                    self.x[base] = addr + self.imm(ops[2])
+            elif op == 'ldr' or op == 'str':
+                r = self.reg(ops[0])
+                m = re.match(r'\[x(\d+)(?:,\s*#(\d+))?\]', ops[1])
+                addr = self.x[int(m.group(1))] + int(m.group(2) or 0)
+                if op == 'ldr':
+                    self.v[r] = int.from_bytes(self.rd(addr, 4), 'little')
+                else:
+                    self.wr(addr, (self.v[r] & M32).to_bytes(4, 'little'))
+            elif op == 'rev32':
+                b = self.v[self.reg(ops[1])].to_bytes(16, 'little')
+                b = b''.join(b[i:i + 4][::-1] for i in range(0, 16, 4))
+                self.v[self.reg(ops[0])] = int.from_bytes(b, 'little')
+            elif op == 'sha1h':
+                self.v[self.reg(ops[0])] = rol(self.v[self.reg(ops[1])] & M32, 30)
+            elif op in ('sha1c', 'sha1p', 'sha1m'):
+                f = {'sha1c': ch, 'sha1p': par, 'sha1m': maj}[op]
+                d = self.reg(ops[0])
+                self.v[d] = sha1op(self.v[d], self.v[self.reg(ops[1])] & M32,
+                                   self.v[self.reg(ops[2])], f)
+            elif op == 'sha1su0':
+                d, n, m = (self.reg(o) for o in ops)
+                o1, o2, o3 = self.v[d], self.v[n], self.v[m]
+                r = ((o2 & ((1 << 64) - 1)) << 64) | (o1 >> 64)
+                self.v[d] = r ^ o1 ^ o3
+            elif op == 'sha1su1':
+                d, n = (self.reg(o) for o in ops)
+                T = self.v[d] ^ (self.v[n] >> 32)
+                t = lanes(T)
+                r = [rol(t[0], 1), rol(t[1], 1), rol(t[2], 1),
+                     rol(t[3], 1) ^ rol(t[0], 2)]
+                self.v[d] = mk(r)
+            elif op == 'sha256h':
+                d, n, m = (self.reg(o) for o in ops)
+                self.v[d] = sha256hash(self.v[d], self.v[n], self.v[m], True)
+            elif op == 'sha256h2':
+                d, n, m = (self.reg(o) for o in ops)
+                self.v[d] = sha256hash(self.v[n], self.v[d], self.v[m], False)
+            elif op == 'sha256su0':
+                d, n = (self.reg(o) for o in ops)
+                o1, o2 = self.v[d], self.v[n]
+                T = lanes(((o2 & M32) << 96) | (o1 >> 32))
+                o = lanes(o1)
+                self.v[d] = mk([(ror(e, 7) ^ ror(e, 18) ^ (e >> 3)) + o[i]
+                                for i, e in enumerate(T)])
+            elif op == 'sha256su1':
+                d, n, m = (self.reg(o) for o in ops)
+                o1, o2, o3 = lanes(self.v[d]), self.v[n], self.v[m]
+                T0 = lanes(((self.v[m] & M32) << 96) | (o2 >> 32))
+                o3l = lanes(o3)
+                s1 = lambda e: ror(e, 17) ^ ror(e, 19) ^ (e >> 10)
+                r = [0] * 4
+                for e in range(2):
+                    r[e] = (s1(o3l[e + 2]) + o1[e] + T0[e]) & M32
+                for e in range(2, 4):
+                    r[e] = (s1(r[e - 2]) + o1[e] + T0[e]) & M32
+                self.v[d] = mk(r)
+            else:
+                raise Exception('unhandled %s %s' % (op, a))
+
+class Mem:
+    def __init__(self): self.b = {}
+    def read(self, a, n):
+        for base, buf in self.b.items():
+            if base <= a and a + n <= base + len(buf):
+                return bytes(buf[a - base:a - base + n])
+        raise Exception('bad read %#x' % a)
+    def write(self, a, d):
+        for base, buf in self.b.items():
+            if base <= a and a + len(d) <= base + len(buf):
+                buf[a - base:a - base + len(d)] = d
+                return
+        raise Exception('bad write %#x' % a)
+
+# FIPS 180-4 reference block functions.
+K256 = []
+def sha256_ref(st, block):
+    w = list(struct.unpack('>16I', block))
+    for t in range(16, 64):
+        s0 = ror(w[t-15], 7) ^ ror(w[t-15], 18) ^ (w[t-15] >> 3)
+        s1 = ror(w[t-2], 17) ^ ror(w[t-2], 19) ^ (w[t-2] >> 10)
+        w.append((w[t-16] + s0 + w[t-7] + s1) & M32)
+    a, b, c, d, e, f, g, h = st
+    for t in range(64):
+        t1 = (h + S1(e) + ch(e, f, g) + K256[t] + w[t]) & M32
+        t2 = (S0(a) + maj(a, b, c)) & M32
+        h, g, f, e, d, c, b, a = g, f, e, (d + t1) & M32, c, b, a, (t1 + t2) & M32
+    return [(x + y) & M32 for x, y in zip(st, [a, b, c, d, e, f, g, h])]
+
+def sha1_ref(st, block):
+    w = list(struct.unpack('>16I', block))
+    for t in range(16, 80):
+        w.append(rol(w[t-3] ^ w[t-8] ^ w[t-14] ^ w[t-16], 1))
+    a, b, c, d, e = st
+    for t in range(80):
+        f, k = [(ch, 0x5a827999), (par, 0x6ed9eba1), (maj, 0x8f1bbcdc),
+                (par, 0xca62c1d6)][t // 20]
+        tmp = (rol(a, 5) + f(b, c, d) + e + k + w[t]) & M32
+        e, d, c, b, a = d, c, rol(b, 30), a, tmp
+    return [(x + y) & M32 for x, y in zip(st, [a, b, c, d, e])]
+
+def pad(msg):
+    l = len(msg) * 8
+    msg += b'\x80' + b'\0' * ((55 - len(msg)) % 64) + struct.pack('>Q', l)
+    return msg
+
+def main():
+    global K256
+    src = open(sys.argv[1]).read().splitlines()
+    K256 = [int(x, 0) for l in src if l.strip().startswith('.word')
+            for x in l.split(None, 1)[1].split(',')]
+    assert len(K256) == 64
+
+    # Check the reference model against hashlib first.
+    for n in (0, 3, 55, 56, 64, 200):
+        m = os.urandom(n)
+        p = pad(m)
+        s1 = [0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0]
+        s2 = [0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+              0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19]
+        for i in range(0, len(p), 64):
+            s1 = sha1_ref(s1, p[i:i + 64])
+            s2 = sha256_ref(s2, p[i:i + 64])
+        assert struct.pack('>5I', *s1) == hashlib.sha1(m).digest()
+        assert struct.pack('>8I', *s2) == hashlib.sha256(m).digest()
+
+    mem = Mem()
+    KBASE, STATE, DATA = 0x10000, 0x20000, 0x30000
+    mem.b[KBASE] = bytearray(struct.pack('<64I', *K256))
+    syms = {'sha256_ce_k': KBASE}
+    fails = 0
+    for blocks in (0, 1, 2, 5):
+        data = os.urandom(64 * blocks)
+        for name, ref, n in (('sha1_ce_transform', sha1_ref, 5),
+                             ('sha256_ce_transform', sha256_ref, 8)):
+            st = list(struct.unpack('<8I', os.urandom(32)))[:n]
+            mem.b[STATE] = bytearray(struct.pack('<%dI' % n, *st) + b'\xee' * 16)
+            mem.b[DATA] = bytearray(data + b'\0' * 16)
+            cpu = CPU(src, mem)
+            cpu.run(name, [STATE, DATA, blocks], syms)
+            got = list(struct.unpack('<%dI' % n, bytes(mem.b[STATE][:4 * n])))
+            exp = st
+            for i in range(blocks):
+                exp = ref(exp, data[64 * i:64 * i + 64])
+            ok = got == exp and mem.b[STATE][4 * n:] == b'\xee' * 16
+            print('%-20s %d block(s): %s' % (name, blocks, 'ok' if ok else 'MISMATCH'))
+            fails += not ok
+    sys.exit(1 if fails else 0)
+
+main()
@@ -0,0 +1,192 @@
+/*
+ * Known-answer and throughput test for libpayload's SHA-1/SHA-256 code.
+ *
+ * The portable implementations are always checked. On arm64 hosts with
+ * the Crypto Extensions (HWCAP_SHA1/HWCAP_SHA2) the assembly block
+ * functions are checked against the portable ones and both are timed.
+ */
+
+/* system headers */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef __aarch64__
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+/* libpayload functions, built separately against libpayload headers */
+uint8_t *sha1(const uint8_t *data, size_t len, uint8_t *buf);
+uint8_t *sha256(const uint8_t *data, size_t len, uint8_t *buf);
+void SHA1Transform(uint32_t state[5], const uint8_t buffer[64]);
+void SHA256Transform(uint32_t state[8], const uint8_t buffer[64]);
+#ifdef __aarch64__
+void sha1_ce_transform(uint32_t state[5], const uint8_t *data, size_t blocks);
+void sha256_ce_transform(uint32_t state[8], const uint8_t *data,
+			 size_t blocks);
+#endif
+
+#define BENCH_SIZE	(16 * 1024 * 1024)
+
+static int failures;
+
+static const struct {
+	const char *msg;
+	size_t repeat;
+	const char *sha1;
+	const char *sha256;
+} kat[] = {
+	{ "", 1,
+	  "da39a3ee5e6b4b0d3255bfef95601890afd80709",
+	  "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+	{ "abc", 1,
+	  "a9993e364706816aba3e25717850c26c9cd0d89d",
+	  "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+	{ "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+	  "84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+	  "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+	{ "a", 1000000,
+	  "34aa973cd4c4daa4f61eeb2bdbad27316534016f",
+	  "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" },
+};
+
+static void check(const char *what, const char *name,
+		  const uint8_t *digest, size_t len, const char *expected)
+{
+	char hex[65];
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		sprintf(&hex[2 * i], "%02x", digest[i]);
+	if (strcmp(hex, expected)) {
+		fprintf(stderr, "%s(\"%.16s\"): got %s, expected %s\n",
+			what, name, hex, expected);
+		failures++;
+	}
+}
+
+static void test_kat(void)
+{
+	uint8_t digest[32];
+	size_t i, j;
+
+	for (i = 0; i < sizeof(kat) / sizeof(kat[0]); i++) {
+		const size_t len = strlen(kat[i].msg) * kat[i].repeat;
+		uint8_t *const buf = malloc(len + 1);
+		if (!buf)
+			exit(1);
+		for (j = 0; j < kat[i].repeat; j++)
+			memcpy(buf + j * strlen(kat[i].msg), kat[i].msg,
+			       strlen(kat[i].msg));
+
+		check("sha1", kat[i].msg, sha1(buf, len, digest), 20,
+		      kat[i].sha1);
+		check("sha256", kat[i].msg, sha256(buf, len, digest), 32,
+		      kat[i].sha256);
+		free(buf);
+	}
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *what, double seconds)
+{
+	printf("%-16s %8.1f MiB/s\n", what,
+	       BENCH_SIZE / seconds / (1024 * 1024));
+}
+
+static void bench_portable(const uint8_t *data)
+{
+	uint32_t state[8] = { 0 };
+	double start;
+	size_t i;
+
+	start = now();
+	for (i = 0; i < BENCH_SIZE; i += 64)
+		SHA1Transform(state, data + i);
+	report("sha1 (C)", now() - start);
+
+	start = now();
+	for (i = 0; i < BENCH_SIZE; i += 64)
+		SHA256Transform(state, data + i);
+	report("sha256 (C)", now() - start);
+}
+
+#ifdef __aarch64__
+static void test_ce(const uint8_t *data)
+{
+	const unsigned long hwcap = getauxval(AT_HWCAP);
+	uint32_t ref[8], ce[8];
+	double start;
+	size_t i;
+
+	if (hwcap & HWCAP_SHA1) {
+		memset(ref, 0x5a, sizeof(ref));
+		memcpy(ce, ref, sizeof(ce));
+		for (i = 0; i < 1024; i++)
+			SHA1Transform(ref, data + i * 64);
+		sha1_ce_transform(ce, data, 1024);
+		if (memcmp(ref, ce, 5 * sizeof(uint32_t))) {
+			fprintf(stderr, "sha1_ce_transform mismatch\n");
+			failures++;
+		}
+
+		start = now();
+		sha1_ce_transform(ce, data, BENCH_SIZE / 64);
+		report("sha1 (CE)", now() - start);
+	} else {
+		printf("No SHA1 instructions, skipping.\n");
+	}
+
+	if (hwcap & HWCAP_SHA2) {
+		memset(ref, 0xa5, sizeof(ref));
+		memcpy(ce, ref, sizeof(ce));
+		for (i = 0; i < 1024; i++)
+			SHA256Transform(ref, data + i * 64);
+		sha256_ce_transform(ce, data, 1024);
+		if (memcmp(ref, ce, sizeof(ref))) {
+			fprintf(stderr, "sha256_ce_transform mismatch\n");
+			failures++;
+		}
+
+		start = now();
+		sha256_ce_transform(ce, data, BENCH_SIZE / 64);
+		report("sha256 (CE)", now() - start);
+	} else {
+		printf("No SHA2 instructions, skipping.\n");
+	}
+}
+#endif
+
+int main(int argc, char **argv)
+{
+	uint8_t *data = malloc(BENCH_SIZE);
+	size_t i;
+
+	if (!data)
+		return 1;
+	srand(1);
+	for (i = 0; i < BENCH_SIZE; i++)
+		data[i] = rand();
+
+	test_kat();
+	bench_portable(data);
+#ifdef __aarch64__
+	test_ce(data);
+#endif
+
+	free(data);
+	if (failures) {
+		fprintf(stderr, "%d failure(s)\n", failures);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * Block cache coherence of the storage layer: reads after writes and
+ * asynchronous reads have to see the data on the device.
+ *
+ * Built against the libpayload headers together with storage.c and
+ * blockcache.c. The device is a RAM disk.
+ */
+
+#include <libpayload.h>
+#include <storage/storage.h>
+#include <storage/blockcache.h>
+
+#define BLOCKS	64
+
+static unsigned char disk[BLOCKS][512];
+static int device_reads, async_reads, failures;
+
+void ahci_initialize(void) {}
+
+static ssize_t ram_read(storage_dev_t *const dev, const lba_t start,
+			const size_t count, unsigned char *const buf)
+{
+	if (start > BLOCKS || count > BLOCKS - start)
+		return -1;
+	device_reads++;
+	memcpy(buf, disk[start], count * 512);
+	return count;
+}
+
+/* Writes at most 4 blocks, like a device failing part way. */
+static ssize_t ram_write(storage_dev_t *const dev, const lba_t start,
+			 const size_t count, const unsigned char *const buf)
+{
+	const size_t n = MIN(count, 4);
+
+	if (start > BLOCKS || count > BLOCKS - start)
+		return -1;
+	memcpy(disk[start], buf, n * 512);
+	return (n < count) ? -1 : n;
+}
+
+static int ram_submit(storage_dev_t *const dev, storage_req_t *const req)
+{
+	async_reads++;
+	storage_complete_request(req, ram_read(dev, req->start, req->count,
+					       req->buf));
+	return 0;
+}
+
+static storage_dev_t ram = {
+	.read_blocks512 = ram_read,
+	.write_blocks512 = ram_write,
+	.submit_read_blocks512 = ram_submit,
+};
+
+#define CHECK(cond) do {						\
+	if (!(cond)) {							\
+		printf("%s:%d: check failed: %s\n",			\
+		       __func__, __LINE__, #cond);			\
+		failures++;						\
+	}								\
+} while (0)
+
+static int filled(const unsigned char *const buf, const size_t blocks,
+		  const unsigned char c)
+{
+	size_t i;
+
+	for (i = 0; i < blocks * 512; ++i)
+		if (buf[i] != c)
+			return 0;
+	return 1;
+}
+
+static void test_read_after_write(void)
+{
+	unsigned char buf[8 * 512];
+
+	memset(disk, 'a', sizeof(disk));
+	CHECK(storage_read_blocks512(0, 10, 2, buf) == 2);
+	CHECK(filled(buf, 2, 'a'));
+
+	/* Served from the cache now. */
+	device_reads = 0;
+	CHECK(storage_read_blocks512(0, 10, 2, buf) == 2);
+	CHECK(device_reads == 0);
+
+	memset(buf, 'b', 512);
+	CHECK(storage_write_blocks512(0, 11, 1, buf) == 1);
+	CHECK(storage_read_blocks512(0, 10, 2, buf) == 2);
+	CHECK(filled(buf, 1, 'a'));
+	CHECK(filled(buf + 512, 1, 'b'));
+
+	/* A failed write may still have changed some blocks. */
+	CHECK(storage_read_blocks512(0, 16, 8, buf) == 8);
+	memset(buf, 'c', sizeof(buf));
+	CHECK(storage_write_blocks512(0, 16, 8, buf) == -1);
+	memset(buf, 0, sizeof(buf));
+	CHECK(storage_read_blocks512(0, 16, 8, buf) == 8);
+	CHECK(filled(buf, 4, 'c'));
+	CHECK(filled(buf + 4 * 512, 4, 'a'));
+}
+
+static void test_async(void)
+{
+	unsigned char buf[2 * 512];
+	storage_req_t req = { .start = 30, .count = 2, .buf = buf };
+
+	memset(disk, 'a', sizeof(disk));
+	CHECK(storage_read_blocks512(0, 30, 2, buf) == 2);
+
+	/* Cached ranges complete without the device. */
+	async_reads = 0;
+	memset(buf, 0, sizeof(buf));
+	CHECK(storage_submit_read_blocks512(0, &req) == 0);
+	CHECK(req.status == REQ_DONE && req.result == 2);
+	CHECK(async_reads == 0);
+	CHECK(filled(buf, 2, 'a'));
+
+	/* After a write they see the new data. */
+	memset(buf, 'd', 512);
+	CHECK(storage_write_blocks512(0, 31, 1, buf) == 1);
+	memset(buf, 0, sizeof(buf));
+	CHECK(storage_submit_read_blocks512(0, &req) == 0);
+	CHECK(req.status == REQ_DONE && req.result == 2);
+	CHECK(async_reads == 1);
+	CHECK(filled(buf, 1, 'a'));
+	CHECK(filled(buf + 512, 1, 'd'));
+}
+
+int main(int argc, char **argv)
+{
+	if (storage_attach_device(&ram))
+		return 1;
+
+	test_read_after_write();
+	test_async();
+
+	if (failures) {
+		printf("%d failure(s)\n", failures);
+		return 1;
+	}
+	printf("storage tests passed\n");
+	return 0;
+}
@@ -0,0 +1,179 @@
+/*
+ * VPD lookups through the index coreboot leaves in CBMEM: hits, a key
+ * that is not there, two keys with the same FNV-1a hash, a key that is
+ * in the VPD twice, and a missing or bad index.
+ *
+ * Built against the libpayload headers together with vpd.c. The VPD and
+ * its index are put together in memory the way coreboot's cros_vpd.c
+ * builds them.
+ */
+
+#include <libpayload.h>
+#include <vpd.h>
+
+#define MAX_STRINGS	8
+
+struct sysinfo_t lib_sysinfo;
+
+static struct {
+	struct vpd_cbmem header;
+	uint8_t blob[256];
+} vpd;
+
+static struct {
+	struct vpd_index header;
+	struct vpd_index_entry entries[MAX_STRINGS];
+} index;
+
+static uint32_t blob_size;
+static int failures;
+
+#define CHECK(cond) do {						\
+	if (!(cond)) {							\
+		printf("%s:%d: check failed: %s\n",			\
+		       __func__, __LINE__, #cond);			\
+		failures++;						\
+	}								\
+} while (0)
+
+static uint32_t hash(const char *key)
+{
+	uint32_t h = VPD_INDEX_HASH_INIT;
+
+	while (*key) {
+		h ^= (uint8_t)*key++;
+		h *= VPD_INDEX_HASH_PRIME;
+	}
+	return h;
+}
+
+static uint32_t add_bytes(const char *s)
+{
+	const uint32_t offset = blob_size + 1;
+
+	/* A one byte length, the strings are all short. */
+	vpd.blob[blob_size] = strlen(s);
+	memcpy(&vpd.blob[offset], s, strlen(s));
+	blob_size = offset + strlen(s);
+	return offset;
+}
+
+/* Add a VPD string and its index entry, sorted like cros_vpd.c does. */
+static void add_string(const char *key, const char *value)
+{
+	struct vpd_index_entry *e = &index.entries[index.header.count++];
+
+	vpd.blob[blob_size++] = 0x01;	/* VPD_TYPE_STRING */
+	e->hash = hash(key);
+	e->key = add_bytes(key);
+	e->key_len = strlen(key);
+	e->value = add_bytes(value);
+	e->value_len = strlen(value);
+
+	for (; e > index.entries && (e->hash < e[-1].hash ||
+	       (e->hash == e[-1].hash && e->key < e[-1].key)); e--) {
+		struct vpd_index_entry tmp = *e;
+
+		*e = e[-1];
+		e[-1] = tmp;
+	}
+}
+
+static void build_vpd(void)
+{
+	memset(&vpd, 0, sizeof(vpd));
+	memset(&index, 0, sizeof(index));
+	blob_size = 0;
+
+	vpd.header.magic = VPD_CBMEM_MAGIC;
+	vpd.header.version = 1;
+	index.header.magic = VPD_INDEX_MAGIC;
+
+	add_string("serial_number", "ABC123");
+	add_string("k7e827", "first");		/* same hash as ka4bb0 */
+	add_string("region", "us");
+	add_string("ka4bb0", "second");
+	add_string("region", "gb");
+	add_string("ethernet_mac0", "00:11:22:33:44:55");
+	vpd.blob[blob_size++] = 0x00;	/* VPD_TYPE_TERMINATOR */
+	vpd.header.ro_size = blob_size;
+
+	lib_sysinfo.vpd = &vpd;
+	lib_sysinfo.vpd_index = &index;
+}
+
+/* Check that key has the value 'expected'. */
+static int found(const char *key, const char *expected)
+{
+	const char *value;
+	int size = -1;
+
+	value = vpd_find(key, &size);
+	return value && size == strlen(expected) &&
+	       !memcmp(value, expected, size);
+}
+
+static void test_lookup(void)
+{
+	int size;
+
+	build_vpd();
+	CHECK(found("serial_number", "ABC123"));
+	CHECK(found("ethernet_mac0", "00:11:22:33:44:55"));
+
+	CHECK(!vpd_find("missing", &size));
+	CHECK(!vpd_find("serial", &size));
+	CHECK(!vpd_find("", &size));
+}
+
+static void test_same_hash(void)
+{
+	build_vpd();
+	CHECK(hash("k7e827") == hash("ka4bb0"));
+	CHECK(found("k7e827", "first"));
+	CHECK(found("ka4bb0", "second"));
+}
+
+static void test_duplicate_key(void)
+{
+	/* The first string in the VPD wins, as with a walk of the blob. */
+	build_vpd();
+	CHECK(found("region", "us"));
+}
+
+static void test_no_index(void)
+{
+	int size;
+
+	build_vpd();
+	lib_sysinfo.vpd_index = NULL;
+	CHECK(!vpd_find("serial_number", &size));
+
+	build_vpd();
+	index.header.magic = 0;
+	CHECK(!vpd_find("serial_number", &size));
+
+	build_vpd();
+	lib_sysinfo.vpd = NULL;
+	CHECK(!vpd_find("serial_number", &size));
+
+	/* Entries pointing outside of the RO VPD are ignored. */
+	build_vpd();
+	vpd.header.ro_size = 10;
+	CHECK(!vpd_find("ethernet_mac0", &size));
+}
+
+int main(int argc, char **argv)
+{
+	test_lookup();
+	test_same_hash();
+	test_duplicate_key();
+	test_no_index();
+
+	if (failures) {
+		printf("%d failure(s)\n", failures);
+		return 1;
+	}
+	printf("vpd tests passed\n");
+	return 0;
+}
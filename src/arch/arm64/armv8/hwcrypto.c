@@ -0,0 +1,176 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+
+/*
+ * vboot hardware hashing hooks backed by the ARMv8 Crypto Extensions.
+ * If the CPU lacks the SHA instructions for the requested algorithm,
+ * init() says so and vboot falls back to its software implementation.
+ */
+
+#include <arch/barrier.h>
+#include <arch/lib_helpers.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vb2_api.h>
+
+#define ID_AA64ISAR0_SHA1_SHIFT		8
+#define ID_AA64ISAR0_SHA2_SHIFT		12
+#define ID_AA64ISAR0_FIELD_MASK		0xf
+
+/* Same bit in CPTR_EL2 and CPTR_EL3. */
+#define CPTR_TFP			(1 << 10)
+
+#define SHA_BLOCK_SIZE			64
+#define SHA1_DIGEST_SIZE		20
+#define SHA256_DIGEST_SIZE		32
+
+void sha1_ce_transform(uint32_t state[5], const uint8_t *data, size_t blocks);
+void sha256_ce_transform(uint32_t state[8], const uint8_t *data,
+			 size_t blocks);
+
+static const uint32_t sha1_init[5] = {
+	0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0,
+};
+
+static const uint32_t sha256_init[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+static struct {
+	enum vb2_hash_algorithm alg;
+	uint32_t state[8];
+	uint8_t buffer[SHA_BLOCK_SIZE];
+	uint64_t length;		/* total bytes hashed so far */
+} ctx;
+
+static int sha_ce_supported(enum vb2_hash_algorithm hash_alg)
+{
+	const uint64_t isar0 = raw_read_aa64isar0_el1();
+
+	switch (hash_alg) {
+	case VB2_HASH_SHA1:
+		return (isar0 >> ID_AA64ISAR0_SHA1_SHIFT) &
+		       ID_AA64ISAR0_FIELD_MASK;
+	case VB2_HASH_SHA256:
+		return (isar0 >> ID_AA64ISAR0_SHA2_SHIFT) &
+		       ID_AA64ISAR0_FIELD_MASK;
+	default:
+		return 0;
+	}
+}
+
+/* The SHA instructions operate on SIMD registers, which must not trap. */
+static void enable_simd(void)
+{
+	switch (get_current_el()) {
+	case EL1:
+		raw_write_cpacr_el1(raw_read_cpacr_el1() |
+				    CPACR_TRAP_FP_DISABLE);
+		break;
+	case EL2:
+		raw_write_cptr_el2(raw_read_cptr_el2() & ~CPTR_TFP);
+		break;
+	case EL3:
+		raw_write_cptr_el3(raw_read_cptr_el3() & ~CPTR_TFP);
+		break;
+	}
+	isb();
+}
+
+static void hash_blocks(const uint8_t *data, size_t blocks)
+{
+	if (ctx.alg == VB2_HASH_SHA1)
+		sha1_ce_transform(ctx.state, data, blocks);
+	else
+		sha256_ce_transform(ctx.state, data, blocks);
+}
+
+int vb2ex_hwcrypto_digest_init(enum vb2_hash_algorithm hash_alg,
+			       uint32_t data_size)
+{
+	if (!sha_ce_supported(hash_alg))
+		return VB2_ERROR_EX_HWCRYPTO_UNSUPPORTED;
+
+	enable_simd();
+
+	ctx.alg = hash_alg;
+	ctx.length = 0;
+	if (hash_alg == VB2_HASH_SHA1)
+		memcpy(ctx.state, sha1_init, sizeof(sha1_init));
+	else
+		memcpy(ctx.state, sha256_init, sizeof(sha256_init));
+
+	return VB2_SUCCESS;
+}
+
+int vb2ex_hwcrypto_digest_extend(const uint8_t *buf, uint32_t size)
+{
+	size_t used = ctx.length % SHA_BLOCK_SIZE;
+
+	ctx.length += size;
+
+	if (used) {
+		const size_t fill = MIN(size, SHA_BLOCK_SIZE - used);
+		memcpy(&ctx.buffer[used], buf, fill);
+		buf += fill;
+		size -= fill;
+		if (used + fill < SHA_BLOCK_SIZE)
+			return VB2_SUCCESS;
+		hash_blocks(ctx.buffer, 1);
+	}
+
+	hash_blocks(buf, size / SHA_BLOCK_SIZE);
+	buf += size & ~(SHA_BLOCK_SIZE - 1);
+	size &= SHA_BLOCK_SIZE - 1;
+
+	memcpy(ctx.buffer, buf, size);
+	return VB2_SUCCESS;
+}
+
+int vb2ex_hwcrypto_digest_finalize(uint8_t *digest, uint32_t digest_size)
+{
+	const size_t size = ctx.alg == VB2_HASH_SHA1 ? SHA1_DIGEST_SIZE
+						     : SHA256_DIGEST_SIZE;
+	const uint64_t bits = ctx.length * 8;
+	size_t used = ctx.length % SHA_BLOCK_SIZE;
+	int i;
+
+	if (digest_size != size)
+		return VB2_ERROR_SHA_FINALIZE_DIGEST_SIZE;
+
+	ctx.buffer[used++] = 0x80;
+	if (used > SHA_BLOCK_SIZE - 8) {
+		memset(&ctx.buffer[used], 0, SHA_BLOCK_SIZE - used);
+		hash_blocks(ctx.buffer, 1);
+		used = 0;
+	}
+	memset(&ctx.buffer[used], 0, SHA_BLOCK_SIZE - 8 - used);
+	for (i = 0; i < 8; i++)
+		ctx.buffer[SHA_BLOCK_SIZE - 1 - i] = bits >> (i * 8);
+	hash_blocks(ctx.buffer, 1);
+
+	for (i = 0; i < size; i++)
+		digest[i] = ctx.state[i / 4] >> ((3 - i % 4) * 8);
+
+	memset(&ctx, 0, sizeof(ctx));
+	return VB2_SUCCESS;
+}
@@ -386,6 +386,16 @@ uint32_t raw_read_ctr_el0(void)
 	return ctr_el0;
 }
 
+/* DCZID */
+uint32_t raw_read_dczid_el0(void)
+{
+	uint32_t dczid_el0;
+
+	__asm__ __volatile__("mrs %0, DCZID_EL0\n\t" : "=r" (dczid_el0) :  : "memory");
+
+	return dczid_el0;
+}
+
 /* ESR */
 uint32_t raw_read_esr_el1(void)
 {
@@ -541,6 +551,16 @@ uint64_t raw_read_aa64pfr0_el1(void)
 	return aa64pfr0_el1;
 }
 
+/* AA64ISAR0 */
+uint64_t raw_read_aa64isar0_el1(void)
+{
+	uint64_t aa64isar0_el1;
+
+	__asm__ __volatile__("mrs %0, ID_AA64ISAR0_EL1\n\t" : "=r" (aa64isar0_el1) :  : "memory");
+
+	return aa64isar0_el1;
+}
+
 /* MAIR */
 uint64_t raw_read_mair_el1(void)
 {
@@ -20,7 +20,7 @@
 #include <gic.h>
 #include <string.h>
 #include <stdlib.h>
-#include <smp/spinlock.h>
+#include <arch/smp/spinlock.h>
 #include <arch/cpu.h>
 #include <arch/psci.h>
 #include <arch/smc.h>
@@ -29,8 +29,6 @@
 #include <console/console.h>
 #include "secmon.h"
 
-DECLARE_SPIN_LOCK(psci_spinlock);
-
 /* Root of PSCI node tree. */
 static struct psci_node psci_root;
 
@@ -38,14 +36,14 @@ static struct psci_node psci_root;
 static size_t psci_num_nodes;
 static struct psci_node **psci_nodes;
 
-static inline void psci_lock(void)
+static inline void psci_node_lock(struct psci_node *e)
 {
-	spin_lock(&psci_spinlock);
+	spin_lock(&e->lock);
 }
 
-static inline void psci_unlock(void)
+static inline void psci_node_unlock(struct psci_node *e)
 {
-	spin_unlock(&psci_spinlock);
+	spin_unlock(&e->lock);
 }
 
 static inline int psci_state_locked(const struct psci_node *e)
@@ -81,62 +79,93 @@ static inline struct psci_node *node_self(void)
 	return psci_node_lookup(cpu_info()->mpidr, PSCI_AFFINITY_LEVEL_0);
 }
 
-/* Find the ancestor of node affected by a state transition limited by level. */
-static struct psci_node *psci_find_ancestor(struct psci_node *e, int level,
-						int state)
+/*
+ * Lock the nodes from e up to and including the parent of ancestor. The
+ * parent's lock is what allows the ancestor's state to be written.
+ */
+static void psci_lock_hierarchy(struct psci_node *e,
+				struct psci_node *ancestor)
 {
-	struct psci_node *p;
+	struct psci_node *end = psci_node_parent(ancestor);
 
-	/* If all siblings of the node are already off then parent can be
-	 * set to off as well. */
-	if (state == PSCI_STATE_OFF) {
-		while (1) {
-			size_t i;
-			struct psci_node *s;
-
-			if (psci_root_node(e))
-				return e;
+	psci_node_lock(e);
+	while (e != end) {
+		e = psci_node_parent(e);
+		if (e != NULL)
+			psci_node_lock(e);
+	}
+}
 
-			p = psci_node_parent(e);
+static void psci_unlock_hierarchy(struct psci_node *e,
+					struct psci_node *ancestor)
+{
+	struct psci_node *end = psci_node_parent(ancestor);
 
-			if (p->level > level)
-				return e;
+	psci_node_unlock(e);
+	while (e != end) {
+		e = psci_node_parent(e);
+		if (e != NULL)
+			psci_node_unlock(e);
+	}
+}
 
-			for (i = 0; i < p->children.num; i++) {
-				s = &p->children.nodes[i];
-				/* Don't check target. */
-				if (s == e)
-					continue;
-				if (psci_state_locked(s) != PSCI_STATE_OFF)
-					return e;
-			}
+/* Is parent p affected by child e making a transition to state? */
+static int psci_parent_affected(struct psci_node *p, struct psci_node *e,
+				int state)
+{
+	size_t i;
 
-			e = p;
+	/* If all siblings of the node are already off then parent can be
+	 * set to off as well. */
+	if (state == PSCI_STATE_OFF) {
+		for (i = 0; i < p->children.num; i++) {
+			struct psci_node *s = &p->children.nodes[i];
+
+			/* Don't check target. */
+			if (s == e)
+				continue;
+			if (psci_state_locked(s) != PSCI_STATE_OFF)
+				return 0;
 		}
+		return 1;
 	}
 
 	/* All ancestors in state OFF are affected. */
-	if (state == PSCI_STATE_ON_PENDING) {
-		while (1) {
-			/* At the root. Return last affected node. */
-			if (psci_root_node(e))
-				return e;
+	if (state == PSCI_STATE_ON_PENDING)
+		return psci_state_locked(p) == PSCI_STATE_OFF;
+
+	return 0;
+}
+
+/*
+ * Find the ancestor of node affected by a state transition limited by level.
+ * The locks are taken on the way up: every parent is locked before it is
+ * looked at, so on return the nodes from e up to the parent of the returned
+ * ancestor are locked, as psci_lock_hierarchy() would have done.
+ */
+static struct psci_node *psci_lock_ancestor(struct psci_node *e, int level,
+						int state)
+{
+	struct psci_node *p;
 
-			p = psci_node_parent(e);
+	psci_node_lock(e);
 
-			if (p->level > level)
-				return e;
+	while (1) {
+		/* At the root. Return last affected node. */
+		if (psci_root_node(e))
+			return e;
 
-			/* This parent is already ON. */
-			if (psci_state_locked(p) != PSCI_STATE_OFF)
-				return e;
+		p = psci_node_parent(e);
+		psci_node_lock(p);
 
-			e = p;
-		}
-	}
+		if (p->level > level)
+			return e;
 
-	/* Default to returning node passed in. */
-	return e;
+		if (!psci_parent_affected(p, e, state))
+			return e;
+
+		e = p;
+	}
 }
 
 static void psci_set_hierarchy_state(struct psci_node *from,
@@ -156,15 +185,22 @@ static void psci_set_hierarchy_state(struct psci_node *from,
 	}
 }
 
+static void psci_update_hierarchy_state(struct psci_node *from,
+					struct psci_node *to,
+					int state)
+{
+	psci_lock_hierarchy(from, to);
+	psci_set_hierarchy_state(from, to, state);
+	psci_unlock_hierarchy(from, to);
+}
+
 static void psci_cpu_on_callback(void *arg)
 {
 	struct exc_state state;
 	int target_el;
 	struct psci_node *e = arg;
 
-	psci_lock();
-	psci_set_hierarchy_state(e, e->cpu_state.ancestor, PSCI_STATE_ON);
-	psci_unlock();
+	psci_update_hierarchy_state(e, e->cpu_state.ancestor, PSCI_STATE_ON);
 
 	/* Target EL is determined if HVC is enabled or not. */
 	target_el = (raw_read_scr_el3() & SCR_HVC_ENABLE) ? EL2 : EL1;
@@ -175,18 +211,14 @@ static void psci_cpu_on_callback(void *arg)
 				e->cpu_state.startup.arg, &state);
 }
 
+/* The target and cmd->ancestor need to be locked. */
 static void psci_cpu_on_prepare(struct psci_cmd *cmd,
 				const struct cpu_action *a)
 {
-	struct psci_node *ancestor;
-	struct psci_node *e;
-	int state = PSCI_STATE_ON_PENDING;
+	struct psci_node *e = cmd->target;
 
-	e = cmd->target;
 	e->cpu_state.startup = *a;
-	ancestor = psci_find_ancestor(e, PSCI_AFFINITY_LEVEL_HIGHEST, state);
-	e->cpu_state.ancestor = ancestor;
-	cmd->ancestor = ancestor;
+	e->cpu_state.ancestor = cmd->ancestor;
 }
 
 static int psci_schedule_cpu_on(struct psci_node *e)
@@ -199,7 +231,7 @@ static int psci_schedule_cpu_on(struct psci_node *e)
 
 	ci = e->cpu_state.ci;
 	if (ci == NULL || arch_run_on_cpu_async(ci->id, &action)) {
-		psci_set_hierarchy_state(e, e->cpu_state.ancestor,
+		psci_update_hierarchy_state(e, e->cpu_state.ancestor,
 						PSCI_STATE_OFF);
 		return PSCI_RET_INTERNAL_FAILURE;
 	}
@@ -207,18 +239,14 @@ static int psci_schedule_cpu_on(struct psci_node *e)
 	return PSCI_RET_SUCCESS;
 }
 
+/* The target and cmd->ancestor need to be locked. */
 static void psci_cpu_resume_prepare(struct psci_cmd *cmd,
 				const struct cpu_action *a)
 {
-	struct psci_node *ancestor;
-	struct psci_node *e;
-	int state = PSCI_STATE_ON_PENDING;
+	struct psci_node *e = cmd->target;
 
-	e = cmd->target;
 	e->cpu_state.resume = *a;
-	ancestor = psci_find_ancestor(e, PSCI_AFFINITY_LEVEL_HIGHEST, state);
-	e->cpu_state.ancestor = ancestor;
-	cmd->ancestor = ancestor;
+	e->cpu_state.ancestor = cmd->ancestor;
 }
 
 static void psci_schedule_cpu_resume(struct psci_node *e)
@@ -249,11 +277,11 @@ void psci_turn_on_self(const struct cpu_action *action)
 	}
 
 	cmd.target = e;
-
-	psci_lock();
+	cmd.ancestor = psci_lock_ancestor(e, PSCI_AFFINITY_LEVEL_HIGHEST,
+						PSCI_STATE_ON_PENDING);
 	psci_cpu_on_prepare(&cmd, action);
 	psci_set_hierarchy_state(e, cmd.ancestor, PSCI_STATE_ON_PENDING);
-	psci_unlock();
+	psci_unlock_hierarchy(e, cmd.ancestor);
 
 	psci_schedule_cpu_on(e);
 }
@@ -272,7 +300,7 @@ void psci_cpu_entry(void)
 static void psci_cpu_resume(void *arg)
 {
 	uint64_t power_state = (uint64_t)arg;
-	struct psci_node *e;
+	struct psci_node *e = node_self();
 	struct psci_power_state state;
 	struct psci_cmd cmd = {
 		.type = PSCI_CMD_RESUME,
@@ -280,9 +308,8 @@ static void psci_cpu_resume(void *arg)
 
 	psci_power_state_unpack(power_state, &state);
 
-	psci_lock();
+	psci_node_lock(e);
 
-	e = node_self();
 	/* clear the resume action after resume */
 	e->cpu_state.resume.run = NULL;
 	e->cpu_state.resume.arg = NULL;
@@ -291,15 +318,13 @@ static void psci_cpu_resume(void *arg)
 	cmd.state = &state;
 	soc_psci_ops.cmd_prepare(&cmd);
 
-	psci_unlock();
+	psci_node_unlock(e);
 
 	soc_psci_ops.cmd_commit(&cmd);
 
-	psci_lock();
-	psci_set_hierarchy_state(e, e->cpu_state.ancestor, PSCI_STATE_ON);
-	psci_unlock();
+	psci_update_hierarchy_state(e, e->cpu_state.ancestor, PSCI_STATE_ON);
 
-	psci_schedule_cpu_on(node_self());
+	psci_schedule_cpu_on(e);
 }
 
 static void psci_cpu_suspend(struct psci_func *pf)
@@ -321,8 +346,6 @@ static void psci_cpu_suspend(struct psci_func *pf)
 	context_id = psci64_arg(pf, PSCI_PARAM_2);
 	psci_power_state_unpack(power_state, &state);
 
-	psci_lock();
-
 	e = node_self();
 	cmd.target = e;
 	cmd.state = &state;
@@ -331,6 +354,8 @@ static void psci_cpu_suspend(struct psci_func *pf)
 	resume_action.run = &psci_cpu_resume;
 	resume_action.arg = (void*)power_state;
 
+	cmd.ancestor = psci_lock_ancestor(e, PSCI_AFFINITY_LEVEL_HIGHEST,
+						PSCI_STATE_ON_PENDING);
 	psci_cpu_on_prepare(&cmd, &action);
 	psci_cpu_resume_prepare(&cmd, &resume_action);
 
@@ -339,7 +364,7 @@ static void psci_cpu_suspend(struct psci_func *pf)
 	if (ret == PSCI_RET_SUCCESS)
 		psci_set_hierarchy_state(e, cmd.ancestor, PSCI_STATE_OFF);
 
-	psci_unlock();
+	psci_unlock_hierarchy(e, cmd.ancestor);
 
 	if (ret != PSCI_RET_SUCCESS)
 		return psci32_return(pf, ret);
@@ -350,20 +375,18 @@ static void psci_cpu_suspend(struct psci_func *pf)
 
 	/* PSCI_POWER_STATE_TYPE_STANDBY mode only */
 
-	psci_lock();
+	cmd.ancestor = psci_lock_ancestor(e, PSCI_AFFINITY_LEVEL_HIGHEST,
+						PSCI_STATE_ON_PENDING);
 	resume_action.run = NULL;
 	resume_action.arg = NULL;
 	psci_cpu_resume_prepare(&cmd, &resume_action);
-	psci_unlock();
 
-	if (ret != PSCI_RET_SUCCESS)
-		return psci32_return(pf, ret);
+	if (ret == PSCI_RET_SUCCESS)
+		psci_set_hierarchy_state(e, cmd.ancestor, PSCI_STATE_ON);
 
-	psci_lock();
-	psci_set_hierarchy_state(e, e->cpu_state.ancestor, PSCI_STATE_ON);
-	psci_unlock();
+	psci_unlock_hierarchy(e, cmd.ancestor);
 
-	psci32_return(pf, PSCI_RET_SUCCESS);
+	psci32_return(pf, ret);
 }
 
 static void psci_cpu_on(struct psci_func *pf)
@@ -390,20 +413,21 @@ static void psci_cpu_on(struct psci_func *pf)
 		return;
 	}
 
-	psci_lock();
+	cmd.target = e;
+	cmd.ancestor = psci_lock_ancestor(e, PSCI_AFFINITY_LEVEL_HIGHEST,
+						PSCI_STATE_ON_PENDING);
 	cpu_state = psci_state_locked(e);
 
 	if (cpu_state == PSCI_STATE_ON_PENDING) {
 		psci32_return(pf, PSCI_RET_ON_PENDING);
-		psci_unlock();
+		psci_unlock_hierarchy(e, cmd.ancestor);
 		return;
 	} else if (cpu_state == PSCI_STATE_ON) {
 		psci32_return(pf, PSCI_RET_ALREADY_ON);
-		psci_unlock();
+		psci_unlock_hierarchy(e, cmd.ancestor);
 		return;
 	}
 
-	cmd.target = e;
 	action.run = (void *)entry;
 	action.arg = (void *)context_id;
 	psci_cpu_on_prepare(&cmd, &action);
@@ -414,7 +438,7 @@ static void psci_cpu_on(struct psci_func *pf)
 		psci_set_hierarchy_state(e, cmd.ancestor,
 					PSCI_STATE_ON_PENDING);
 
-	psci_unlock();
+	psci_unlock_hierarchy(e, cmd.ancestor);
 
 	if (ret != PSCI_RET_SUCCESS)
 		return psci32_return(pf, ret);
@@ -422,9 +446,7 @@ static void psci_cpu_on(struct psci_func *pf)
 	ret = soc_psci_ops.cmd_commit(&cmd);
 
 	if (ret != PSCI_RET_SUCCESS) {
-		psci_lock();
-		psci_set_hierarchy_state(e, cmd.ancestor, PSCI_STATE_OFF);
-		psci_unlock();
+		psci_update_hierarchy_state(e, cmd.ancestor, PSCI_STATE_OFF);
 		return psci32_return(pf, ret);
 	}
 
@@ -441,16 +463,14 @@ static int psci_turn_off_node(struct psci_node *e, int level,
 		.target = e,
 	};
 
-	psci_lock();
-
-	cmd.ancestor = psci_find_ancestor(e, level, PSCI_STATE_OFF);
+	cmd.ancestor = psci_lock_ancestor(e, level, PSCI_STATE_OFF);
 
 	ret = soc_psci_ops.cmd_prepare(&cmd);
 
 	if (ret == PSCI_RET_SUCCESS)
 		psci_set_hierarchy_state(e, cmd.ancestor, PSCI_STATE_OFF);
 
-	psci_unlock();
+	psci_unlock_hierarchy(e, cmd.ancestor);
 
 	if (ret != PSCI_RET_SUCCESS)
 		return ret;
@@ -465,9 +485,7 @@ static int psci_turn_off_node(struct psci_node *e, int level,
 		ret = PSCI_RET_INTERNAL_FAILURE;
 
 	/* Turn things back on. */
-	psci_lock();
-	psci_set_hierarchy_state(e, cmd.ancestor, PSCI_STATE_ON);
-	psci_unlock();
+	psci_update_hierarchy_state(e, cmd.ancestor, PSCI_STATE_ON);
 
 	return ret;
 }
@@ -535,6 +553,7 @@ static int psci_init_node(struct psci_node *e,
 	size_t num_children;
 
 	memset(e, 0, sizeof(*e));
+	e->lock = SPIN_LOCK_UNLOCKED;
 	e->mpidr = mpidr;
 	psci_set_state_locked(e, PSCI_STATE_OFF);
 	e->parent = parent;
@@ -22,6 +22,7 @@
 #include <arch/lib_helpers.h>
 #include <cpu/cpu.h>
 #include <console/console.h>
+#include <memclear.h>
 #include "cpu-internal.h"
 
 struct cpu_info cpu_infos[CONFIG_MAX_CPUS];
@@ -202,6 +203,83 @@ int arch_run_on_all_cpus_but_self_async(struct cpu_action *action)
 	return __arch_run_on_all_cpus_but_self(action, 0);
 }
 
+struct parallel_for_work {
+	int (*func)(int index, void *arg);
+	void *arg;
+	int count;
+	int workers;
+};
+
+struct parallel_for_slot {
+	struct parallel_for_work *work;
+	int worker;
+	int failed;
+	unsigned int done;
+};
+
+static void parallel_for_run(void *arg)
+{
+	struct parallel_for_slot *slot = arg;
+	struct parallel_for_work *work = slot->work;
+	int i;
+
+	for (i = slot->worker; i < work->count; i += work->workers)
+		if (work->func(i, work->arg) != 0)
+			slot->failed = 1;
+
+	store_release(&slot->done, 1);
+	sev();
+}
+
+/*
+ * Every online cpu takes every n-th index, the calling cpu included. The
+ * other cpus are expected to be idle in arch_cpu_wait_for_action(). Like
+ * arch_run_on_cpu() this waits for each of them for as long as it takes.
+ */
+int arch_parallel_for(int (*func)(int index, void *arg), void *arg, int count)
+{
+	struct parallel_for_work work = {
+		.func = func,
+		.arg = arg,
+		.count = count,
+	};
+	struct parallel_for_slot slots[CONFIG_MAX_CPUS];
+	struct cpu_action actions[CONFIG_MAX_CPUS];
+	unsigned int cpus[CONFIG_MAX_CPUS];
+	struct cpu_info *me = cpu_info();
+	int i, n = 1;
+	int ret = 0;
+
+	cpus[0] = smp_processor_id();
+	for (i = 0; i < CONFIG_MAX_CPUS; i++) {
+		struct cpu_info *ci = cpu_info_for_cpu(i);
+		if (ci != me && cpu_online(ci))
+			cpus[n++] = i;
+	}
+	work.workers = n;
+
+	for (i = 0; i < n; i++) {
+		slots[i].work = &work;
+		slots[i].worker = i;
+		slots[i].failed = 0;
+		slots[i].done = 0;
+		actions[i].run = parallel_for_run;
+		actions[i].arg = &slots[i];
+	}
+
+	for (i = 1; i < n; i++)
+		arch_run_on_cpu_async(cpus[i], &actions[i]);
+	parallel_for_run(&slots[0]);
+
+	for (i = 0; i < n; i++) {
+		while (!load_acquire(&slots[i].done))
+			wfe();
+		if (slots[i].failed)
+			ret = -1;
+	}
+
+	return ret;
+}
 
 void arch_cpu_wait_for_action(void)
 {
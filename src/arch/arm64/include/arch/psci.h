@@ -23,6 +23,7 @@
 #include <stdint.h>
 #include <arch/cpu.h>
 #include <arch/smc.h>
+#include <arch/smp/spinlock.h>
 
 /* PSCI v0.2 power state encoding for CPU_SUSPEND function */
 #define PSCI_0_2_POWER_STATE_ID_MASK	0xffff
@@ -93,12 +94,19 @@ struct psci_node_group {
 	struct psci_node *nodes;
 };
 
+/*
+ * Every node has its own lock. A node's state may be read with either its
+ * own lock or its parent's lock held, and is only written with both held.
+ * Locks are always taken from the leaf towards the root, so transitions of
+ * CPUs only contend on the levels they actually share.
+ */
 struct psci_node {
 	uint64_t mpidr;
 	/* Affinity level of node. */
 	int level;
 	/* Generic power state of this entity. */
 	int state;
+	spinlock_t lock;
 	/* The SoC can stash its own state accounting in here. */
 	int soc_state;
 	/* Parent of curernt entity. */
@@ -134,8 +142,8 @@ enum {
 /*
  * PSCI actions are serialized into a command for the SoC to process. There are
  * 2 phases of a command being processed: prepare and commit. The prepare() is
- * called with the PSCI locks held for the state of the PSCI nodes. If
- * successful, the appropriate locks will be dropped and commit() will be
+ * called with the locks of the nodes from target up to the parent of ancestor
+ * held. If successful, the locks will be dropped and commit() will be
  * called with the same structure. It is permissible for the SoC support code
  * to modify the struture passed in (e.g. to update the requested state_id to
  * reflect dynamic constraints on how deep of a state to enter).
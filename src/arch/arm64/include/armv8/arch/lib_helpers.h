@@ -141,6 +141,9 @@
 #define CPACR_TRAP_FP_EL0	(1 << CPACR_FPEN_SHIFT)
 #define CPACR_TRAP_FP_DISABLE	(3 << CPACR_FPEN_SHIFT)
 
+#define DCZID_BS_MASK		(0xf)
+#define DCZID_DZP		(1 << 4)
+
 #ifdef __ASSEMBLY__
 
 /* Macro to switch to label based on current el */
@@ -461,6 +464,7 @@ void raw_write_cptr_current(uint32_t cptr);
 uint32_t raw_read_csselr_el1(void);
 void raw_write_csselr_el1(uint32_t csselr_el1);
 uint32_t raw_read_ctr_el0(void);
+uint32_t raw_read_dczid_el0(void);
 uint32_t raw_read_esr_el1(void);
 void raw_write_esr_el1(uint32_t esr_el1);
 uint32_t raw_read_esr_el2(void);
@@ -484,6 +488,7 @@ void raw_write_far(uint64_t far, uint32_t el);
 uint64_t raw_read_hcr_el2(void);
 void raw_write_hcr_el2(uint64_t hcr_el2);
 uint64_t raw_read_aa64pfr0_el1(void);
+uint64_t raw_read_aa64isar0_el1(void);
 uint64_t raw_read_mair_el1(void);
 void raw_write_mair_el1(uint64_t mair_el1);
 uint64_t raw_read_mair_el2(void);
@@ -0,0 +1,50 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <arch/lib_helpers.h>
+#include <memclear.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Clear whole blocks with DC ZVA, which zeroes a block without reading
+ * it from memory first. The ragged ends are left to memset().
+ */
+void arch_memclear(void *base, size_t size)
+{
+	uint32_t dczid = raw_read_dczid_el0();
+	uintptr_t start = (uintptr_t)base;
+	uintptr_t end = start + size;
+	uintptr_t p;
+	size_t block;
+
+	block = sizeof(uint32_t) << (dczid & DCZID_BS_MASK);
+	p = ALIGN_UP(start, block);
+
+	if ((dczid & DCZID_DZP) || p >= end || end - p < block) {
+		memset(base, 0, size);
+		return;
+	}
+
+	memset(base, 0, p - start);
+	for (; end - p >= block; p += block)
+		dczva(p);
+	memset((void *)p, 0, end - p);
+}
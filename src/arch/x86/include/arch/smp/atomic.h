@@ -64,6 +64,25 @@ static __inline__ __attribute__((always_inline)) void atomic_dec(atomic_t *v)
 		:"m" (v->counter));
 }
 
+/**
+ * atomic_add_return - add and return
+ * @i: integer value to add
+ * @v: pointer of type atomic_t
+ *
+ * Atomically adds @i to @v and returns @i + @v.
+ */
+static __inline__ __attribute__((always_inline))
+int atomic_add_return(int i, atomic_t *v)
+{
+	int old = i;
+
+	__asm__ __volatile__(
+		"lock ; xaddl %0, %1"
+		:"+r" (old), "+m" (v->counter)
+		: : "memory");
+	return old + i;
+}
+
 
 
 #endif /* ARCH_SMP_ATOMIC_H */
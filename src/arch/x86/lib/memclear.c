@@ -0,0 +1,49 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <memclear.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Clear with non-temporal stores so that zeroing a large range does not
+ * evict everything else from the caches on the way.
+ */
+void arch_memclear(void *base, size_t size)
+{
+	uintptr_t p = ALIGN_UP((uintptr_t)base, 16);
+	uintptr_t end = (uintptr_t)base + size;
+
+	if (p >= end || end - p < 16) {
+		memset(base, 0, size);
+		return;
+	}
+
+	memset(base, 0, p - (uintptr_t)base);
+	for (; end - p >= 16; p += 16)
+		asm volatile (
+			"movnti %1, 0(%0)\n\t"
+			"movnti %1, 4(%0)\n\t"
+			"movnti %1, 8(%0)\n\t"
+			"movnti %1, 12(%0)\n\t"
+			: : "r" (p), "r" (0) : "memory");
+	asm volatile ("sfence" : : : "memory");
+	memset((void *)p, 0, end - p);
+}
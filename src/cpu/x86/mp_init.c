@@ -32,10 +32,12 @@
 #include <cpu/x86/mtrr.h>
 #include <cpu/x86/smm.h>
 #include <cpu/x86/mp.h>
+#include <bootstate.h>
 #include <delay.h>
 #include <device/device.h>
 #include <device/path.h>
 #include <lib.h>
+#include <memclear.h>
 #include <smp/atomic.h>
 #include <smp/spinlock.h>
 #include <symbols.h>
@@ -94,6 +96,32 @@ struct cpu_map {
 /* Keep track of apic and device structure for each cpu. */
 static struct cpu_map cpus[CONFIG_MAX_CPUS];
 
+/*
+ * Mailbox the APs poll for work once the flight plan is done. The BSP
+ * fills in the call and bumps generation, every AP runs the call once
+ * per generation and then increments cpus_done. A NULL func parks the
+ * APs. No locks are involved, the APs only ever poll and increment.
+ *
+ * func, arg and results usually point into the caller's stack frame, so
+ * the BSP may only return once no AP can touch them anymore. An AP counts
+ * itself in cpus_entered before it looks at closed, and the BSP sets
+ * closed before it looks at cpus_entered. On a timeout the BSP closes the
+ * mailbox and waits for the APs which got in, the others back out.
+ */
+struct mp_mailbox {
+	atomic_t generation;
+	atomic_t cpus_entered;
+	atomic_t cpus_done;
+	atomic_t closed;
+	mp_work_t func;
+	void *arg;
+	int *results;
+} __attribute__((aligned(CACHELINE_SIZE)));
+
+static struct mp_mailbox mp_mailbox;
+/* Number of APs waiting on the mailbox. 0 means do all work on the BSP. */
+static int mp_work_aps;
+
 static inline void barrier_wait(atomic_t *b)
 {
 	while (atomic_read(b) == 0) {
@@ -142,6 +170,39 @@ static void ap_do_flight_plan(void)
 	}
 }
 
+static void ap_wait_for_work(int cpu)
+{
+	int generation = 0;
+	mp_work_t func;
+	int ret;
+
+	while (1) {
+		while (atomic_read(&mp_mailbox.generation) == generation)
+			asm ("pause");
+		mfence();
+		generation = atomic_read(&mp_mailbox.generation);
+
+		atomic_inc(&mp_mailbox.cpus_entered);
+		if (atomic_read(&mp_mailbox.closed)) {
+			/* Too late, the BSP has stopped waiting for us. */
+			atomic_dec(&mp_mailbox.cpus_entered);
+			continue;
+		}
+
+		func = mp_mailbox.func;
+		if (func == NULL)
+			break;
+
+		ret = func(cpu, mp_mailbox.arg);
+		if (mp_mailbox.results != NULL)
+			mp_mailbox.results[cpu] = ret;
+		mfence();
+		atomic_inc(&mp_mailbox.cpus_done);
+	}
+
+	atomic_inc(&mp_mailbox.cpus_done);
+}
+
 /* By the time APs call ap_init() caching has been setup, and microcode has
  * been loaded. */
 static void asmlinkage ap_init(unsigned int cpu)
@@ -166,6 +227,9 @@ static void asmlinkage ap_init(unsigned int cpu)
 	/* Walk the flight plan */
 	ap_do_flight_plan();
 
+	if (IS_ENABLED(CONFIG_PARALLEL_MP_AP_WORK))
+		ap_wait_for_work(cpu);
+
 	/* Park the AP. */
 	stop_this_cpu();
 }
@@ -568,7 +632,14 @@ int mp_init(struct bus *cpu_bus, struct mp_params *p)
 	}
 
 	/* Walk the flight plan for the BSP. */
-	return bsp_do_flight_plan(p);
+	if (bsp_do_flight_plan(p) < 0)
+		return -1;
+
+	/* Only hand out work to APs known to have finished the plan. */
+	if (IS_ENABLED(CONFIG_PARALLEL_MP_AP_WORK))
+		mp_work_aps = num_aps;
+
+	return 0;
 }
 
 void mp_initialize_cpu(void *unused)
@@ -586,6 +657,160 @@ int mp_get_apic_id(int cpu_slot)
 	return cpus[cpu_slot].apic_id;
 }
 
+static void mp_post_work(mp_work_t func, void *arg, int *results)
+{
+	mp_mailbox.func = func;
+	mp_mailbox.arg = arg;
+	mp_mailbox.results = results;
+	atomic_set(&mp_mailbox.cpus_entered, 0);
+	atomic_set(&mp_mailbox.cpus_done, 0);
+	mfence();
+	atomic_inc(&mp_mailbox.generation);
+}
+
+static int mp_wait_for_work(long expire_us)
+{
+	int timeout;
+
+	timeout = wait_for_aps(&mp_mailbox.cpus_entered, mp_work_aps,
+			       expire_us, 10);
+	if (timeout) {
+		/* Keep the missing APs from picking up the work later. */
+		atomic_set(&mp_mailbox.closed, 1);
+		mfence();
+		printk(BIOS_ERR, "MP work timeout: %d/%d APs entered.\n",
+		       atomic_read(&mp_mailbox.cpus_entered), mp_work_aps);
+		/* The APs are in an unknown state, stop using them. */
+		mp_work_aps = 0;
+	}
+
+	/* The APs which did get in are still using the caller's data. */
+	while (atomic_read(&mp_mailbox.cpus_done) !=
+	       atomic_read(&mp_mailbox.cpus_entered))
+		asm ("pause");
+	mfence();
+	return timeout ? -1 : 0;
+}
+
+static int mp_check_results(int *results, int first, int last)
+{
+	int i;
+
+	if (results == NULL)
+		return 0;
+	for (i = first; i <= last; i++)
+		if (results[i] != 0)
+			return -1;
+	return 0;
+}
+
+int mp_run_on_all_aps(mp_work_t func, void *arg, int *results,
+		      long expire_us)
+{
+	int num_aps = mp_work_aps;
+
+	/* Without APs the work is done on the BSP. */
+	if (num_aps == 0)
+		return mp_run_on_all_cpus(func, arg, results, expire_us);
+
+	mp_post_work(func, arg, results);
+	if (mp_wait_for_work(expire_us))
+		return -1;
+	return mp_check_results(results, 1, num_aps);
+}
+
+int mp_run_on_all_cpus(mp_work_t func, void *arg, int *results,
+		       long expire_us)
+{
+	int num_aps = mp_work_aps;
+	int ret;
+
+	if (num_aps)
+		mp_post_work(func, arg, results);
+	ret = func(0, arg);
+	if (results != NULL)
+		results[0] = ret;
+	if (num_aps && mp_wait_for_work(expire_us))
+		return -1;
+	return mp_check_results(results, 0, num_aps);
+}
+
+struct mp_parallel_for_work {
+	int (*func)(int index, void *arg);
+	void *arg;
+	int count;
+	atomic_t next;
+	atomic_t failed;
+};
+
+static int mp_parallel_for_cpu(int cpu, void *arg)
+{
+	struct mp_parallel_for_work *work = arg;
+	int index;
+
+	while ((index = atomic_add_return(1, &work->next) - 1) < work->count)
+		if (work->func(index, work->arg) != 0)
+			atomic_inc(&work->failed);
+	return 0;
+}
+
+int mp_parallel_for(int (*func)(int index, void *arg), void *arg, int count,
+		    long expire_us)
+{
+	struct mp_parallel_for_work work = {
+		.func = func,
+		.arg = arg,
+		.count = count,
+		.next = ATOMIC_INIT(0),
+		.failed = ATOMIC_INIT(0),
+	};
+
+	/*
+	 * The BSP keeps taking indices until none are left and the APs
+	 * which took one are always waited for, so every index has been
+	 * handled even if some APs timed out.
+	 */
+	mp_run_on_all_cpus(mp_parallel_for_cpu, &work, NULL, expire_us);
+	return atomic_read(&work.failed) ? -1 : 0;
+}
+
+/*
+ * Let memclear() and friends use the APs. The BSP works through the
+ * indices itself, so by the time it waits the APs have long had a chance
+ * to pick the work up and a short timeout only catches dead ones.
+ */
+int arch_parallel_for(int (*func)(int index, void *arg), void *arg, int count)
+{
+	return mp_parallel_for(func, arg, count, 1000 /* 1 ms */);
+}
+
+int mp_num_aps_available(void)
+{
+	return mp_work_aps;
+}
+
+void mp_park_aps(void)
+{
+	if (mp_work_aps == 0)
+		return;
+
+	mp_post_work(NULL, NULL, NULL);
+	mp_wait_for_work(1000 /* 1 ms */);
+	mp_work_aps = 0;
+}
+
+static void mp_park_aps_cb(void *unused)
+{
+	mp_park_aps();
+}
+
+BOOT_STATE_INIT_ENTRIES(mp_park_aps_bscb) = {
+	BOOT_STATE_INIT_ENTRY(BS_OS_RESUME, BS_ON_ENTRY,
+			      mp_park_aps_cb, NULL),
+	BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY,
+			      mp_park_aps_cb, NULL),
+};
+
 void smm_initiate_relocation_parallel(void)
 {
 	if ((lapic_read(LAPIC_ICR) & LAPIC_ICR_BUSY)) {
@@ -227,61 +227,81 @@ static void read_resources(struct bus *bus)
 	       dev_path(bus->dev), bus->secondary, bus->link_num);
 }
 
-struct pick_largest_state {
-	struct resource *last;
-	struct device *result_dev;
-	struct resource *result;
-	int seen_last;
+/*
+ * The resources of the bus being worked on, largest alignment first and
+ * largest size next. Resources that compare equal stay in the order
+ * search_bus_resources() finds them. compute_resources() and
+ * allocate_resources() are done with one bus before sorting the next, so
+ * a single buffer is shared. It only ever grows since there is no free().
+ */
+struct sorted_resource {
+	struct device *dev;
+	struct resource *res;
 };
 
-static void pick_largest_resource(void *gp, struct device *dev,
-				  struct resource *resource)
+static struct sorted_resource *sorted_resources;
+static size_t sorted_resources_size;
+
+static int resource_goes_before(const struct resource *a,
+				const struct resource *b)
+{
+	return (a->align > b->align) ||
+	       ((a->align == b->align) && (a->size > b->size));
+}
+
+static void count_resource(void *gp, struct device *dev,
+			   struct resource *resource)
 {
-	struct pick_largest_state *state = gp;
-	struct resource *last;
+	size_t *count = gp;
 
-	last = state->last;
+	if (!(resource->flags & IORESOURCE_FIXED))
+		(*count)++;
+}
+
+static void insert_sorted_resource(void *gp, struct device *dev,
+				   struct resource *resource)
+{
+	size_t *count = gp;
+	size_t lo = 0, hi = *count;
 
-	/* Be certain to pick the successor to last. */
-	if (resource == last) {
-		state->seen_last = 1;
-		return;
-	}
 	if (resource->flags & IORESOURCE_FIXED)
 		return;	/* Skip it. */
-	if (last && ((last->align < resource->align) ||
-		     ((last->align == resource->align) &&
-		      (last->size < resource->size)) ||
-		     ((last->align == resource->align) &&
-		      (last->size == resource->size) && (!state->seen_last)))) {
-		return;
-	}
-	if (!state->result ||
-	    (state->result->align < resource->align) ||
-	    ((state->result->align == resource->align) &&
-	     (state->result->size < resource->size))) {
-		state->result_dev = dev;
-		state->result = resource;
+
+	/* Insert after all resources that don't sort below this one. */
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+
+		if (resource_goes_before(resource, sorted_resources[mid].res))
+			hi = mid;
+		else
+			lo = mid + 1;
 	}
+	memmove(&sorted_resources[lo + 1], &sorted_resources[lo],
+		(*count - lo) * sizeof(*sorted_resources));
+	sorted_resources[lo].dev = dev;
+	sorted_resources[lo].res = resource;
+	(*count)++;
 }
 
-static struct device *largest_resource(struct bus *bus,
-				       struct resource **result_res,
-				       unsigned long type_mask,
-				       unsigned long type)
+/*
+ * Collect the non-fixed resources of a bus in allocation order. Returns
+ * the number of entries placed in sorted_resources.
+ */
+static size_t sort_bus_resources(struct bus *bus, unsigned long type_mask,
+				 unsigned long type)
 {
-	struct pick_largest_state state;
-
-	state.last = *result_res;
-	state.result_dev = NULL;
-	state.result = NULL;
-	state.seen_last = 0;
+	size_t count = 0;
 
-	search_bus_resources(bus, type_mask, type, pick_largest_resource,
-			     &state);
+	search_bus_resources(bus, type_mask, type, count_resource, &count);
+	if (count > sorted_resources_size) {
+		sorted_resources = malloc(count * sizeof(*sorted_resources));
+		sorted_resources_size = count;
+	}
 
-	*result_res = state.result;
-	return state.result_dev;
+	count = 0;
+	search_bus_resources(bus, type_mask, type, insert_sorted_resource,
+			     &count);
+	return count;
 }
 
 /**
@@ -323,6 +343,7 @@ static void compute_resources(struct bus *bus, struct resource *bridge,
 	struct device *dev;
 	struct resource *resource;
 	resource_t base;
+	size_t i, count;
 	base = round(bridge->base, bridge->align);
 
 	printk(BIOS_SPEW,  "%s %s_%s: base: %llx size: %llx align: %d gran: %d"
@@ -372,15 +393,15 @@ static void compute_resources(struct bus *bus, struct resource *bridge,
 		}
 	}
 
-	/* Remember we haven't found anything yet. */
-	resource = NULL;
-
 	/*
 	 * Walk through all the resources on the current bus and compute the
 	 * amount of address space taken by them. Take granularity and
 	 * alignment into account.
 	 */
-	while ((dev = largest_resource(bus, &resource, type_mask, type))) {
+	count = sort_bus_resources(bus, type_mask, type);
+	for (i = 0; i < count; i++) {
+		dev = sorted_resources[i].dev;
+		resource = sorted_resources[i].res;
 
 		/* Size 0 resources can be skipped. */
 		if (!resource->size)
@@ -471,6 +492,7 @@ static void allocate_resources(struct bus *bus, struct resource *bridge,
 	struct device *dev;
 	struct resource *resource;
 	resource_t base;
+	size_t i, count;
 	base = bridge->base;
 
 	printk(BIOS_SPEW, "%s %s_%s: base:%llx size:%llx align:%d gran:%d "
@@ -479,14 +501,14 @@ static void allocate_resources(struct bus *bus, struct resource *bridge,
 	       "prefmem" : "mem",
 	       base, bridge->size, bridge->align, bridge->gran, bridge->limit);
 
-	/* Remember we haven't found anything yet. */
-	resource = NULL;
-
 	/*
 	 * Walk through all the resources on the current bus and allocate them
 	 * address space.
 	 */
-	while ((dev = largest_resource(bus, &resource, type_mask, type))) {
+	count = sort_bus_resources(bus, type_mask, type);
+	for (i = 0; i < count; i++) {
+		dev = sorted_resources[i].dev;
+		resource = sorted_resources[i].res;
 
 		/* Propagate the bridge limit to the resource register. */
 		if (resource->limit > bridge->limit)
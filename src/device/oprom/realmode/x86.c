@@ -280,7 +280,13 @@ void vbe_set_graphics(void)
 		return;
 	}
 	int ret = 0;
-	ret = jpeg_decode(jpeg, framebuffer, 1024, 768, 16, decdata);
+	int scale = jpeg_fit_scale(1024, 768,
+				   le16_to_cpu(mode_info.vesa.x_resolution),
+				   le16_to_cpu(mode_info.vesa.y_resolution));
+	ret = jpeg_decode_fb(jpeg, framebuffer, 1024, 768,
+			     mode_info.vesa.bits_per_pixel,
+			     le16_to_cpu(mode_info.vesa.bytes_per_scanline),
+			     scale, decdata);
 #endif
 }
 
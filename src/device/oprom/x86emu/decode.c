@@ -41,6 +41,108 @@
 
 /*----------------------------- Implementation ----------------------------*/
 
+#if CONFIG_X86EMU_FETCH_CACHE
+/*
+ * Instruction fetch cache. Option ROMs spend most of their time in short
+ * loops, and without the cache every opcode, ModR/M and immediate byte is
+ * read through the (*sys_rdX) callbacks, which in YABEL means another
+ * address translation per byte. Lines are filled with sys_rdl reads and
+ * invalidated by the store_data_* and push functions, so self-modifying
+ * code keeps working. Memory written behind the emulator's back (by the
+ * interrupt callbacks) is handled by flushing the whole cache after each
+ * callback.
+ */
+#define FETCH_LINE_SHIFT	6
+#define FETCH_LINE_SIZE		(1 << FETCH_LINE_SHIFT)
+#define FETCH_LINE_MASK		(FETCH_LINE_SIZE - 1)
+#define FETCH_LINES		256
+
+static struct {
+    u32 tag[FETCH_LINES];	/* line number + 1, 0 if invalid */
+    u8  data[FETCH_LINES][FETCH_LINE_SIZE];
+} fetch_cache;
+
+/****************************************************************************
+REMARKS:
+Drops all cached instruction bytes.
+****************************************************************************/
+void x86emu_fetch_flush(void)
+{
+    memset(fetch_cache.tag, 0, sizeof(fetch_cache.tag));
+}
+
+/****************************************************************************
+PARAMETERS:
+addr    - Linear address of the write
+len     - Length of the write in bytes
+
+REMARKS:
+Drops the cached instruction bytes a memory write overlaps with.
+****************************************************************************/
+void x86emu_fetch_invalidate(
+    u32 addr,
+    u32 len)
+{
+    u32 line = addr >> FETCH_LINE_SHIFT;
+    u32 last = (addr + len - 1) >> FETCH_LINE_SHIFT;
+
+    for (; line <= last; line++) {
+        if (fetch_cache.tag[line % FETCH_LINES] == line + 1)
+            fetch_cache.tag[line % FETCH_LINES] = 0;
+    }
+}
+
+static u8 *fetch_line(
+    u32 addr)
+{
+    u32 line = addr >> FETCH_LINE_SHIFT;
+    u32 idx = line % FETCH_LINES;
+    u32 val;
+    int i;
+
+    if (fetch_cache.tag[idx] != line + 1) {
+        for (i = 0; i < FETCH_LINE_SIZE; i += 4) {
+            val = (*sys_rdl)((line << FETCH_LINE_SHIFT) + i);
+            fetch_cache.data[idx][i] = (u8)val;
+            fetch_cache.data[idx][i + 1] = (u8)(val >> 8);
+            fetch_cache.data[idx][i + 2] = (u8)(val >> 16);
+            fetch_cache.data[idx][i + 3] = (u8)(val >> 24);
+        }
+        fetch_cache.tag[idx] = line + 1;
+    }
+    return fetch_cache.data[idx];
+}
+
+static inline u8 fetch_code_byte(
+    u32 addr)
+{
+    return fetch_line(addr)[addr & FETCH_LINE_MASK];
+}
+
+static u32 fetch_code(
+    u32 addr,
+    int len)
+{
+    u32 val = 0;
+    u8 *p;
+    int i;
+
+    if ((addr & FETCH_LINE_MASK) + len <= FETCH_LINE_SIZE) {
+        p = fetch_line(addr) + (addr & FETCH_LINE_MASK);
+        for (i = len - 1; i >= 0; i--)
+            val = (val << 8) | p[i];
+    } else {
+        for (i = 0; i < len; i++)
+            val |= (u32)fetch_code_byte(addr + i) << (i * 8);
+    }
+    return val;
+}
+#else
+#define fetch_code_byte(addr)	(*sys_rdb)(addr)
+#define fetch_code(addr, len)	\
+    ((len) == 2 ? (*sys_rdw)(addr) : (*sys_rdl)(addr))
+#endif
+
 /****************************************************************************
 REMARKS:
 Handles any pending asychronous interrupts.
@@ -53,6 +155,7 @@ static void x86emu_intr_handle(void)
         intno = M.x86.intno;
         if (_X86EMU_intrTab[intno]) {
             (*_X86EMU_intrTab[intno])(intno);
+            x86emu_fetch_flush();
         } else {
             push_word((u16)M.x86.R_FLG);
             CLEAR_FLAG(F_IF);
@@ -94,6 +197,7 @@ void X86EMU_exec(void)
     u8 op1;
 
     M.x86.intr = 0;
+    x86emu_fetch_flush();
     DB(x86emu_end_instr();)
 
     for (;;) {
@@ -119,7 +223,7 @@ DB(             if (M.x86.R_SP != 0) {
                 x86emu_intr_handle();
             }
         }
-        op1 = (*sys_rdb)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
+        op1 = fetch_code_byte(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
         (*x86emu_optab[op1])(op1);
         //if (M.x86.debug & DEBUG_EXIT) {
         //    M.x86.debug &= ~DEBUG_EXIT;
@@ -158,7 +262,7 @@ void fetch_decode_modrm(
 
 DB( if (CHECK_IP_FETCH())
         x86emu_check_ip_access();)
-    fetched = (*sys_rdb)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
+    fetched = fetch_code_byte(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
     INC_DECODED_INST_LEN(1);
     *mod  = (fetched >> 6) & 0x03;
     *regh = (fetched >> 3) & 0x07;
@@ -181,7 +285,7 @@ u8 fetch_byte_imm(void)
 
 DB( if (CHECK_IP_FETCH())
         x86emu_check_ip_access();)
-    fetched = (*sys_rdb)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
+    fetched = fetch_code_byte(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
     INC_DECODED_INST_LEN(1);
     return fetched;
 }
@@ -202,7 +306,7 @@ u16 fetch_word_imm(void)
 
 DB( if (CHECK_IP_FETCH())
         x86emu_check_ip_access();)
-    fetched = (*sys_rdw)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP));
+    fetched = fetch_code(((u32)M.x86.R_CS << 4) + (M.x86.R_IP), 2);
     M.x86.R_IP += 2;
     INC_DECODED_INST_LEN(2);
     return fetched;
@@ -224,7 +328,7 @@ u32 fetch_long_imm(void)
 
 DB( if (CHECK_IP_FETCH())
         x86emu_check_ip_access();)
-    fetched = (*sys_rdl)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP));
+    fetched = fetch_code(((u32)M.x86.R_CS << 4) + (M.x86.R_IP), 4);
     M.x86.R_IP += 4;
     INC_DECODED_INST_LEN(4);
     return fetched;
@@ -432,6 +536,7 @@ void store_data_byte(
     if (CHECK_DATA_ACCESS())
         x86emu_check_data_access((u16)get_data_segment(), offset);
 #endif
+    x86emu_fetch_invalidate((get_data_segment() << 4) + offset, 1);
     (*sys_wrb)((get_data_segment() << 4) + offset, val);
 }
 
@@ -454,6 +559,7 @@ void store_data_word(
     if (CHECK_DATA_ACCESS())
         x86emu_check_data_access((u16)get_data_segment(), offset);
 #endif
+    x86emu_fetch_invalidate((get_data_segment() << 4) + offset, 2);
     (*sys_wrw)((get_data_segment() << 4) + offset, val);
 }
 
@@ -476,6 +582,7 @@ void store_data_long(
     if (CHECK_DATA_ACCESS())
         x86emu_check_data_access((u16)get_data_segment(), offset);
 #endif
+    x86emu_fetch_invalidate((get_data_segment() << 4) + offset, 4);
     (*sys_wrl)((get_data_segment() << 4) + offset, val);
 }
 
@@ -499,6 +606,7 @@ void store_data_byte_abs(
     if (CHECK_DATA_ACCESS())
         x86emu_check_data_access(segment, offset);
 #endif
+    x86emu_fetch_invalidate(((u32)segment << 4) + offset, 1);
     (*sys_wrb)(((u32)segment << 4) + offset, val);
 }
 
@@ -522,6 +630,7 @@ void store_data_word_abs(
     if (CHECK_DATA_ACCESS())
         x86emu_check_data_access(segment, offset);
 #endif
+    x86emu_fetch_invalidate(((u32)segment << 4) + offset, 2);
     (*sys_wrw)(((u32)segment << 4) + offset, val);
 }
 
@@ -545,6 +654,7 @@ void store_data_long_abs(
     if (CHECK_DATA_ACCESS())
         x86emu_check_data_access(segment, offset);
 #endif
+    x86emu_fetch_invalidate(((u32)segment << 4) + offset, 4);
     (*sys_wrl)(((u32)segment << 4) + offset, val);
 }
 
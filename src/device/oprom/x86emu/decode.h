@@ -56,6 +56,13 @@ extern "C" {            			/* Use "C" linkage when in C++ mode */
 #endif
 
 void 	x86emu_intr_raise (u8 type);
+#if CONFIG_X86EMU_FETCH_CACHE
+void    x86emu_fetch_flush (void);
+void    x86emu_fetch_invalidate (u32 addr, u32 len);
+#else
+static inline void x86emu_fetch_flush (void) {}
+static inline void x86emu_fetch_invalidate (u32 addr, u32 len) {}
+#endif
 void    fetch_decode_modrm (int *mod,int *regh,int *regl);
 u8      fetch_byte_imm (void);
 u16     fetch_word_imm (void);
@@ -496,8 +496,7 @@ Handles opcode 0x0f. Escape for two-byte opcode (286 or better)
 ****************************************************************************/
 static void x86emuOp_two_byte(u8 X86EMU_UNUSED(op1))
 {
-    u8 op2 = (*sys_rdb)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
-    INC_DECODED_INST_LEN(1);
+    u8 op2 = fetch_byte_imm();
     (*x86emu_optab2[op2])(op2);
 }
 
@@ -3582,6 +3581,7 @@ static void x86emuOp_int3(u8 X86EMU_UNUSED(op1))
     TRACE_AND_STEP();
 	if (_X86EMU_intrTab[3]) {
 		(*_X86EMU_intrTab[3])(3);
+		x86emu_fetch_flush();
     } else {
         push_word((u16)M.x86.R_FLG);
         CLEAR_FLAG(F_IF);
@@ -3612,6 +3612,7 @@ static void x86emuOp_int_IMM(u8 X86EMU_UNUSED(op1))
     TRACE_AND_STEP();
 	if (_X86EMU_intrTab[intnum]) {
 		(*_X86EMU_intrTab[intnum])(intnum);
+		x86emu_fetch_flush();
     } else {
         push_word((u16)M.x86.R_FLG);
         CLEAR_FLAG(F_IF);
@@ -3640,6 +3641,7 @@ static void x86emuOp_into(u8 X86EMU_UNUSED(op1))
         tmp = mem_access_word(4 * 4 + 2);
 		if (_X86EMU_intrTab[4]) {
 			(*_X86EMU_intrTab[4])(4);
+			x86emu_fetch_flush();
         } else {
             push_word((u16)M.x86.R_FLG);
             CLEAR_FLAG(F_IF);
@@ -2397,6 +2397,7 @@ void push_word(u16 w)
 DB( if (CHECK_SP_ACCESS())
       x86emu_check_sp_access();)
     M.x86.R_SP -= 2;
+    x86emu_fetch_invalidate(((u32)M.x86.R_SS << 4) + M.x86.R_SP, 2);
     (*sys_wrw)(((u32)M.x86.R_SS << 4)  + M.x86.R_SP, w);
 }
 
@@ -2411,6 +2412,7 @@ void push_long(u32 w)
 DB( if (CHECK_SP_ACCESS())
       x86emu_check_sp_access();)
     M.x86.R_SP -= 4;
+    x86emu_fetch_invalidate(((u32)M.x86.R_SS << 4) + M.x86.R_SP, 4);
     (*sys_wrl)(((u32)M.x86.R_SS << 4)  + M.x86.R_SP, w);
 }
 
@@ -16,6 +16,7 @@
 #include "compat/rtas.h"
 #include <string.h>
 #include "debug.h"
+#include "mem.h"
 
 #include <device/device.h>
 #include <device/pci.h>
@@ -110,6 +111,7 @@ biosemu_dev_get_addr_info(void)
 	}
 	// store last entry index of translate_address_array
 	taa_last_entry = taa_index - 1;
+	biosemu_mem_tlb_flush();
 #if CONFIG_X86EMU_DEBUG
 	//dump translate_address_array
 	printf("translate_address_array: \n");
@@ -194,6 +196,7 @@ biosemu_dev_get_addr_info(void)
 	}
 	// store last entry index of translate_address_array
 	taa_last_entry = taa_index - 1;
+	biosemu_mem_tlb_flush();
 #if CONFIG_X86EMU_DEBUG
 	//dump translate_address_array
 	printf("translate_address_array: \n");
@@ -224,6 +227,7 @@ biosemu_add_special_memory(u32 start, u32 size)
 	translate_address_array[taa_index].size = size;
 	/* dont translate addresses... all addresses are 1:1 */
 	translate_address_array[taa_index].address_offset = 0;
+	biosemu_mem_tlb_flush();
 }
 
 #if !CONFIG_PCI_OPTION_ROM_RUN_YABEL
@@ -19,6 +19,7 @@
 #include <x86emu/x86emu.h>
 #include <device/oprom/include/io.h>
 #include "io.h"
+#include "mem.h"
 
 #if CONFIG_PCI_OPTION_ROM_RUN_YABEL
 #include <device/pci.h>
@@ -552,6 +553,10 @@ pci_cfg_write(X86EMU_pioAddr addr, u32 val, u8 size)
 				DEBUG_PRINTF_IO
 				    ("%s(%04x) PCI Config Write @%02x, size: %d <-- 0x%08x\n",
 				     __func__, addr, offs, size, val);
+				// moving a BAR invalidates cached translations
+				if (((offs >= 0x10) && (offs < 0x28))
+				    || ((offs >= 0x30) && (offs < 0x34)))
+					biosemu_mem_tlb_flush();
 			}
 		}
 	}
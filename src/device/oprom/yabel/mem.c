@@ -18,6 +18,7 @@
 #include "biosemu.h"
 #include "mem.h"
 #include "compat/time.h"
+#include <string.h>
 
 #if !CONFIG_YABEL_DIRECTHW || !CONFIG_YABEL_DIRECTHW
 
@@ -170,6 +171,168 @@ static inline void DEBUG_CHECK_VMEM_READ(u32 _addr, u32 _rval) {};
 static inline void DEBUG_CHECK_VMEM_WRITE(u32 _addr, u32 _val) {};
 #endif
 
+/*
+ * Software TLB for the emulated memory accesses. Without it, every access
+ * walks translate_address_array to find out whether it hits a device
+ * range or the virtual memory. Pages are small because the "special
+ * memory" ranges (IVT + BDA, option ROM segment) are not 4K aligned; a
+ * page that is only partly covered by a range is never cached and always
+ * takes the slow path below. The TLB has to be flushed with
+ * biosemu_mem_tlb_flush() whenever translate_address_array or the BARs
+ * of the device change.
+ */
+#define TLB_PAGE_SHIFT	8
+#define TLB_PAGE_SIZE	(1 << TLB_PAGE_SHIFT)
+#define TLB_ENTRIES	256
+
+enum {
+	TLB_INVALID = 0,
+	TLB_RAM,	/* virtual memory at M.mem_base */
+	TLB_MMIO,	/* device memory, translated by offset */
+	TLB_LEGACY,	/* legacy VGA memory, byte accesses only */
+};
+
+typedef struct {
+	u32 page;
+	u8 type;
+	unsigned long offset;
+} tlb_entry_t;
+
+static tlb_entry_t mem_tlb[TLB_ENTRIES];
+
+void
+biosemu_mem_tlb_flush(void)
+{
+	memset(mem_tlb, 0, sizeof(mem_tlb));
+}
+
+static tlb_entry_t *
+tlb_fill(tlb_entry_t *e, u32 page)
+{
+	u64 start = (u64) page << TLB_PAGE_SHIFT;
+	u64 end = start + TLB_PAGE_SIZE - 1;
+	translate_address_t *ta;
+	int i;
+
+#if !CONFIG_PCI_OPTION_ROM_RUN_YABEL
+	/* legacy VGA memory may be remapped to the vmem BAR */
+	if (end >= 0xa0000 && start < 0xc0000)
+		return NULL;
+#endif
+	for (i = 0; i <= taa_last_entry; i++) {
+		ta = &translate_address_array[i];
+		if (!(ta->info & IORESOURCE_MEM) || end < ta->address
+		    || start > ta->address + ta->size)
+			continue;
+		/* the first overlapping range wins, as in the slow path */
+		if (start < ta->address || end > ta->address + ta->size)
+			return NULL;
+		e->type = (start >= 0xa0000 && end < 0xc0000) ?
+			TLB_LEGACY : TLB_MMIO;
+		e->offset = ta->address_offset;
+		e->page = page;
+		return e;
+	}
+	if (end >= M.mem_size)
+		return NULL;
+	e->type = TLB_RAM;
+	e->offset = 0;
+	e->page = page;
+	return e;
+}
+
+/*
+ * Look up the page of an access of len bytes. Returns NULL if the access
+ * has to go through biosemu_dev_translate_address().
+ */
+static inline tlb_entry_t *
+tlb_lookup(u32 addr, u32 len)
+{
+	u32 page = addr >> TLB_PAGE_SHIFT;
+	tlb_entry_t *e = &mem_tlb[page % TLB_ENTRIES];
+
+	if (((addr + len - 1) >> TLB_PAGE_SHIFT) != page)
+		return NULL;
+#if CONFIG_X86EMU_DEBUG
+	if (debug_flags & (DEBUG_MEM | DEBUG_CHECK_VMEM_ACCESS))
+		return NULL;
+#endif
+	if (e->type != TLB_INVALID && e->page == page)
+		return e;
+	return tlb_fill(e, page);
+}
+
+/* Read len bytes through the TLB. Returns 0 if the slow path is needed. */
+static inline int
+tlb_read(u32 addr, u32 len, u32 *val)
+{
+	tlb_entry_t *e = tlb_lookup(addr, len);
+	unsigned long p;
+	u32 i;
+
+	if (e == NULL)
+		return 0;
+	if (e->type == TLB_RAM) {
+		p = M.mem_base + addr;
+		if (len == 1)
+			*val = *((u8 *) p);
+		else if (len == 2)
+			*val = in16le((void *) p);
+		else
+			*val = in32le((void *) p);
+		return 1;
+	}
+	p = addr + e->offset;
+	set_ci();
+	if (e->type == TLB_MMIO && len == 2 && (p & 0x1) == 0) {
+		*val = in16le((void *) p);
+	} else if (e->type == TLB_MMIO && len == 4 && (p & 0x3) == 0) {
+		*val = in32le((void *) p);
+	} else {
+		// legacy VGA memory or unaligned access, read single bytes
+		*val = 0;
+		for (i = 0; i < len; i++)
+			*val |= (u32) *((u8 *) p + i) << (i * 8);
+	}
+	clr_ci();
+	return 1;
+}
+
+/* Write len bytes through the TLB. Returns 0 if the slow path is needed. */
+static inline int
+tlb_write(u32 addr, u32 len, u32 val)
+{
+	tlb_entry_t *e = tlb_lookup(addr, len);
+	unsigned long p;
+	u32 i;
+
+	if (e == NULL)
+		return 0;
+	if (e->type == TLB_RAM) {
+		p = M.mem_base + addr;
+		if (len == 1)
+			*((u8 *) p) = val;
+		else if (len == 2)
+			out16le((void *) p, val);
+		else
+			out32le((void *) p, val);
+		return 1;
+	}
+	p = addr + e->offset;
+	set_ci();
+	if (e->type == TLB_MMIO && len == 2 && (p & 0x1) == 0) {
+		out16le((void *) p, val);
+	} else if (e->type == TLB_MMIO && len == 4 && (p & 0x3) == 0) {
+		out32le((void *) p, val);
+	} else {
+		// legacy VGA memory or unaligned access, write single bytes
+		for (i = 0; i < len; i++)
+			*((u8 *) p + i) = (u8) (val >> (i * 8));
+	}
+	clr_ci();
+	return 1;
+}
+
 //update time in BIOS Data Area
 //DWord at offset 0x6c is the timer ticks since midnight, timer is running at 18Hz
 //byte at 0x70 is timer overflow (set if midnight passed since last call to interrupt 1a function 00
@@ -199,8 +362,12 @@ u8
 my_rdb(u32 addr)
 {
 	unsigned long translated_addr = addr;
-	u8 translated = biosemu_dev_translate_address(IORESOURCE_MEM, &translated_addr);
+	u8 translated;
 	u8 rval;
+	u32 fast_val;
+	if (tlb_read(addr, 1, &fast_val))
+		return fast_val;
+	translated = biosemu_dev_translate_address(IORESOURCE_MEM, &translated_addr);
 	if (translated != 0) {
 		//translation successfull, access VGA Memory (BAR or Legacy...)
 		DEBUG_PRINTF_MEM("%s(%08x): access to VGA Memory\n",
@@ -231,8 +398,12 @@ u16
 my_rdw(u32 addr)
 {
 	unsigned long translated_addr = addr;
-	u8 translated = biosemu_dev_translate_address(IORESOURCE_MEM, &translated_addr);
+	u8 translated;
 	u16 rval;
+	u32 fast_val;
+	if (tlb_read(addr, 2, &fast_val))
+		return fast_val;
+	translated = biosemu_dev_translate_address(IORESOURCE_MEM, &translated_addr);
 	if (translated != 0) {
 		//translation successfull, access VGA Memory (BAR or Legacy...)
 		DEBUG_PRINTF_MEM("%s(%08x): access to VGA Memory\n",
@@ -282,8 +453,12 @@ u32
 my_rdl(u32 addr)
 {
 	unsigned long translated_addr = addr;
-	u8 translated = biosemu_dev_translate_address(IORESOURCE_MEM, &translated_addr);
+	u8 translated;
 	u32 rval;
+	u32 fast_val;
+	if (addr != 0x46c && tlb_read(addr, 4, &fast_val))
+		return fast_val;
+	translated = biosemu_dev_translate_address(IORESOURCE_MEM, &translated_addr);
 	if (translated != 0) {
 		//translation successfull, access VGA Memory (BAR or Legacy...)
 		DEBUG_PRINTF_MEM("%s(%x): access to VGA Memory\n",
@@ -345,7 +520,10 @@ void
 my_wrb(u32 addr, u8 val)
 {
 	unsigned long translated_addr = addr;
-	u8 translated = biosemu_dev_translate_address(IORESOURCE_MEM, &translated_addr);
+	u8 translated;
+	if (tlb_write(addr, 1, val))
+		return;
+	translated = biosemu_dev_translate_address(IORESOURCE_MEM, &translated_addr);
 	if (translated != 0) {
 		//translation successfull, access VGA Memory (BAR or Legacy...)
 		DEBUG_PRINTF_MEM("%s(%x, %x): access to VGA Memory\n",
@@ -370,7 +548,10 @@ void
 my_wrw(u32 addr, u16 val)
 {
 	unsigned long translated_addr = addr;
-	u8 translated = biosemu_dev_translate_address(IORESOURCE_MEM, &translated_addr);
+	u8 translated;
+	if (tlb_write(addr, 2, val))
+		return;
+	translated = biosemu_dev_translate_address(IORESOURCE_MEM, &translated_addr);
 	if (translated != 0) {
 		//translation successfull, access VGA Memory (BAR or Legacy...)
 		DEBUG_PRINTF_MEM("%s(%x, %x): access to VGA Memory\n",
@@ -415,7 +596,10 @@ void
 my_wrl(u32 addr, u32 val)
 {
 	unsigned long translated_addr = addr;
-	u8 translated = biosemu_dev_translate_address(IORESOURCE_MEM, &translated_addr);
+	u8 translated;
+	if (tlb_write(addr, 4, val))
+		return;
+	translated = biosemu_dev_translate_address(IORESOURCE_MEM, &translated_addr);
 	if (translated != 0) {
 		//translation successfull, access VGA Memory (BAR or Legacy...)
 		DEBUG_PRINTF_MEM("%s(%x, %x): access to VGA Memory\n",
@@ -498,4 +682,9 @@ my_wrl(u32 addr, u32 val)
 {
 	wrl(addr, val);
 }
+
+void
+biosemu_mem_tlb_flush(void)
+{
+}
 #endif
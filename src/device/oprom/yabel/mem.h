@@ -33,4 +33,7 @@ void my_wrw(u32 addr, u16 val);
 //write long to memory
 void my_wrl(u32 addr, u32 val);
 
+// drop all cached address translations
+void biosemu_mem_tlb_flush(void);
+
 #endif
@@ -736,8 +736,15 @@ void vbe_set_graphics(void)
 	dump(jpeg, 64);
 
 	int ret = 0;
-	DEBUG_PRINTF_VBE("Decompressing boot splash screen...\n");
-	ret = jpeg_decode(jpeg, framebuffer, 1024, 768, 16, decdata);
+	int scale = jpeg_fit_scale(1024, 768,
+				   le16_to_cpu(mode_info.vesa.x_resolution),
+				   le16_to_cpu(mode_info.vesa.y_resolution));
+	DEBUG_PRINTF_VBE("Decompressing boot splash screen (1/%d)...\n",
+			 scale);
+	ret = jpeg_decode_fb(jpeg, framebuffer, 1024, 768,
+			     mode_info.vesa.bits_per_pixel,
+			     le16_to_cpu(mode_info.vesa.bytes_per_scanline),
+			     scale, decdata);
 	DEBUG_PRINTF_VBE("returns %x\n", ret);
 #endif
 }
@@ -18,6 +18,7 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <bootstate.h>
 #include <console/console.h>
 #include <delay.h>
 #include <device/device.h>
@@ -50,66 +51,178 @@ unsigned int pciexp_find_extended_cap(device_t dev, unsigned int cap)
 
 #if CONFIG_PCIEXP_COMMON_CLOCK
 /*
- * Re-train a PCIe link
+ * Links being retrained after enabling Common Clock Configuration. Rather
+ * than waiting for each link before scanning on, the retrain is started and
+ * the rest of the tuning of the devices behind the link is deferred. The
+ * waits of all links in flight then overlap. A link is always finished
+ * before the link above it is retrained, so nested links are still
+ * brought up bottom to top as before.
  */
 #define PCIE_TRAIN_RETRY 10000
-static int pciexp_retrain_link(device_t dev, unsigned cap)
+#define PCIEXP_MAX_PENDING_LINKS 32
+
+struct pciexp_pending_link {
+	struct bus *bus;
+	unsigned int min_devfn;
+	unsigned int max_devfn;
+	unsigned int root_cap;
+	unsigned int tries;
+};
+
+static struct pciexp_pending_link pending_links[PCIEXP_MAX_PENDING_LINKS];
+static int num_pending_links;
+
+static void pciexp_tune_bus(struct bus *bus, unsigned int min_devfn,
+			    unsigned int max_devfn);
+
+/* Start link retraining */
+static void pciexp_start_retrain(device_t dev, unsigned cap)
 {
-	unsigned try = PCIE_TRAIN_RETRY;
 	u16 lnk;
 
-	/* Start link retraining */
 	lnk = pci_read_config16(dev, cap + PCI_EXP_LNKCTL);
 	lnk |= PCI_EXP_LNKCTL_RL;
 	pci_write_config16(dev, cap + PCI_EXP_LNKCTL, lnk);
+}
 
-	/* Wait for training to complete */
-	while (try--) {
-		lnk = pci_read_config16(dev, cap + PCI_EXP_LNKSTA);
-		if (!(lnk & PCI_EXP_LNKSTA_LT))
-			return 0;
-		udelay(100);
+/* Return 1 if bus is below the bridge of parent, 0 otherwise. */
+static int pciexp_bus_is_below(struct bus *bus, struct bus *parent)
+{
+	while (bus->dev && bus->dev->bus != bus) {
+		bus = bus->dev->bus;
+		if (bus == parent)
+			return 1;
+	}
+	return 0;
+}
+
+/*
+ * Wait for the pending links below parent, all of them if parent is NULL,
+ * and finish tuning the devices behind them.
+ */
+static void pciexp_finish_links(struct bus *parent)
+{
+	struct pciexp_pending_link *link;
+	int i, n, waiting;
+
+	/* Wait for training to complete on all selected links at once. */
+	do {
+		waiting = 0;
+		for (i = 0; i < num_pending_links; i++) {
+			link = &pending_links[i];
+			if (!link->tries)
+				continue;
+			if (parent && !pciexp_bus_is_below(link->bus, parent))
+				continue;
+			if (!(pci_read_config16(link->bus->dev, link->root_cap
+						+ PCI_EXP_LNKSTA)
+			      & PCI_EXP_LNKSTA_LT)) {
+				link->tries = 0;
+				continue;
+			}
+			if (!--link->tries)
+				printk(BIOS_ERR, "%s: Link Retrain timeout\n",
+				       dev_path(link->bus->dev));
+			else
+				waiting = 1;
+		}
+		if (waiting)
+			udelay(100);
+	} while (waiting);
+
+	/* Tune the devices in the order their links were started. */
+	for (i = 0, n = 0; i < num_pending_links; i++) {
+		link = &pending_links[i];
+		if (parent && !pciexp_bus_is_below(link->bus, parent)) {
+			pending_links[n++] = *link;
+			continue;
+		}
+		pciexp_tune_bus(link->bus, link->min_devfn, link->max_devfn);
 	}
+	num_pending_links = n;
+}
 
-	printk(BIOS_ERR, "%s: Link Retrain timeout\n", dev_path(dev));
-	return -1;
+static void pciexp_finish_all_links(void *unused)
+{
+	pciexp_finish_links(NULL);
 }
 
+/* Tuning must be complete before resources are allocated. */
+BOOT_STATE_INIT_ENTRIES(pciexp_links_bscb) = {
+	BOOT_STATE_INIT_ENTRY(BS_DEV_ENUMERATE, BS_ON_EXIT,
+			      pciexp_finish_all_links, NULL),
+};
+
 /*
- * Check the Slot Clock Configuration for root port and endpoint
- * and enable Common Clock Configuration if possible.  If CCC is
- * enabled the link must be retrained.
+ * Check the Slot Clock Configuration for the root port and the endpoints
+ * on its bus and enable Common Clock Configuration where possible. If CCC
+ * is enabled the link must be retrained: the retrain is started and the
+ * link is queued. Returns 1 if the bus was queued, 0 if it can be tuned
+ * right away.
  */
-static void pciexp_enable_common_clock(device_t root, unsigned root_cap,
-				       device_t endp, unsigned endp_cap)
+static int pciexp_enable_common_clock(struct bus *bus, unsigned int min_devfn,
+				      unsigned int max_devfn)
 {
+	device_t root = bus->dev;
+	device_t endp;
+	unsigned int root_cap, endp_cap;
 	u16 root_scc, endp_scc, lnkctl;
+	int enabled = 0;
+
+	root_cap = pci_find_capability(root, PCI_CAP_ID_PCIE);
+	if (!root_cap)
+		return 0;
 
 	/* Get Slot Clock Configuration for root port */
 	root_scc = pci_read_config16(root, root_cap + PCI_EXP_LNKSTA);
 	root_scc &= PCI_EXP_LNKSTA_SLC;
+	if (!root_scc)
+		return 0;
 
-	/* Get Slot Clock Configuration for endpoint */
-	endp_scc = pci_read_config16(endp, endp_cap + PCI_EXP_LNKSTA);
-	endp_scc &= PCI_EXP_LNKSTA_SLC;
+	for (endp = bus->children; endp; endp = endp->sibling) {
+		if ((endp->path.pci.devfn < min_devfn) ||
+		    (endp->path.pci.devfn > max_devfn))
+			continue;
+
+		endp_cap = pci_find_capability(endp, PCI_CAP_ID_PCIE);
+		if (!endp_cap)
+			continue;
+
+		/* Get Slot Clock Configuration for endpoint */
+		endp_scc = pci_read_config16(endp, endp_cap + PCI_EXP_LNKSTA);
+		endp_scc &= PCI_EXP_LNKSTA_SLC;
+		if (!endp_scc)
+			continue;
 
-	/* Enable Common Clock Configuration and retrain */
-	if (root_scc && endp_scc) {
 		printk(BIOS_INFO, "Enabling Common Clock Configuration\n");
 
 		/* Set in endpoint */
 		lnkctl = pci_read_config16(endp, endp_cap + PCI_EXP_LNKCTL);
 		lnkctl |= PCI_EXP_LNKCTL_CCC;
 		pci_write_config16(endp, endp_cap + PCI_EXP_LNKCTL, lnkctl);
+		enabled = 1;
+	}
 
-		/* Set in root port */
-		lnkctl = pci_read_config16(root, root_cap + PCI_EXP_LNKCTL);
-		lnkctl |= PCI_EXP_LNKCTL_CCC;
-		pci_write_config16(root, root_cap + PCI_EXP_LNKCTL, lnkctl);
+	if (!enabled)
+		return 0;
 
-		/* Retrain link if CCC was enabled */
-		pciexp_retrain_link(root, root_cap);
-	}
+	/* Set in root port */
+	lnkctl = pci_read_config16(root, root_cap + PCI_EXP_LNKCTL);
+	lnkctl |= PCI_EXP_LNKCTL_CCC;
+	pci_write_config16(root, root_cap + PCI_EXP_LNKCTL, lnkctl);
+
+	/* Retrain link since CCC was enabled */
+	if (num_pending_links == PCIEXP_MAX_PENDING_LINKS)
+		pciexp_finish_links(NULL);
+	pciexp_start_retrain(root, root_cap);
+	pending_links[num_pending_links++] = (struct pciexp_pending_link) {
+		.bus = bus,
+		.min_devfn = min_devfn,
+		.max_devfn = max_devfn,
+		.root_cap = root_cap,
+		.tries = PCIE_TRAIN_RETRY,
+	};
+	return 1;
 }
 #endif /* CONFIG_PCIEXP_COMMON_CLOCK */
 
@@ -391,11 +504,6 @@ static void pciexp_tune_dev(device_t dev)
 	if (!root_cap)
 		return;
 
-#if CONFIG_PCIEXP_COMMON_CLOCK
-	/* Check for and enable Common Clock */
-	pciexp_enable_common_clock(root, root_cap, dev, cap);
-#endif
-
 #if CONFIG_PCIEXP_CLK_PM
 	/* Check if per port CLK req is supported by endpoint*/
 	pciexp_enable_clock_power_pm(dev, cap);
@@ -419,13 +527,11 @@ static void pciexp_tune_dev(device_t dev)
 #endif
 }
 
-unsigned int pciexp_scan_bus(struct bus *bus, unsigned int min_devfn,
-			     unsigned int max_devfn, unsigned int max)
+static void pciexp_tune_bus(struct bus *bus, unsigned int min_devfn,
+			    unsigned int max_devfn)
 {
 	device_t child;
 
-	max = pci_scan_bus(bus, min_devfn, max_devfn, max);
-
 	for (child = bus->children; child; child = child->sibling) {
 		if ((child->path.pci.devfn < min_devfn) ||
 		    (child->path.pci.devfn > max_devfn)) {
@@ -433,6 +539,23 @@ unsigned int pciexp_scan_bus(struct bus *bus, unsigned int min_devfn,
 		}
 		pciexp_tune_dev(child);
 	}
+}
+
+unsigned int pciexp_scan_bus(struct bus *bus, unsigned int min_devfn,
+			     unsigned int max_devfn, unsigned int max)
+{
+	max = pci_scan_bus(bus, min_devfn, max_devfn, max);
+
+#if CONFIG_PCIEXP_COMMON_CLOCK
+	/* Links further down must be up before this one is retrained. */
+	pciexp_finish_links(bus);
+
+	/* Check for and enable Common Clock */
+	if (pciexp_enable_common_clock(bus, min_devfn, max_devfn))
+		return max;
+#endif
+
+	pciexp_tune_bus(bus, min_devfn, max_devfn);
 	return max;
 }
 
@@ -62,6 +62,7 @@ static elog_event_buffer_state event_buffer_state;
 
 static u16 next_event_offset; /* from end of header */
 static u16 event_count;
+static u16 loaded_offset; /* data before this has not been read from flash */
 
 static struct spi_flash *elog_spi;
 
@@ -281,6 +282,66 @@ static void elog_flash_erase(void *address, u32 size)
 	elog_spi->erase(elog_spi, offset, size);
 }
 
+/*
+ * Read 'size' bytes of event data at 'offset' from flash into the buffer.
+ */
+static void elog_read_data(u16 offset, u16 size)
+{
+	elog_debug("elog_read_data(offset=%u size=%u)\n", offset, size);
+
+	elog_spi->read(elog_spi, flash_base + sizeof(struct elog_header) +
+		       offset, size, &elog_area->data[offset]);
+}
+
+/*
+ * Read the events the tail scan skipped. Anything that hands out or
+ * rewrites the whole buffer must call this first.
+ */
+static void elog_load_area(void)
+{
+	if (!loaded_offset)
+		return;
+
+	elog_read_data(0, loaded_offset);
+	loaded_offset = 0;
+}
+
+/*
+ * Check if the log keeps events clear of checkpoints
+ */
+static int elog_is_indexed(void)
+{
+	return elog_area->header.reserved[0] == ELOG_CHECKPOINT_SHIFT;
+}
+
+/*
+ * Number of bytes to pad at 'offset' so that an event of 'size' bytes does
+ * not straddle the next checkpoint. The space left before the checkpoint is
+ * always either zero or large enough for a checkpoint record.
+ */
+static u8 elog_checkpoint_gap(u16 offset, u8 size)
+{
+	u16 room = ELOG_CHECKPOINT_SIZE - offset % ELOG_CHECKPOINT_SIZE;
+
+	if (room == ELOG_CHECKPOINT_SIZE || size == room ||
+	    size + ELOG_MIN_EVENT_SIZE <= room)
+		return 0;
+	return room;
+}
+
+/*
+ * Fill 'size' bytes at 'offset' in the buffer with a checkpoint record
+ */
+static void elog_fill_checkpoint(u16 offset, u8 size)
+{
+	struct event_header *event = elog_get_event_base(offset);
+
+	memset(event, 0, size);
+	event->type = ELOG_TYPE_CHECKPOINT;
+	event->length = size;
+	elog_update_checksum(event, -(elog_checksum_event(event)));
+}
+
 /*
  * Scan the event area and validate each entry and update the ELOG state.
  */
@@ -313,8 +374,9 @@ static void elog_update_event_buffer_state(void)
 			break;
 		}
 
-		/* Move to the next event */
-		count++;
+		/* Move to the next event, padding is not an event */
+		if (event->type != ELOG_TYPE_CHECKPOINT)
+			count++;
 		offset += event->length;
 	}
 
@@ -327,6 +389,59 @@ static void elog_update_event_buffer_state(void)
 	next_event_offset = offset;
 }
 
+/*
+ * Find the end of an indexed log by binary search over the checkpoints and
+ * read only the last checkpoint's worth of events. The rest of the buffer
+ * is loaded on demand by elog_load_area().
+ * Returns 0 if the events found are valid, -1 otherwise.
+ */
+static int elog_scan_tail(void)
+{
+	u16 low = 0;
+	u16 high = (log_size - 1) / ELOG_CHECKPOINT_SIZE + 1;
+	u16 mid, start, end, offset;
+	u16 count = 0;
+	u8 type;
+
+	elog_debug("elog_scan_tail()\n");
+
+	/* Find the last checkpoint an event starts at */
+	while (high - low > 1) {
+		mid = (low + high) / 2;
+		elog_spi->read(elog_spi, flash_base + sizeof(struct elog_header) +
+			       mid * ELOG_CHECKPOINT_SIZE, sizeof(type), &type);
+		if (type == ELOG_TYPE_EOL)
+			high = mid;
+		else
+			low = mid;
+	}
+
+	/* Read its events and enough beyond to check the area is clear */
+	start = low * ELOG_CHECKPOINT_SIZE;
+	end = MIN(log_size, start + ELOG_CHECKPOINT_SIZE + MAX_EVENT_SIZE);
+	memset(elog_area->data, ELOG_TYPE_EOL, log_size);
+	elog_read_data(start, end - start);
+
+	for (offset = start; offset < end; offset += elog_area->data[offset + 1]) {
+		if (elog_area->data[offset] == ELOG_TYPE_EOL)
+			break;
+		if (!elog_is_event_valid(offset))
+			return -1;
+		if (elog_area->data[offset] != ELOG_TYPE_CHECKPOINT)
+			count++;
+	}
+
+	if (offset > start + ELOG_CHECKPOINT_SIZE ||
+	    !elog_is_buffer_clear(&elog_area->data[offset], end - offset))
+		return -1;
+
+	/* Update ELOG state */
+	loaded_offset = start;
+	event_count = count;
+	next_event_offset = offset;
+	return 0;
+}
+
 static void elog_scan_flash(void)
 {
 	elog_debug("elog_scan_flash()\n");
@@ -335,11 +450,29 @@ static void elog_scan_flash(void)
 	header_state = ELOG_HEADER_INVALID;
 	event_buffer_state = ELOG_EVENT_BUFFER_OK;
 
-	/* Fill memory buffer by reading from SPI */
-	elog_spi->read(elog_spi, flash_base, total_size, elog_area);
-
 	next_event_offset = 0;
 	event_count = 0;
+	loaded_offset = 0;
+
+	/* An indexed log only needs the pages around its end */
+	elog_spi->read(elog_spi, flash_base, sizeof(struct elog_header),
+		       &elog_area->header);
+	if (elog_area->header.magic == ELOG_SIGNATURE &&
+	    elog_area->header.version == ELOG_VERSION &&
+	    elog_area->header.header_size == sizeof(struct elog_header) &&
+	    elog_is_indexed()) {
+		area_state = ELOG_AREA_HAS_CONTENT;
+		header_state = ELOG_HEADER_VALID;
+		if (elog_scan_tail() == 0)
+			return;
+		printk(BIOS_WARNING, "ELOG: checkpoints invalid, full scan\n");
+		next_event_offset = 0;
+		event_count = 0;
+		loaded_offset = 0;
+	}
+
+	/* Fill memory buffer by reading from SPI */
+	elog_spi->read(elog_spi, flash_base, total_size, elog_area);
 
 	/* Check if the area is empty or not */
 	if (elog_is_buffer_clear(elog_area, total_size)) {
@@ -370,13 +503,46 @@ static void elog_prepare_empty(void)
 	header->magic = ELOG_SIGNATURE;
 	header->version = ELOG_VERSION;
 	header->header_size = sizeof(struct elog_header);
-	header->reserved[0] = ELOG_TYPE_EOL;
+	header->reserved[0] = ELOG_CHECKPOINT_SHIFT;
 	header->reserved[1] = ELOG_TYPE_EOL;
 	elog_flash_write(elog_area, header->header_size);
 
 	elog_scan_flash();
 }
 
+/*
+ * Lay out the events from 'offset' onwards again from the start of the log,
+ * dropping old checkpoint records and adding new ones where needed. Only
+ * moves data if 'move' is set.
+ * Returns the new size of the events, or -1 if checkpoint records would
+ * push an event past its old location.
+ */
+static int elog_relayout(u16 offset, int move)
+{
+	struct event_header *event;
+	u16 size = 0;
+	u8 length, gap;
+
+	while (offset < next_event_offset) {
+		event = elog_get_event_base(offset);
+		length = event->length;
+
+		if (event->type != ELOG_TYPE_CHECKPOINT) {
+			gap = elog_checkpoint_gap(size, length);
+			if (size + gap > offset)
+				return -1;
+			if (move && gap)
+				elog_fill_checkpoint(size, gap);
+			if (move)
+				memmove(&elog_area->data[size + gap], event,
+					length);
+			size += gap + length;
+		}
+		offset += length;
+	}
+	return size;
+}
+
 /*
  * Shrink the log, deleting old entries and moving the
  * remining ones to the front of the log.
@@ -385,14 +551,18 @@ static int elog_shrink(void)
 {
 	struct event_header *event;
 	u16 discard_count = 0;
+	u16 discard_size = 0;
 	u16 offset = 0;
 	u16 new_size = 0;
+	u16 i;
 
 	elog_debug("elog_shrink()\n");
 
 	if (next_event_offset < shrink_size)
 		return 0;
 
+	elog_load_area();
+
 	while (1) {
 		/* Next event has exceeded constraints */
 		if (offset > shrink_size)
@@ -405,15 +575,31 @@ static int elog_shrink(void)
 			break;
 
 		offset += event->length;
+	}
+
+	/* Make room for the checkpoint records if the discarded events
+	 * do not leave enough, which converts an old log as well. */
+	while (elog_relayout(offset, 0) < 0)
+		offset += elog_get_event_base(offset)->length;
+
+	/* Only real events count as cleared, not checkpoint padding */
+	for (i = 0; i < offset; i += event->length) {
+		event = elog_get_event_base(i);
+		if (event->type == ELOG_TYPE_CHECKPOINT)
+			continue;
 		discard_count++;
+		discard_size += event->length;
 	}
+	elog_debug("elog_shrink: discarding %d events (%d bytes)\n",
+		   discard_count, discard_size);
 
-	new_size = next_event_offset - offset;
-	memmove(&elog_area->data[0], &elog_area->data[offset], new_size);
+	new_size = elog_relayout(offset, 1);
 	memset(&elog_area->data[new_size], ELOG_TYPE_EOL, log_size - new_size);
+	elog_area->header.reserved[0] = ELOG_CHECKPOINT_SHIFT;
 
-	elog_flash_erase(elog_area, total_size);
-	elog_flash_write(elog_area, total_size);
+	/* Past the old end of the log the flash is still erased, so this
+	 * only erases the sectors that held events. */
+	spi_flash_update(elog_spi, flash_base, total_size, elog_area);
 	elog_scan_flash();
 
 	/* Ensure the area was successfully erased */
@@ -423,7 +609,7 @@ static int elog_shrink(void)
 	}
 
 	/* Add clear event */
-	elog_add_event_word(ELOG_TYPE_LOG_CLEAR, offset);
+	elog_add_event_word(ELOG_TYPE_LOG_CLEAR, discard_size);
 
 	return 0;
 }
@@ -460,6 +646,7 @@ int elog_smbios_write_type15(unsigned long *current, int handle)
 	void *cbmem = cbmem_add(CBMEM_ID_ELOG, total_size);
 	if (!cbmem)
 		return 0;
+	elog_load_area();
 	memcpy(cbmem, elog_area, total_size);
 #endif
 
@@ -675,6 +862,7 @@ void elog_add_event_raw(u8 event_type, void *data, u8 data_size)
 {
 	struct event_header *event;
 	u8 event_size;
+	u8 gap = 0;
 
 	elog_debug("elog_add_event_raw(type=%X)\n", event_type);
 
@@ -690,13 +878,22 @@ void elog_add_event_raw(u8 event_type, void *data, u8 data_size)
 		return;
 	}
 
+	/* Keep the event clear of the next checkpoint */
+	if (elog_is_indexed())
+		gap = elog_checkpoint_gap(next_event_offset, event_size);
+
 	/* Make sure event data can fit */
-	if ((next_event_offset + event_size) >= log_size) {
+	if ((next_event_offset + gap + event_size) >= log_size) {
 		printk(BIOS_ERR, "ELOG: Event(%X) does not fit\n",
 		       event_type);
 		return;
 	}
 
+	if (gap) {
+		elog_fill_checkpoint(next_event_offset, gap);
+		next_event_offset += gap;
+	}
+
 	/* Fill out event data */
 	event = elog_get_event_base(next_event_offset);
 	event->type = event_type;
@@ -713,7 +910,7 @@ void elog_add_event_raw(u8 event_type, void *data, u8 data_size)
 	/* Update the ELOG state */
 	event_count++;
 
-	elog_flash_write((void *)event, event_size);
+	elog_flash_write((u8 *)event - gap, gap + event_size);
 
 	next_event_offset += event_size;
 
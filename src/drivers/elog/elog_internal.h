@@ -34,6 +34,17 @@ struct elog_header {
 #define ELOG_MIN_AVAILABLE_ENTRIES	2  /* Shrink when this many can't fit */
 #define ELOG_SHRINK_PERCENTAGE		25 /* Percent of total area to remove */
 
+/*
+ * No event straddles a checkpoint, a multiple of ELOG_CHECKPOINT_SIZE bytes
+ * from the end of the header. Gaps that cannot hold the next event are
+ * filled with an ELOG_TYPE_CHECKPOINT record, so an event starts at every
+ * checkpoint below the end of the log and the end can be found by probing
+ * a few bytes of flash. Logs written this way carry ELOG_CHECKPOINT_SHIFT
+ * in reserved[0] of the header.
+ */
+#define ELOG_CHECKPOINT_SHIFT		8
+#define ELOG_CHECKPOINT_SIZE		(1 << ELOG_CHECKPOINT_SHIFT)
+
 /* SMBIOS event log header */
 struct event_header {
 	u8 type;
@@ -46,6 +57,9 @@ struct event_header {
 	u8 second;
 } __attribute__ ((packed));
 
+/* Smallest possible event: header + checksum */
+#define ELOG_MIN_EVENT_SIZE		(sizeof(struct event_header) + 1)
+
 /* SMBIOS Type 15 related constants */
 #define ELOG_HEADER_TYPE_OEM		0x88
 
@@ -107,7 +107,7 @@ static int eon_write(struct spi_flash *flash,
 			goto out;
 		}
 
-		ret = spi_flash_cmd_wait_ready(flash, SPI_FLASH_PROG_TIMEOUT);
+		ret = spi_flash_cmd_wait_program(flash);
 		if (ret) {
 			printk(BIOS_WARNING, "SF: EON Page Program timeout\n");
 			goto out;
@@ -162,7 +162,10 @@ struct spi_flash *spi_flash_probe_eon(struct spi_slave *spi, u8 *idcode)
 	eon->flash.size = params->page_size * params->pages_per_sector
 	    * params->nr_sectors;
 	eon->flash.erase_cmd = CMD_EN25_SE;
+	eon->flash.erase_cmd_32k = 0;
+	eon->flash.erase_cmd_64k = CMD_EN25_BE;
 	eon->flash.status_cmd = CMD_EN25_RDSR;
+	eon->flash.program_time_us = 500;
 
 	return &eon->flash;
 }
@@ -171,7 +171,7 @@ static int macronix_write(struct spi_flash *flash,
 			break;
 		}
 
-		ret = spi_flash_cmd_wait_ready(flash, SPI_FLASH_PROG_TIMEOUT);
+		ret = spi_flash_cmd_wait_program(flash);
 		if (ret)
 			break;
 
@@ -222,7 +222,10 @@ struct spi_flash *spi_flash_probe_macronix(struct spi_slave *spi, u8 *idcode)
 	mcx.flash.size = mcx.flash.sector_size * params->sectors_per_block *
 		params->nr_blocks;
 	mcx.flash.erase_cmd = CMD_MX25XX_SE;
+	mcx.flash.erase_cmd_32k = 0;
+	mcx.flash.erase_cmd_64k = CMD_MX25XX_BE;
 	mcx.flash.status_cmd = CMD_MX25XX_RDSR;
+	mcx.flash.program_time_us = 500;
 
 	return &mcx.flash;
 }
@@ -250,7 +250,7 @@ static int spansion_write(struct spi_flash *flash,
 			break;
 		}
 
-		ret = spi_flash_cmd_wait_ready(flash, SPI_FLASH_PROG_TIMEOUT);
+		ret = spi_flash_cmd_wait_program(flash);
 		if (ret)
 			break;
 
@@ -300,7 +300,10 @@ struct spi_flash *spi_flash_probe_spansion(struct spi_slave *spi, u8 *idcode)
 	spsn->flash.sector_size = params->page_size * params->pages_per_sector;
 	spsn->flash.size = spsn->flash.sector_size * params->nr_sectors;
 	spsn->flash.erase_cmd = CMD_S25FLXX_SE;
+	spsn->flash.erase_cmd_32k = 0;
+	spsn->flash.erase_cmd_64k = 0;
 	spsn->flash.status_cmd = CMD_S25FLXX_RDSR;
+	spsn->flash.program_time_us = 700;
 
 	return &spsn->flash;
 }
@@ -162,8 +162,8 @@ int spi_flash_cmd_read_slow(struct spi_flash *flash, u32 offset,
 					offset, len, data);
 }
 
-int spi_flash_cmd_poll_bit(struct spi_flash *flash, unsigned long timeout,
-			   u8 cmd, u8 poll_bit)
+static int spi_flash_poll(struct spi_flash *flash, unsigned long timeout,
+			  unsigned interval_us, u8 cmd, u8 poll_bit)
 {
 	struct spi_slave *spi = flash->spi;
 	unsigned long timebase;
@@ -179,7 +179,7 @@ int spi_flash_cmd_poll_bit(struct spi_flash *flash, unsigned long timeout,
 		if ((status & poll_bit) == 0)
 			break;
 
-		udelay(500);
+		udelay(interval_us);
 	} while (timebase--);
 
 	if ((status & poll_bit) == 0)
@@ -190,15 +190,32 @@ int spi_flash_cmd_poll_bit(struct spi_flash *flash, unsigned long timeout,
 	return -1;
 }
 
+int spi_flash_cmd_poll_bit(struct spi_flash *flash, unsigned long timeout,
+			   u8 cmd, u8 poll_bit)
+{
+	return spi_flash_poll(flash, timeout, 500, cmd, poll_bit);
+}
+
 int spi_flash_cmd_wait_ready(struct spi_flash *flash, unsigned long timeout)
 {
 	return spi_flash_cmd_poll_bit(flash, timeout,
 		CMD_READ_STATUS, STATUS_WIP);
 }
 
+int spi_flash_cmd_wait_program(struct spi_flash *flash)
+{
+	if (flash->program_time_us)
+		udelay(flash->program_time_us);
+
+	return spi_flash_poll(flash, SPI_FLASH_PROG_TIMEOUT * 500 /
+			      SPI_FLASH_PROG_POLL_US, SPI_FLASH_PROG_POLL_US,
+			      CMD_READ_STATUS, STATUS_WIP);
+}
+
 int spi_flash_cmd_erase(struct spi_flash *flash, u32 offset, size_t len)
 {
 	u32 start, end, erase_size;
+	unsigned long timeout;
 	int ret;
 	u8 cmd[4];
 
@@ -210,11 +227,28 @@ int spi_flash_cmd_erase(struct spi_flash *flash, u32 offset, size_t len)
 
 	flash->spi->rw = SPI_WRITE_FLAG;
 
-	cmd[0] = flash->erase_cmd;
 	start = offset;
 	end = start + len;
 
 	while (offset < end) {
+		/* Use the largest erase command that fits */
+		if (flash->erase_cmd_64k && flash->sector_size < 64 * KiB &&
+		    !(offset % (64 * KiB)) && end - offset >= 64 * KiB) {
+			cmd[0] = flash->erase_cmd_64k;
+			erase_size = 64 * KiB;
+			timeout = SPI_FLASH_BLOCK_ERASE_TIMEOUT;
+		} else if (flash->erase_cmd_32k &&
+			   flash->sector_size < 32 * KiB &&
+			   !(offset % (32 * KiB)) && end - offset >= 32 * KiB) {
+			cmd[0] = flash->erase_cmd_32k;
+			erase_size = 32 * KiB;
+			timeout = SPI_FLASH_BLOCK_ERASE_TIMEOUT;
+		} else {
+			cmd[0] = flash->erase_cmd;
+			erase_size = flash->sector_size;
+			timeout = SPI_FLASH_PAGE_ERASE_TIMEOUT;
+		}
+
 		spi_flash_addr(offset, cmd);
 		offset += erase_size;
 
@@ -230,7 +264,7 @@ int spi_flash_cmd_erase(struct spi_flash *flash, u32 offset, size_t len)
 		if (ret)
 			goto out;
 
-		ret = spi_flash_cmd_wait_ready(flash, SPI_FLASH_PAGE_ERASE_TIMEOUT);
+		ret = spi_flash_cmd_wait_ready(flash, timeout);
 		if (ret)
 			goto out;
 	}
@@ -12,6 +12,10 @@
 #define SPI_FLASH_PROG_TIMEOUT		(2 * CONFIG_SYS_HZ)
 #define SPI_FLASH_PAGE_ERASE_TIMEOUT	(5 * CONFIG_SYS_HZ)
 #define SPI_FLASH_SECTOR_ERASE_TIMEOUT	(10 * CONFIG_SYS_HZ)
+#define SPI_FLASH_BLOCK_ERASE_TIMEOUT	(40 * CONFIG_SYS_HZ)
+
+/* Page programs are short, so poll for them more often than for erases */
+#define SPI_FLASH_PROG_POLL_US		10
 
 /* Common commands */
 #define CMD_READ_ID			0x9f
@@ -23,6 +27,7 @@
 #define CMD_READ_STATUS			0x05
 #define CMD_WRITE_ENABLE		0x06
 
+#define CMD_BLOCK_ERASE_32K		0x52
 #define CMD_BLOCK_ERASE			0xD8
 
 /* Common status */
@@ -54,6 +59,12 @@ int spi_flash_cmd_poll_bit(struct spi_flash *flash, unsigned long timeout,
  */
 int spi_flash_cmd_wait_ready(struct spi_flash *flash, unsigned long timeout);
 
+/*
+ * Wait for a page program to finish, polling every SPI_FLASH_PROG_POLL_US
+ * once the flash's program_time_us has passed.
+ */
+int spi_flash_cmd_wait_program(struct spi_flash *flash);
+
 /* Erase sectors. */
 int spi_flash_cmd_erase(struct spi_flash *flash, u32 offset, size_t len);
 
@@ -0,0 +1,212 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Update a flash range in place. Only the flash's read, write and erase
+ * operations are used, so this works with hardware sequencing controllers
+ * as well as with the drivers in this directory.
+ */
+
+#include <console/console.h>
+#include <spi_flash.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Compared and programmed in page sized, page aligned pieces */
+#define UPDATE_CHUNK	256
+
+#define ERASED		0xff
+
+enum update_state {
+	UPDATE_UNCHANGED,
+	UPDATE_PROGRAM,
+	UPDATE_ERASE,
+};
+
+static int read_chunk(struct spi_flash *flash, u32 offset, size_t size,
+		      u8 *current)
+{
+	if (flash->read(flash, offset, size, current)) {
+		printk(BIOS_ERR, "SF: Failed to read %zu bytes @ %#x\n",
+		       size, offset);
+		return -1;
+	}
+	return 0;
+}
+
+static size_t chunk_size(u32 offset, u32 end)
+{
+	return MIN(end, ALIGN_DOWN(offset, UPDATE_CHUNK) + UPDATE_CHUNK) -
+		offset;
+}
+
+/*
+ * Find out what it takes to make [offset, offset + size) hold 'data', or
+ * erased bytes if 'data' is NULL. Returns an enum update_state, or -1 if
+ * the flash could not be read.
+ */
+static int update_state(struct spi_flash *flash, u32 offset, size_t size,
+			const u8 *data)
+{
+	u8 current[UPDATE_CHUNK];
+	const u32 end = offset + size;
+	int state = UPDATE_UNCHANGED;
+	size_t len, i;
+
+	for (; offset < end; offset += len) {
+		len = chunk_size(offset, end);
+		if (read_chunk(flash, offset, len, current))
+			return -1;
+
+		for (i = 0; i < len; i++) {
+			const u8 want = data ? data[i] : ERASED;
+
+			if (current[i] == want)
+				continue;
+			/* Programming can only clear bits */
+			if ((current[i] & want) != want)
+				return UPDATE_ERASE;
+			state = UPDATE_PROGRAM;
+		}
+		if (data)
+			data += len;
+	}
+	return state;
+}
+
+/*
+ * Program the bytes of [offset, offset + size) that differ from 'data'.
+ * If 'erased' is set the range is known to be erased and is not read.
+ */
+static int program_changes(struct spi_flash *flash, u32 offset, size_t size,
+			   const u8 *data, int erased)
+{
+	u8 current[UPDATE_CHUNK];
+	const u32 end = offset + size;
+	size_t len, first, last;
+
+	for (; offset < end; offset += len, data += len) {
+		len = chunk_size(offset, end);
+		if (erased)
+			memset(current, ERASED, len);
+		else if (read_chunk(flash, offset, len, current))
+			return -1;
+
+		/* One page program from the first to the last change */
+		for (first = 0; first < len && current[first] == data[first];
+		     first++)
+			;
+		if (first == len)
+			continue;
+		for (last = len - 1; current[last] == data[last]; last--)
+			;
+
+		if (flash->write(flash, offset + first, last - first + 1,
+				 data + first)) {
+			printk(BIOS_ERR, "SF: Failed to write %zu bytes @ %#x\n",
+			       last - first + 1, (u32)(offset + first));
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Erase the sectors in [start, end) and program the part of them that
+ * lies within the range being updated.
+ */
+static int erase_and_program(struct spi_flash *flash, u32 start, u32 end,
+			     u32 offset, u32 range_end, const u8 *buf)
+{
+	const u32 lo = MAX(start, offset);
+	const u32 hi = MIN(end, range_end);
+
+	if (start == end)
+		return 0;
+
+	if (flash->erase(flash, start, end - start)) {
+		printk(BIOS_ERR, "SF: Failed to erase %u bytes @ %#x\n",
+		       end - start, start);
+		return -1;
+	}
+	return program_changes(flash, lo, hi - lo, buf + lo - offset, 1);
+}
+
+int spi_flash_update(struct spi_flash *flash, u32 offset, size_t len,
+		     const void *buf)
+{
+	const u8 *data = buf;
+	const u32 sector_size = flash->sector_size;
+	const u32 range_end = offset + len;
+	u32 sector, lo, hi;
+	/* Sectors to erase are collected into runs, erased at once */
+	u32 erase_start = 0, erase_end = 0;
+	int state;
+
+	if (!len)
+		return 0;
+	if (!sector_size || offset + len > flash->size) {
+		printk(BIOS_ERR, "SF: Invalid update of %zu bytes @ %#x\n",
+		       len, offset);
+		return -1;
+	}
+
+	for (sector = ALIGN_DOWN(offset, sector_size); sector < range_end;
+	     sector += sector_size) {
+		lo = MAX(sector, offset);
+		hi = MIN(sector + sector_size, range_end);
+
+		state = update_state(flash, lo, hi - lo, data + lo - offset);
+		if (state < 0)
+			return -1;
+
+		if (state == UPDATE_ERASE) {
+			int before, after;
+
+			/* Bytes outside the range may only be erased if
+			 * there is nothing in them. */
+			before = update_state(flash, sector, lo - sector, NULL);
+			if (before < 0)
+				return -1;
+			after = update_state(flash, hi,
+					     sector + sector_size - hi, NULL);
+			if (after < 0)
+				return -1;
+			if (before || after) {
+				printk(BIOS_ERR, "SF: Update @ %#x needs to "
+				       "erase data outside %zu bytes @ %#x\n",
+				       sector, len, offset);
+				return -1;
+			}
+
+			if (erase_end != sector) {
+				if (erase_and_program(flash, erase_start,
+						      erase_end, offset,
+						      range_end, data))
+					return -1;
+				erase_start = sector;
+			}
+			erase_end = sector + sector_size;
+			continue;
+		}
+
+		if (state == UPDATE_PROGRAM &&
+		    program_changes(flash, lo, hi - lo, data + lo - offset, 0))
+			return -1;
+	}
+
+	return erase_and_program(flash, erase_start, erase_end, offset,
+				 range_end, data);
+}
@@ -143,7 +143,7 @@ sst_byte_write(struct spi_flash *flash, u32 offset, const void *buf)
 	if (ret)
 		return ret;
 
-	return spi_flash_cmd_wait_ready(flash, SPI_FLASH_PROG_TIMEOUT);
+	return spi_flash_cmd_wait_program(flash);
 }
 
 static int
@@ -188,7 +188,7 @@ sst_write(struct spi_flash *flash, u32 offset, size_t len, const void *buf)
 			break;
 		}
 
-		ret = spi_flash_cmd_wait_ready(flash, SPI_FLASH_PROG_TIMEOUT);
+		ret = spi_flash_cmd_wait_program(flash);
 		if (ret)
 			break;
 
@@ -268,7 +268,11 @@ spi_flash_probe_sst(struct spi_slave *spi, u8 *idcode)
 	stm->flash.sector_size = SST_SECTOR_SIZE;
 	stm->flash.size = stm->flash.sector_size * params->nr_sectors;
 	stm->flash.erase_cmd = CMD_SST_SE;
+	/* Block erase sizes are not the same across these parts */
+	stm->flash.erase_cmd_32k = 0;
+	stm->flash.erase_cmd_64k = 0;
 	stm->flash.status_cmd = CMD_SST_RDSR;
+	stm->flash.program_time_us = 0;
 
 	/* Flash powers up read-only, so clear BP# bits */
 	sst_unlock(&stm->flash);
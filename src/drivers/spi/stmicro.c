@@ -188,7 +188,7 @@ static int stmicro_write(struct spi_flash *flash,
 			break;
 		}
 
-		ret = spi_flash_cmd_wait_ready(flash, SPI_FLASH_PROG_TIMEOUT);
+		ret = spi_flash_cmd_wait_program(flash);
 		if (ret)
 			break;
 
@@ -246,6 +246,9 @@ struct spi_flash *spi_flash_probe_stmicro(struct spi_slave *spi, u8 * idcode)
 	stm.flash.sector_size = params->page_size * params->pages_per_sector;
 	stm.flash.size = stm.flash.sector_size * params->nr_sectors;
 	stm.flash.erase_cmd = CMD_M25PXX_SE;
+	stm.flash.erase_cmd_32k = 0;
+	stm.flash.erase_cmd_64k = 0;
+	stm.flash.program_time_us = 500;
 
 	return &stm.flash;
 }
@@ -17,6 +17,7 @@
 #define CMD_W25_FAST_READ	0x0b	/* Read Data Bytes at Higher Speed */
 #define CMD_W25_PP		0x02	/* Page Program */
 #define CMD_W25_SE		0x20	/* Sector (4K) Erase */
+#define CMD_W25_BE32		0x52	/* Block (32K) Erase */
 #define CMD_W25_BE		0xd8	/* Block (64K) Erase */
 #define CMD_W25_CE		0xc7	/* Chip Erase */
 #define CMD_W25_DP		0xb9	/* Deep Power-down */
@@ -169,7 +170,7 @@ static int winbond_write(struct spi_flash *flash,
 			goto out;
 		}
 
-		ret = spi_flash_cmd_wait_ready(flash, SPI_FLASH_PROG_TIMEOUT);
+		ret = spi_flash_cmd_wait_program(flash);
 		if (ret)
 			goto out;
 
@@ -228,7 +229,10 @@ struct spi_flash *spi_flash_probe_winbond(struct spi_slave *spi, u8 *idcode)
 				* params->sectors_per_block
 				* params->nr_blocks;
 	stm.flash.erase_cmd = CMD_W25_SE;
+	stm.flash.erase_cmd_32k = CMD_W25_BE32;
+	stm.flash.erase_cmd_64k = CMD_W25_BE;
 	stm.flash.status_cmd = CMD_W25_RDSR;
+	stm.flash.program_time_us = 500;
 
 	return &stm.flash;
 }
@@ -20,6 +20,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <console/console.h>
+#include <arch/early_variables.h>
 #include <arch/io.h>
 #include <delay.h>
 #include <arch/hlt.h>
@@ -33,6 +34,13 @@
 #include "ec_commands.h"
 #include <vendorcode/google/chromeos/chromeos.h>
 
+/*
+ * The board version can't change while the system runs, so each stage
+ * asks the EC for it only once.
+ */
+static u16 ec_board_version CAR_GLOBAL;
+static int ec_board_version_valid CAR_GLOBAL;
+
 uint8_t google_chromeec_calc_checksum(const uint8_t *data, int size)
 {
 	int csum;
@@ -127,21 +135,32 @@ int google_chromeec_clear_events_b(u32 mask)
 }
 
 #ifndef __SMM__
-#ifdef __PRE_RAM__
-void google_chromeec_check_ec_image(int expected_type)
+/* EC_CMD_GET_VERSION for the EC itself. Returns the command status. */
+static int google_chromeec_get_version(struct ec_response_get_version *resp)
 {
 	struct chromeec_command cec_cmd;
-	struct ec_response_get_version cec_resp = { { 0 } };
 
 	cec_cmd.cmd_code = EC_CMD_GET_VERSION;
 	cec_cmd.cmd_version = 0;
-	cec_cmd.cmd_data_out = &cec_resp;
+	cec_cmd.cmd_data_out = resp;
 	cec_cmd.cmd_size_in = 0;
-	cec_cmd.cmd_size_out = sizeof(cec_resp);
+	cec_cmd.cmd_size_out = sizeof(*resp);
 	cec_cmd.cmd_dev_index = 0;
 	google_chromeec_command(&cec_cmd);
 
-	if (cec_cmd.cmd_code || cec_resp.current_image != expected_type) {
+	return cec_cmd.cmd_code;
+}
+
+#ifdef __PRE_RAM__
+void google_chromeec_check_ec_image(int expected_type)
+{
+	struct chromeec_command cec_cmd;
+	struct ec_response_get_version cec_resp = { { 0 } };
+	int status;
+
+	status = google_chromeec_get_version(&cec_resp);
+
+	if (status || cec_resp.current_image != expected_type) {
 		struct ec_params_reboot_ec reboot_ec;
 		/* Reboot the EC and make it come back in RO mode */
 		reboot_ec.cmd = EC_REBOOT_COLD;
@@ -211,16 +230,9 @@ void google_chromeec_early_pd_init(void)
 
 uint32_t google_chromeec_get_ec_image_type(void)
 {
-	struct chromeec_command cec_cmd;
 	struct ec_response_get_version cec_resp = { { 0 } };
 
-	cec_cmd.cmd_code = EC_CMD_GET_VERSION;
-	cec_cmd.cmd_version = 0;
-	cec_cmd.cmd_data_out = &cec_resp;
-	cec_cmd.cmd_size_in = 0;
-	cec_cmd.cmd_size_out = sizeof(cec_resp);
-	cec_cmd.cmd_dev_index = 0;
-	google_chromeec_command(&cec_cmd);
+	google_chromeec_get_version(&cec_resp);
 
 	return cec_resp.current_image;
 }
@@ -232,6 +244,9 @@ u16 google_chromeec_get_board_version(void)
 	struct chromeec_command cmd;
 	struct ec_response_board_version board_v;
 
+	if (car_get_var(ec_board_version_valid))
+		return car_get_var(ec_board_version);
+
 	cmd.cmd_code = EC_CMD_GET_BOARD_VERSION;
 	cmd.cmd_version = 0;
 	cmd.cmd_size_in = 0;
@@ -242,6 +257,8 @@ u16 google_chromeec_get_board_version(void)
 	if (google_chromeec_command(&cmd) != 0)
 		return 0;
 
+	car_set_var(ec_board_version, board_v.board_version);
+	car_set_var(ec_board_version_valid, 1);
 	return board_v.board_version;
 }
 
@@ -470,20 +487,15 @@ void google_chromeec_init(void)
 {
 	struct chromeec_command cec_cmd;
 	struct ec_response_get_version cec_resp = {{0}};
+	int status;
 
 	printk(BIOS_DEBUG, "Google Chrome EC: Initializing keyboard.\n");
 
 	google_chromeec_hello();
 
-	cec_cmd.cmd_code = EC_CMD_GET_VERSION;
-	cec_cmd.cmd_version = 0;
-	cec_cmd.cmd_data_out = &cec_resp;
-	cec_cmd.cmd_size_in = 0;
-	cec_cmd.cmd_size_out = sizeof(cec_resp);
-	cec_cmd.cmd_dev_index = 0;
-	google_chromeec_command(&cec_cmd);
+	status = google_chromeec_get_version(&cec_resp);
 
-	if (cec_cmd.cmd_code) {
+	if (status) {
 		printk(BIOS_DEBUG,
 		       "Google Chrome EC: version command failed!\n");
 	} else {
@@ -495,7 +507,7 @@ void google_chromeec_init(void)
 		ec_image_type = cec_resp.current_image;
 	}
 
-	if (cec_cmd.cmd_code ||
+	if (status ||
 	    (recovery_mode_enabled() &&
 	     (cec_resp.current_image != EC_IMAGE_RO))) {
 		struct ec_params_reboot_ec reboot_ec;
@@ -60,6 +60,9 @@ void *cbfs_load_optionrom(struct cbfs_media *media, uint16_t vendor,
 void *cbfs_load_payload(struct cbfs_media *media, const char *name);
 void *cbfs_load_stage(struct cbfs_media *media, const char *name);
 void *cbfs_load_stage_by_offset(struct cbfs_media *media, ssize_t offset);
+/* Same as above for the ramstage, which romstage may load from the
+ * retained ramstage cache. */
+void *cbfs_load_ramstage_by_offset(struct cbfs_media *media, ssize_t offset);
 
 /* Simple buffer for streaming media. */
 struct cbfs_simple_buffer {
@@ -117,6 +117,43 @@ void mp_initialize_cpu(void *unused);
 /* Returns apic id for coreboot cpu number or < 0 on failure. */
 int mp_get_apic_id(int cpu_slot);
 
+/*
+ * Running work on the APs after mp_init().
+ *
+ * With PARALLEL_MP_AP_WORK the APs don't park after the flight plan but
+ * wait for work the BSP posts to a shared mailbox. The calls below block
+ * until every AP has finished the work, so each of them is also a barrier.
+ * expire_us only bounds the wait for the APs to pick the work up. APs
+ * which miss it never run it and are not used again, APs which did pick
+ * it up are always waited for. A work function gets the coreboot cpu
+ * number and returns a result which is stored to results[cpu] if results
+ * is not NULL. results needs to have room for CONFIG_MAX_CPUS entries.
+ *
+ * The calls return 0 when every cpu returned 0, < 0 otherwise. When the
+ * APs are not available, either because the option is disabled or
+ * mp_init() failed, the work is simply done on the BSP only. The APs are
+ * parked for good before the OS or payload is started.
+ */
+typedef int (*mp_work_t)(int cpu, void *arg);
+
+/* Run func on all APs, not on the BSP unless there are no APs. */
+int mp_run_on_all_aps(mp_work_t func, void *arg, int *results,
+		      long expire_us);
+/* Run func on the BSP and all APs at the same time. */
+int mp_run_on_all_cpus(mp_work_t func, void *arg, int *results,
+		       long expire_us);
+/*
+ * Call func(index, arg) for every index in [0, count), spreading the
+ * indices over the BSP and all APs. Every index is handled even if some
+ * APs time out.
+ */
+int mp_parallel_for(int (*func)(int index, void *arg), void *arg, int count,
+		    long expire_us);
+/* Return the number of APs waiting for work. */
+int mp_num_aps_available(void);
+/* Stop all APs. Further work will only be done on the BSP. */
+void mp_park_aps(void);
+
 /*
  * SMM helpers to use with initializing CPUs.
  */
@@ -20,6 +20,7 @@
 #ifndef _DEVICE_I2C_H_
 #define _DEVICE_I2C_H_
 
+#include <delay.h>
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -132,4 +133,49 @@ static inline int i2c_writeb(unsigned bus, uint8_t chip, uint8_t reg,
 	return i2c_transfer(bus, &seg, 1);
 }
 
+/* One entry of a register write sequence, see i2c_write_sequence(). */
+struct i2c_reg_write {
+	uint8_t reg;
+	uint8_t val;
+	uint16_t delay_us;	/* settle time after this write */
+};
+
+/* Longest burst written in one frame, register address included */
+#define I2C_WRITE_SEQUENCE_MAX_BURST	16
+
+/**
+ * Write a table of registers in as few frames as possible.
+ *
+ * Entries for consecutive registers are sent as one auto-incrementing
+ * burst, as long as no entry in between asks for a delay:
+ *
+ * [start][slave addr][w][register addr][data 0][data 1]...[stop]
+ *
+ * The chip has to increment the register address on multi-byte writes.
+ * Returns 0 on success or the error of the frame that failed.
+ */
+static inline int i2c_write_sequence(unsigned bus, uint8_t chip,
+				     const struct i2c_reg_write *seq, int count)
+{
+	uint8_t buf[I2C_WRITE_SEQUENCE_MAX_BURST];
+	int i = 0, len, ret;
+
+	while (i < count) {
+		buf[0] = seq[i].reg;
+		len = 1;
+		do {
+			buf[len++] = seq[i++].val;
+		} while (i < count && len < ARRAY_SIZE(buf) &&
+			 !seq[i - 1].delay_us &&
+			 seq[i].reg == (uint8_t)(seq[i - 1].reg + 1));
+
+		ret = i2c_write_raw(bus, chip, buf, len);
+		if (ret)
+			return ret;
+		if (seq[i - 1].delay_us)
+			udelay(seq[i - 1].delay_us);
+	}
+	return 0;
+}
+
 #endif	/* _DEVICE_I2C_H_ */
@@ -146,6 +146,16 @@ struct elog_event_data_me_extended {
 /* CPU Thermal Trip */
 #define ELOG_TYPE_THERM_TRIP              0xa7
 
+/*
+ * Padding up to the next checkpoint in the log, see elog_internal.h. The
+ * record has no timestamp or data, only zeroes up to its checksum, and is
+ * not an event: it is left out of the event count and the size reported
+ * by LOG_CLEAR. There is about one per 256 bytes of log. Readers that
+ * don't know this type (mosys, older tools) list each of them as an event
+ * of unknown type 0xa8 with a zero timestamp. Reserved, do not reuse 0xa8.
+ */
+#define ELOG_TYPE_CHECKPOINT              0xa8
+
 #if CONFIG_ELOG
 /* Eventlog backing storage must be initialized before calling elog_init(). */
 extern int elog_init(void);
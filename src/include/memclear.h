@@ -0,0 +1,46 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#ifndef MEMCLEAR_H
+#define MEMCLEAR_H
+
+#include <stddef.h>
+
+/*
+ * Zero [base, base + size). Large ranges are cut into slices which are
+ * cleared by every CPU the architecture can put to work. The time taken
+ * and the bandwidth achieved are logged.
+ */
+void memclear(void *base, size_t size);
+
+/*
+ * Architecture hooks. Both have weak defaults.
+ *
+ * arch_memclear() zeroes a range on the calling CPU. The default is
+ * memset(); architectures may use cache-bypassing stores instead.
+ *
+ * arch_parallel_for() calls func(index, arg) for every index in
+ * [0, count), spreading the calls over the available CPUs. It blocks until
+ * every call has returned, there is no timeout, and returns < 0 if any
+ * call failed. The default makes all of the calls on the calling CPU.
+ */
+void arch_memclear(void *base, size_t size);
+int arch_parallel_for(int (*func)(int index, void *arg), void *arg,
+		      int count);
+
+#endif /* MEMCLEAR_H */
@@ -22,9 +22,12 @@
 #include <device/resource.h>
 
 /* A memranges structure consists of a list of range_entry(s). The structure
- * is exposed so that a memranges can be used on the stack if needed. */
+ * is exposed so that a memranges can be used on the stack if needed. The
+ * entries are also kept in a search tree so that an operation can find the
+ * entries it touches without walking the whole list. */
 struct memranges {
 	struct range_entry *entries;
+	struct range_entry *root;
 };
 
 /* Each region within a memranges structure is represented by a
@@ -36,6 +39,10 @@ struct range_entry {
 	resource_t end;
 	unsigned long tag;
 	struct range_entry *next;
+	/* Search tree linkage. Private to memrange.c. */
+	struct range_entry *left;
+	struct range_entry *right;
+	unsigned int priority;
 };
 
 /* Return inclusive base address of memory range. */
@@ -50,4 +50,24 @@ static inline int ramstage_cache_is_valid(const struct ramstage_cache *c)
 	return (c != NULL && c->magic == RAMSTAGE_CACHE_MAGIC);
 }
 
+/* With CONFIG_RETAINED_RAMSTAGE_CACHE the cache lives in DRAM that keeps
+ * its contents across warm resets. The chipset keeps this digest somewhere
+ * that is cleared on power loss, so a copy left in DRAM is only trusted
+ * when it was saved during the current power cycle. */
+struct ramstage_cache_digest {
+	uint64_t source;	/* compressed stage in CBFS and its header */
+	uint64_t image;		/* the cache header and the loaded program */
+};
+
+/* Chipset functions for keeping the digest. load returns 0 on success. */
+int ramstage_cache_load_digest(struct ramstage_cache_digest *digest);
+void ramstage_cache_save_digest(const struct ramstage_cache_digest *digest);
+
+struct cbfs_stage;
+
+/* Load the compressed stage at 'data' described by 'stage' from the retained
+ * cache if it holds that stage. Otherwise decompress it and save a copy for
+ * the next boot. Returns 0 on success. */
+int load_retained_ramstage(const struct cbfs_stage *stage, void *data);
+
 #endif  /* _RAMSTAGE_CACHE_ */
@@ -24,6 +24,21 @@
 
 #define RMODULE_MAGIC 0xf8fe
 #define RMODULE_VERSION_1 1
+#define RMODULE_VERSION_2 2
+
+/*
+ * Version 1 relocations are an array of the link addresses to adjust, one
+ * uintptr_t each.
+ *
+ * Version 2 relocations are a byte stream of unsigned LEB128 values that
+ * describe runs of adjacent, pointer aligned relocations. Positions are
+ * counted in pointers from a cursor that starts at
+ * module_link_start_address. Each run is one value v, followed by a
+ * second value n only when v is odd:
+ *   - the run starts v >> 1 pointers past the cursor,
+ *   - it is 1 pointer long if v is even, n + 2 pointers if v is odd,
+ *   - the cursor then moves to the pointer following the run.
+ */
 
 /* All fields with '_offset' in the name are byte offsets into the flat blob.
  * The linker and the linker script takes are of assigning the values.  */
@@ -61,8 +61,15 @@ struct spi_flash {
 
 	u8		erase_cmd;
 
+	/* Erase commands for 32K and 64K blocks, 0 if not supported */
+	u8		erase_cmd_32k;
+	u8		erase_cmd_64k;
+
 	u8		status_cmd;
 
+	/* Time after which to start polling for a page program to finish */
+	u16		program_time_us;
+
 	int		(*read)(struct spi_flash *flash, u32 offset,
 				size_t len, void *buf);
 	int		(*write)(struct spi_flash *flash, u32 offset,
@@ -97,6 +104,16 @@ static inline int spi_flash_status(struct spi_flash *flash, u8 *reg)
 	return flash->status(flash, reg);
 }
 
+/*
+ * Make [offset, offset + len) hold 'buf', touching the flash as little as
+ * possible: unchanged pages are skipped, pages that only clear bits are
+ * programmed in place and only the sectors that need it are erased, using
+ * the largest erase command that fits. A sector to erase must lie entirely
+ * within the range unless the bytes outside the range are already erased.
+ */
+int spi_flash_update(struct spi_flash *flash, u32 offset, size_t len,
+		     const void *buf);
+
 void lb_spi_flash(struct lb_header *header);
 
 #endif /* _SPI_FLASH_H_ */
@@ -50,6 +50,8 @@ enum timestamp_id {
 	TS_END_COPYROM = 14,
 	TS_START_ULZMA = 15,
 	TS_END_ULZMA = 16,
+	TS_START_MEMCLEAR = 17,
+	TS_END_MEMCLEAR = 18,
 	TS_DEVICE_ENUMERATE = 30,
 	TS_FSP_BEFORE_ENUMERATE = 31,
 	TS_FSP_AFTER_ENUMERATE = 32,
@@ -39,6 +39,8 @@
 #include <string.h>
 #include <cbmem.h>
 #include <arch_ops.h>
+#include <ramstage_cache.h>
+#include <rules.h>
 
 #ifdef LIBPAYLOAD
 # include <stdio.h>
@@ -176,7 +178,9 @@ void * cbfs_load_stage(struct cbfs_media *media, const char *name)
 
 #else
 
-void *cbfs_load_stage_by_offset(struct cbfs_media *media, ssize_t offset)
+/* 'ramstage' lets romstage reuse a copy of it retained across reboots. */
+static void *load_stage_by_offset(struct cbfs_media *media, ssize_t offset,
+				  int ramstage)
 {
 	struct cbfs_stage stage;
 
@@ -205,8 +209,13 @@ void *cbfs_load_stage_by_offset(struct cbfs_media *media, ssize_t offset)
 			ERROR("ERROR: Mapping stage failed.\n");
 			return CBFS_LOAD_ERROR;
 		}
-		if (cbfs_decompress(stage.compression, data,
-				    (void *)(uintptr_t)stage.load, stage.len))
+		if (IS_ENABLED(CONFIG_RETAINED_RAMSTAGE_CACHE) &&
+		    ENV_ROMSTAGE && ramstage) {
+			if (load_retained_ramstage(&stage, data))
+				return CBFS_LOAD_ERROR;
+		} else if (cbfs_decompress(stage.compression, data,
+					   (void *)(uintptr_t)stage.load,
+					   stage.len))
 			return CBFS_LOAD_ERROR;
 		media->unmap(media, data);
 	}
@@ -223,6 +232,26 @@ void *cbfs_load_stage_by_offset(struct cbfs_media *media, ssize_t offset)
 	return (void *)(uintptr_t)stage.entry;
 }
 
+void *cbfs_load_stage_by_offset(struct cbfs_media *media, ssize_t offset)
+{
+	return load_stage_by_offset(media, offset, 0);
+}
+
+void *cbfs_load_ramstage_by_offset(struct cbfs_media *media, ssize_t offset)
+{
+	return load_stage_by_offset(media, offset, 1);
+}
+
+/* Matches "ramstage" with any prefix, like "fallback/ramstage". */
+static int is_ramstage_name(const char *name)
+{
+	const char *slash;
+
+	while ((slash = strchr(name, '/')) != NULL)
+		name = slash + 1;
+	return !strcmp(name, "ramstage");
+}
+
 void *cbfs_load_stage(struct cbfs_media *media, const char *name)
 {
 	struct cbfs_media default_media;
@@ -235,7 +264,7 @@ void *cbfs_load_stage(struct cbfs_media *media, const char *name)
 	if (offset < 0 || file.type != CBFS_TYPE_STAGE)
 		return CBFS_LOAD_ERROR;
 
-	return cbfs_load_stage_by_offset(media, offset);
+	return load_stage_by_offset(media, offset, is_ramstage_name(name));
 }
 #endif /* CONFIG_RELOCATABLE_RAMSTAGE */
 
@@ -328,6 +328,7 @@ static void add_cbmem_pointers(struct lb_header *header)
 		{CBMEM_ID_CONSOLE, LB_TAG_CBMEM_CONSOLE},
 		{CBMEM_ID_ACPI_GNVS, LB_TAG_ACPI_GNVS},
 		{CBMEM_ID_VPD, LB_TAG_VPD},
+		{CBMEM_ID_VPD_INDEX, LB_TAG_VPD_INDEX},
 		{CBMEM_ID_WIFI_CALIBRATION, LB_TAG_WIFI_CALIBRATION}
 	};
 	int i;
@@ -96,6 +96,8 @@ static void setinput __P((struct in *, unsigned char *));
 static void idctqtab __P((unsigned char *, PREC *));
 static void idct __P((int *, int *, PREC *, PREC, int));
 static void scaleidctqtab __P((PREC *, PREC));
+static void idctqtab_scaled __P((unsigned char *, PREC *));
+static void idct_scaled __P((int *, int *, PREC *, PREC, int, int));
 
 /*********************************/
 
@@ -104,6 +106,7 @@ static void initcol __P((PREC[][64]));
 static void col221111 __P((int *, unsigned char *, int));
 static void col221111_16 __P((int *, unsigned char *, int));
 static void col221111_32 __P((int *, unsigned char *, int));
+static void col221111_scaled __P((int *, unsigned char *, int, int, int));
 
 /*********************************/
 
@@ -270,15 +273,48 @@ int jpeg_check_size(unsigned char *buf, int width, int height)
         return 1;
 }
 
+/*
+ * Return the smallest scale jpeg_decode_fb() can use to fit a width x
+ * height picture into a xres x yres screen, or 0 if it never fits.
+ */
+int jpeg_fit_scale(int width, int height, int xres, int yres)
+{
+	int scale;
+
+	for (scale = 1; scale <= 8; scale *= 2)
+		if (width / scale <= xres && height / scale <= yres)
+			return scale;
+	return 0;
+}
+
 int jpeg_decode(unsigned char *buf, unsigned char *pic,
 		int width, int height, int depth, struct jpeg_decdata *decdata)
+{
+	return jpeg_decode_fb(buf, pic, width, height, depth,
+			      width * depth / 8, 1, decdata);
+}
+
+/*
+ * Decode straight into a framebuffer with bytes_per_line bytes per line.
+ * width and height are those of the image, which is scaled down by
+ * 1, 2, 4 or 8 on the way.
+ */
+int jpeg_decode_fb(unsigned char *buf, unsigned char *pic,
+		int width, int height, int depth, int bytes_per_line,
+		int scale, struct jpeg_decdata *decdata)
 {
 	int i, j, m, tac, tdc;
 	int mcusx, mcusy, mx, my;
 	int max[6];
+	int n, mcusize;
+	unsigned char *mcu;
 
 	if (!decdata || !buf || !pic)
 		return -1;
+	if (depth != 16 && depth != 24 && depth != 32)
+		return ERR_DEPTH_MISMATCH;
+	if (scale != 1 && scale != 2 && scale != 4 && scale != 8)
+		return ERR_BAD_SCALE;
 	datap = buf;
 	if (getbyte() != 0xff)
 		return ERR_NO_SOI;
@@ -350,11 +386,18 @@ int jpeg_decode(unsigned char *buf, unsigned char *pic,
 
 	mcusx = width >> 4;
 	mcusy = height >> 4;
+	n = 8 / scale;			/* pixels per block edge */
+	mcusize = 2 * n;		/* pixels per MCU edge */
 
-
-	idctqtab(quant[dscans[0].tq], decdata->dquant[0]);
-	idctqtab(quant[dscans[1].tq], decdata->dquant[1]);
-	idctqtab(quant[dscans[2].tq], decdata->dquant[2]);
+	if (scale == 1) {
+		idctqtab(quant[dscans[0].tq], decdata->dquant[0]);
+		idctqtab(quant[dscans[1].tq], decdata->dquant[1]);
+		idctqtab(quant[dscans[2].tq], decdata->dquant[2]);
+	} else {
+		idctqtab_scaled(quant[dscans[0].tq], decdata->dquant[0]);
+		idctqtab_scaled(quant[dscans[1].tq], decdata->dquant[1]);
+		idctqtab_scaled(quant[dscans[2].tq], decdata->dquant[2]);
+	}
 	initcol(decdata->dquant);
 	setinput(&glob_in, datap);
 
@@ -377,6 +420,21 @@ int jpeg_decode(unsigned char *buf, unsigned char *pic,
 					return ERR_WRONG_MARKER;
 
 			decode_mcus(&glob_in, decdata->dcts, 6, dscans, max);
+			mcu = pic + my * mcusize * bytes_per_line +
+			      mx * mcusize * (depth / 8);
+
+			if (scale != 1) {
+				for (i = 0; i < 6; i++)
+					idct_scaled(decdata->dcts + i * 64,
+						decdata->out + i * 64,
+						decdata->dquant[i < 4 ? 0 : i - 3],
+						i < 4 ? IFIX(128.5) : IFIX(0.5),
+						max[i], n);
+				col221111_scaled(decdata->out, mcu,
+						 bytes_per_line, depth, n);
+				continue;
+			}
+
 			idct(decdata->dcts, decdata->out, decdata->dquant[0], IFIX(128.5), max[0]);
 			idct(decdata->dcts + 64, decdata->out + 64, decdata->dquant[0], IFIX(128.5), max[1]);
 			idct(decdata->dcts + 128, decdata->out + 128, decdata->dquant[0], IFIX(128.5), max[2]);
@@ -386,16 +444,13 @@ int jpeg_decode(unsigned char *buf, unsigned char *pic,
 
 			switch (depth) {
 			case 32:
-				col221111_32(decdata->out, pic + (my * 16 * mcusx + mx) * 16 * 4, mcusx * 16 * 4);
+				col221111_32(decdata->out, mcu, bytes_per_line);
 				break;
 			case 24:
-				col221111(decdata->out, pic + (my * 16 * mcusx + mx) * 16 * 3, mcusx * 16 * 3);
+				col221111(decdata->out, mcu, bytes_per_line);
 				break;
 			case 16:
-				col221111_16(decdata->out, pic + (my * 16 * mcusx + mx) * (16 * 2), mcusx * (16 * 2));
-				break;
-			default:
-				return ERR_DEPTH_MISMATCH;
+				col221111_16(decdata->out, mcu, bytes_per_line);
 				break;
 			}
 		}
@@ -697,6 +752,14 @@ void idct(int *in, int *out, PREC *lquant, PREC off, int max)
 		t3 = in[j] * lquant[j];
 		j = *zig2p++;
 		t6 = in[j] * lquant[j];
+		if (!(t1 | t2 | t3 | t4 | t5 | t6 | t7)) {
+			/* Most AC coefficients are 0: the line is flat. */
+			tmpp[0 * 8] = tmpp[1 * 8] = tmpp[2 * 8] = tmpp[3 * 8] = t0;
+			tmpp[4 * 8] = tmpp[5 * 8] = tmpp[6 * 8] = tmpp[7 * 8] = t0;
+			tmpp++;
+			t0 = 0;
+			continue;
+		}
 		IDCT;
 		tmpp[0 * 8] = t0;
 		tmpp[1 * 8] = t1;
@@ -767,6 +830,78 @@ static void scaleidctqtab(PREC *q, PREC sc)
 		q[i] = IMULT(q[i], sc);
 }
 
+/*
+ * Reduced size IDCT for decoding at 1/2, 1/4 and 1/8 scale. An n x n
+ * block is reconstructed from the n x n lowest frequency coefficients,
+ * which samples the full IDCT at the center of each scale x scale
+ * square. The tables hold cos((2x + 1) * u * pi / (2 * n)).
+ */
+static const PREC idct_cos4[4][4] = {
+	{ ONE, IFIX(0.923879533), IFIX(0.707106781), IFIX(0.382683432) },
+	{ ONE, IFIX(0.382683432), IFIX(-0.707106781), IFIX(-0.923879533) },
+	{ ONE, IFIX(-0.382683432), IFIX(-0.707106781), IFIX(0.923879533) },
+	{ ONE, IFIX(-0.923879533), IFIX(0.707106781), IFIX(-0.382683432) },
+};
+
+static const PREC idct_cos2[2][2] = {
+	{ ONE, IFIX(0.707106781) },
+	{ ONE, IFIX(-0.707106781) },
+};
+
+/* The intermediate values don't fit the int products IMULT does. */
+#define LMULT(a, b) ((PREC)(((long long)(a) * (b)) >> ISHIFT))
+
+static void idctqtab_scaled(unsigned char *qin, PREC *qout)
+{
+	int i, j;
+	PREC ci, cj;
+
+	for (i = 0; i < 8; i++) {
+		ci = i ? IFIX(0.5) : IFIX(0.3535533906);
+		for (j = 0; j < 8; j++) {
+			cj = j ? IFIX(0.5) : IFIX(0.3535533906);
+			qout[zig[i * 8 + j]] = qin[zig[i * 8 + j]] *
+						IMULT(ci, cj);
+		}
+	}
+}
+
+static void idct_scaled(int *in, int *out, PREC *lquant, PREC off, int max,
+			int n)
+{
+	const PREC *cos = n == 4 ? &idct_cos4[0][0] : &idct_cos2[0][0];
+	PREC coef[16], tmp[16], t;
+	int u, v, x, y;
+
+	if (max == 1 || n == 1) {
+		t = ITOINT(off + in[0] * lquant[0]);
+		for (x = 0; x < n * n; x++)
+			out[x] = t;
+		return;
+	}
+
+	for (v = 0; v < n; v++)
+		for (u = 0; u < n; u++)
+			coef[v * n + u] = in[zig[v * 8 + u]] *
+					  lquant[zig[v * 8 + u]];
+	for (v = 0; v < n; v++) {
+		for (x = 0; x < n; x++) {
+			t = 0;
+			for (u = 0; u < n; u++)
+				t += LMULT(coef[v * n + u], cos[x * n + u]);
+			tmp[v * n + x] = t;
+		}
+	}
+	for (y = 0; y < n; y++) {
+		for (x = 0; x < n; x++) {
+			t = off;
+			for (v = 0; v < n; v++)
+				t += LMULT(tmp[v * n + x], cos[y * n + v]);
+			out[y * n + x] = ITOINT(t);
+		}
+	}
+}
+
 /****************************************************************/
 /**************          color decoder            ***************/
 /****************************************************************/
@@ -984,3 +1119,37 @@ static void col221111_32(int *out, unsigned char *pic, int width)
 		outy += 64 * 2 - 16 * 4;
 	}
 }
+
+/*
+ * Color conversion for scaled decoding, n is the block size. Uses the
+ * same pixel formats as the functions above.
+ */
+static void col221111_scaled(int *out, unsigned char *pic, int width,
+			     int depth, int n)
+{
+	int i, j;
+	unsigned char *p;
+	int *outy, *outc;
+	int cr, cg, cb, y;
+
+	for (i = 0; i < 2 * n; i++) {
+		p = pic + i * width;
+		for (j = 0; j < 2 * n; j++) {
+			outy = out + (i / n * 2 + j / n) * 64 +
+			       i % n * n + j % n;
+			outc = out + 64 * 4 + i / 2 * n + j / 2;
+			CBCRCG(0, 0);
+			switch (depth) {
+			case 32:
+				PIC_32(0, 0, p, j);
+				break;
+			case 24:
+				PIC(0, 0, p, j);
+				break;
+			case 16:
+				PIC_16(0, 0, p, j, 1);
+				break;
+			}
+		}
+	}
+}
@@ -41,6 +41,7 @@
 #define ERR_NO_EOI 13
 #define ERR_BAD_TABLES 14
 #define ERR_DEPTH_MISMATCH 15
+#define ERR_BAD_SCALE 16
 
 struct jpeg_decdata {
 	int dcts[6 * 64 + 16];
@@ -49,6 +50,9 @@ struct jpeg_decdata {
 };
 
 int jpeg_decode(unsigned char *, unsigned char *, int, int, int, struct jpeg_decdata *);
+int jpeg_decode_fb(unsigned char *, unsigned char *, int, int, int, int, int,
+		   struct jpeg_decdata *);
 int jpeg_check_size(unsigned char *, int, int);
+int jpeg_fit_scale(int, int, int, int);
 
 #endif
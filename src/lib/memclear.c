@@ -0,0 +1,98 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <console/console.h>
+#include <memclear.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <timer.h>
+#include <timestamp.h>
+
+/* Ranges smaller than this are not worth handing to other CPUs. */
+#define MEMCLEAR_PARALLEL_MIN	(4 * MiB)
+/* Unit of work picked up by one CPU at a time. */
+#define MEMCLEAR_SLICE		(2 * MiB)
+
+struct memclear_job {
+	uintptr_t base;
+	uintptr_t end;
+};
+
+void __attribute__((weak)) arch_memclear(void *base, size_t size)
+{
+	memset(base, 0, size);
+}
+
+int __attribute__((weak)) arch_parallel_for(int (*func)(int index, void *arg),
+					    void *arg, int count)
+{
+	int i;
+	int ret = 0;
+
+	for (i = 0; i < count; i++)
+		if (func(i, arg) != 0)
+			ret = -1;
+	return ret;
+}
+
+static int memclear_slice(int index, void *arg)
+{
+	const struct memclear_job *job = arg;
+	uintptr_t start = job->base + (uintptr_t)index * MEMCLEAR_SLICE;
+
+	arch_memclear((void *)start, MIN(job->end - start,
+					 (uintptr_t)MEMCLEAR_SLICE));
+	return 0;
+}
+
+void memclear(void *base, size_t size)
+{
+	struct memclear_job job = {
+		.base = (uintptr_t)base,
+		.end = (uintptr_t)base + size,
+	};
+	int slices;
+#if CONFIG_HAVE_MONOTONIC_TIMER
+	struct stopwatch sw;
+	long usecs;
+#endif
+
+	if (size < MEMCLEAR_PARALLEL_MIN) {
+		arch_memclear(base, size);
+		return;
+	}
+
+	timestamp_add_now(TS_START_MEMCLEAR);
+#if CONFIG_HAVE_MONOTONIC_TIMER
+	stopwatch_init(&sw);
+#endif
+
+	/* memclear_slice() can't fail and this returns once all are done. */
+	slices = ALIGN_UP(size, MEMCLEAR_SLICE) / MEMCLEAR_SLICE;
+	arch_parallel_for(memclear_slice, &job, slices);
+
+	timestamp_add_now(TS_END_MEMCLEAR);
+#if CONFIG_HAVE_MONOTONIC_TIMER
+	usecs = stopwatch_duration_usecs(&sw);
+	printk(BIOS_DEBUG, "memclear: %zu KiB in %ld us (%llu MiB/s)\n",
+	       size >> 10, usecs,
+	       usecs ? (unsigned long long)size / usecs * 1000000 / MiB : 0);
+#endif
+}
@@ -38,9 +38,106 @@ static inline void range_entry_unlink(struct range_entry **prev_ptr,
 	r->next = NULL;
 }
 
-static inline void range_entry_unlink_and_free(struct range_entry **prev_ptr,
+/*
+ * The entries of a memranges are kept in a treap ordered by address next to
+ * the sorted list. Entries never overlap, so ordering them by begin orders
+ * them by end as well, and the entries an operation starts at can be looked
+ * up in O(log n) instead of walking the list from the front.
+ */
+static unsigned int range_entry_priority(void)
+{
+	static unsigned int seed = 2463534242U;
+
+	/* xorshift32: enough to keep the treap balanced on average. */
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+static struct range_entry *tree_insert(struct range_entry *t,
+                                       struct range_entry *r)
+{
+	struct range_entry *child;
+
+	if (t == NULL)
+		return r;
+
+	if (r->begin < t->begin) {
+		t->left = tree_insert(t->left, r);
+		if (t->left->priority > t->priority) {
+			/* Rotate right. */
+			child = t->left;
+			t->left = child->right;
+			child->right = t;
+			return child;
+		}
+	} else {
+		t->right = tree_insert(t->right, r);
+		if (t->right->priority > t->priority) {
+			/* Rotate left. */
+			child = t->right;
+			t->right = child->left;
+			child->left = t;
+			return child;
+		}
+	}
+	return t;
+}
+
+/* Join two treaps where every entry in a comes before every entry in b. */
+static struct range_entry *tree_join(struct range_entry *a,
+                                     struct range_entry *b)
+{
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+	if (a->priority > b->priority) {
+		a->right = tree_join(a->right, b);
+		return a;
+	}
+	b->left = tree_join(a, b->left);
+	return b;
+}
+
+static struct range_entry *tree_remove(struct range_entry *t,
+                                       const struct range_entry *r)
+{
+	if (t == NULL)
+		return NULL;
+	if (t == r)
+		return tree_join(t->left, t->right);
+	if (r->begin < t->begin)
+		t->left = tree_remove(t->left, r);
+	else
+		t->right = tree_remove(t->right, r);
+	return t;
+}
+
+/* Return the last entry ending before addr, NULL if there is none. */
+static struct range_entry *tree_last_before(const struct memranges *ranges,
+                                            resource_t addr)
+{
+	struct range_entry *t = ranges->root;
+	struct range_entry *found = NULL;
+
+	while (t != NULL) {
+		if (t->end < addr) {
+			found = t;
+			t = t->right;
+		} else {
+			t = t->left;
+		}
+	}
+	return found;
+}
+
+static inline void range_entry_unlink_and_free(struct memranges *ranges,
+                                               struct range_entry **prev_ptr,
                                                struct range_entry *r)
 {
+	ranges->root = tree_remove(ranges->root, r);
 	range_entry_unlink(prev_ptr, r);
 	range_entry_link(&free_list, r);
 }
@@ -58,8 +155,8 @@ static struct range_entry *alloc_range(void)
 }
 
 static inline struct range_entry *
-range_list_add(struct range_entry **prev_ptr, resource_t begin, resource_t end,
-               unsigned long tag)
+range_list_add(struct memranges *ranges, struct range_entry **prev_ptr,
+               resource_t begin, resource_t end, unsigned long tag)
 {
 	struct range_entry *new_entry;
 
@@ -71,7 +168,11 @@ range_list_add(struct range_entry **prev_ptr, resource_t begin, resource_t end,
 	new_entry->begin = begin;
 	new_entry->end = end;
 	new_entry->tag = tag;
+	new_entry->left = NULL;
+	new_entry->right = NULL;
+	new_entry->priority = range_entry_priority();
 	range_entry_link(prev_ptr, new_entry);
+	ranges->root = tree_insert(ranges->root, new_entry);
 
 	return new_entry;
 }
@@ -95,7 +196,7 @@ static void merge_neighbor_entries(struct memranges *ranges)
 		 * the list. */
 		if (prev->end + 1 >= cur->begin && prev->tag == cur->tag) {
 			prev->end = cur->end;
-			range_entry_unlink_and_free(&prev->next, cur);
+			range_entry_unlink_and_free(ranges, &prev->next, cur);
 			/* Set cur to prev so cur->next is valid since cur
 			 * was just unlinked and free. */
 			cur = prev;
@@ -106,6 +207,25 @@ static void merge_neighbor_entries(struct memranges *ranges)
 	}
 }
 
+/* Merge r with the entries around it if they touch and have the same tag.
+ * prev is the entry before r, NULL if r is the first one. */
+static void merge_entry_neighbors(struct memranges *ranges,
+                                  struct range_entry *prev,
+                                  struct range_entry *r)
+{
+	struct range_entry *next = r->next;
+
+	if (next != NULL && r->end + 1 >= next->begin && r->tag == next->tag) {
+		r->end = next->end;
+		range_entry_unlink_and_free(ranges, &r->next, next);
+	}
+
+	if (prev != NULL && prev->end + 1 >= r->begin && prev->tag == r->tag) {
+		prev->end = r->end;
+		range_entry_unlink_and_free(ranges, &prev->next, r);
+	}
+}
+
 static void remove_memranges(struct memranges *ranges,
                              resource_t begin, resource_t end,
                              unsigned long unused)
@@ -114,8 +234,10 @@ static void remove_memranges(struct memranges *ranges,
 	struct range_entry *next;
 	struct range_entry **prev_ptr;
 
-	prev_ptr = &ranges->entries;
-	for (cur = ranges->entries; cur != NULL; cur = next) {
+	/* Skip the entries ending before the removal range. */
+	cur = tree_last_before(ranges, begin);
+	prev_ptr = cur != NULL ? &cur->next : &ranges->entries;
+	for (cur = *prev_ptr; cur != NULL; cur = next) {
 		resource_t tmp_end;
 
 		/* Cache the next value to handle unlinks. */
@@ -140,7 +262,7 @@ static void remove_memranges(struct memranges *ranges,
 			/* Full removal. */
 			if (end >= cur->end) {
 				begin = cur->end + 1;
-				range_entry_unlink_and_free(prev_ptr, cur);
+				range_entry_unlink_and_free(ranges, prev_ptr, cur);
 				continue;
 			}
 		}
@@ -155,7 +277,8 @@ static void remove_memranges(struct memranges *ranges,
 
 		/* Hole punched in middle of entry. */
 		if (begin > cur->begin && tmp_end < cur->end) {
-			range_list_add(&cur->next, end + 1, cur->end, cur->tag);
+			range_list_add(ranges, &cur->next, end + 1, cur->end,
+			               cur->tag);
 			cur->end = begin - 1;
 			break;
 		}
@@ -174,34 +297,24 @@ static void merge_add_memranges(struct memranges *ranges,
                                    resource_t begin, resource_t end,
                                    unsigned long tag)
 {
-	struct range_entry *cur;
+	struct range_entry *prev;
+	struct range_entry *new_entry;
 	struct range_entry **prev_ptr;
 
-	prev_ptr = &ranges->entries;
-
 	/* Remove all existing entries covered by the range. */
 	remove_memranges(ranges, begin, end, -1);
 
 	/* Find the entry to place the new entry after. Since
 	 * remove_memranges() was called above there is a guranteed
 	 * spot for this new entry. */
-	for (cur = ranges->entries; cur != NULL; cur = cur->next) {
-		/* Found insertion spot before current entry. */
-		if (end < cur->begin)
-			break;
-
-		/* Keep track of previous entry to insert new entry after it. */
-		prev_ptr = &cur->next;
-
-		/* The new entry starts after this one. */
-		if (begin > cur->end)
-			continue;
-
-	}
-
-	/* Add new entry and merge with neighbors. */
-	range_list_add(prev_ptr, begin, end, tag);
-	merge_neighbor_entries(ranges);
+	prev = tree_last_before(ranges, begin);
+	prev_ptr = prev != NULL ? &prev->next : &ranges->entries;
+
+	/* Add new entry and merge with neighbors. All other entries are
+	 * already merged, so only the new entry's neighbors can change. */
+	new_entry = range_list_add(ranges, prev_ptr, begin, end, tag);
+	if (new_entry != NULL)
+		merge_entry_neighbors(ranges, prev, new_entry);
 }
 
 typedef void (*range_action_t)(struct memranges *ranges,
@@ -269,6 +382,7 @@ void memranges_add_resources(struct memranges *ranges,
 void memranges_init_empty(struct memranges *ranges)
 {
 	ranges->entries = NULL;
+	ranges->root = NULL;
 }
 
 void memranges_init(struct memranges *ranges,
@@ -282,7 +396,8 @@ void memranges_init(struct memranges *ranges,
 void memranges_teardown(struct memranges *ranges)
 {
 	while (ranges->entries != NULL) {
-		range_entry_unlink_and_free(&ranges->entries, ranges->entries);
+		range_entry_unlink_and_free(ranges, &ranges->entries,
+		                            ranges->entries);
 	}
 }
 
@@ -308,8 +423,8 @@ void memranges_fill_holes_up_to(struct memranges *ranges,
 			end = cur->begin - 1;
 			if (end >= limit)
 				end = limit - 1;
-			range_list_add(&prev->next, range_entry_end(prev),
-			               end, tag);
+			range_list_add(ranges, &prev->next,
+			               range_entry_end(prev), end, tag);
 		}
 
 		prev = cur;
@@ -323,7 +438,7 @@ void memranges_fill_holes_up_to(struct memranges *ranges,
 	/* Handle the case where the limit was never reached. A new entry needs
 	 * to be added to cover the range up to the limit. */
 	if (prev != NULL && range_entry_end(prev) < limit)
-		range_list_add(&prev->next, range_entry_end(prev),
+		range_list_add(ranges, &prev->next, range_entry_end(prev),
 		               limit - 1, tag);
 
 	/* Merge all entries that were newly added. */
@@ -24,7 +24,116 @@
 #include <ramstage_cache.h>
 #include <romstage_handoff.h>
 
-#if CONFIG_CACHE_RELOCATED_RAMSTAGE_OUTSIDE_CBMEM
+#if CONFIG_RETAINED_RAMSTAGE_CACHE
+
+/*
+ * Two independent 32-bit lanes give a 64-bit digest at word speed. This is
+ * an integrity check against decay and stale copies, not a cryptographic
+ * hash: see the RETAINED_RAMSTAGE_CACHE help text.
+ */
+static inline void digest_mix(uint32_t *a, uint32_t *b, uint32_t v)
+{
+	*a = (*a ^ v) * 0x01000193;
+	*b += v;
+	*b = ((*b << 13) | (*b >> 19)) * 5 + 0xe6546b64;
+}
+
+static uint64_t hash_words(const void *buf, size_t size, uint64_t seed)
+{
+	const uint32_t *w = buf;
+	const uint8_t *p;
+	uint32_t a = seed ^ 0x811c9dc5, b = seed >> 32;
+	size_t i = 0;
+
+	if (!((uintptr_t)buf % sizeof(*w))) {
+		for (; i < size / sizeof(*w); i++)
+			digest_mix(&a, &b, w[i]);
+		i *= sizeof(*w);
+	}
+	for (p = buf; i < size; i++)
+		digest_mix(&a, &b, p[i]);
+
+	return (uint64_t)b << 32 | a;
+}
+
+static uint64_t source_digest(const struct cbfs_stage *stage,
+			      const void *data)
+{
+	return hash_words(data, stage->len,
+			  hash_words(stage, sizeof(*stage), 0));
+}
+
+static uint64_t image_digest(const struct ramstage_cache *cache)
+{
+	return hash_words(cache, sizeof(*cache) + cache->size, 0);
+}
+
+static int cache_holds(const struct ramstage_cache *cache, long cache_size,
+		       const struct cbfs_stage *stage, uint64_t source)
+{
+	struct ramstage_cache_digest saved;
+
+	if (ramstage_cache_load_digest(&saved) || saved.source != source)
+		return 0;
+	if (!ramstage_cache_is_valid(cache) ||
+	    cache->load_address != stage->load ||
+	    cache->entry_point != stage->entry ||
+	    cache->size != stage->memlen ||
+	    sizeof(*cache) + cache->size > cache_size)
+		return 0;
+	if (image_digest(cache) != saved.image) {
+		printk(BIOS_DEBUG, "Retained ramstage at %p is corrupted.\n",
+		       cache);
+		return 0;
+	}
+	return 1;
+}
+
+int load_retained_ramstage(const struct cbfs_stage *stage, void *data)
+{
+	struct ramstage_cache_digest digest = { 0 };
+	struct ramstage_cache *cache;
+	long cache_size = 0;
+	void *load = (void *)(uintptr_t)stage->load;
+
+	cache = ramstage_cache_location(&cache_size);
+	if (cache == NULL)
+		return cbfs_decompress(stage->compression, data, load,
+				       stage->len);
+
+	digest.source = source_digest(stage, data);
+	if (cache_holds(cache, cache_size, stage, digest.source)) {
+		printk(BIOS_DEBUG, "Loading ramstage from %p.\n", cache);
+		memcpy(load, &cache->program[0], cache->size);
+		return 0;
+	}
+
+	if (cbfs_decompress(stage->compression, data, load, stage->len))
+		return -1;
+
+	/* Drop the old digest first so a torn update is never trusted. */
+	ramstage_cache_save_digest(&(struct ramstage_cache_digest){ 0 });
+
+	if (sizeof(*cache) + stage->memlen > cache_size) {
+		printk(BIOS_DEBUG, "cache size too small: 0x%08zx > 0x%08lx\n",
+		       sizeof(*cache) + stage->memlen, cache_size);
+		return 0;
+	}
+
+	cache->magic = RAMSTAGE_CACHE_MAGIC;
+	cache->entry_point = stage->entry;
+	cache->load_address = stage->load;
+	cache->size = stage->memlen;
+
+	printk(BIOS_DEBUG, "Saving ramstage to %p.\n", cache);
+	memcpy(&cache->program[0], load, stage->memlen);
+
+	digest.image = image_digest(cache);
+	ramstage_cache_save_digest(&digest);
+	return 0;
+}
+
+#elif CONFIG_CACHE_RELOCATED_RAMSTAGE_OUTSIDE_CBMEM
 
 void cache_loaded_ramstage(struct romstage_handoff *handoff,
                            const struct cbmem_entry *ramstage,
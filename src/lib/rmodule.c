@@ -55,7 +55,8 @@ int rmodule_parse(void *ptr, struct rmodule *module)
 	/* Sanity check the raw data. */
 	if (rhdr->magic != RMODULE_MAGIC)
 		return -1;
-	if (rhdr->version != RMODULE_VERSION_1)
+	if (rhdr->version != RMODULE_VERSION_1 &&
+	    rhdr->version != RMODULE_VERSION_2)
 		return -1;
 
 	/* Indicate the module hasn't been loaded yet. */
@@ -114,14 +115,15 @@ static void rmodule_clear_bss(struct rmodule *module)
 	memset(begin, 0, size);
 }
 
-static inline size_t rmodule_number_relocations(const struct rmodule *module)
+static inline size_t rmodule_relocations_size(const struct rmodule *module)
 {
-	size_t r;
+	return module->header->relocations_end_offset -
+	       module->header->relocations_begin_offset;
+}
 
-	r = module->header->relocations_end_offset;
-	r -= module->header->relocations_begin_offset;
-	r /= sizeof(uintptr_t);
-	return r;
+static inline size_t rmodule_number_relocations(const struct rmodule *module)
+{
+	return rmodule_relocations_size(module) / sizeof(uintptr_t);
 }
 
 static void rmodule_copy_payload(const struct rmodule *module)
@@ -172,6 +174,73 @@ static int rmodule_relocate(const struct rmodule *module)
 	return 0;
 }
 
+/* Read one unsigned LEB128 value. Returns NULL if it runs past 'end'. */
+static const uint8_t *rmodule_read_value(const uint8_t *p, const uint8_t *end,
+					 size_t *value)
+{
+	unsigned int shift = 0;
+
+	*value = 0;
+	do {
+		if (p == end || shift >= 8 * sizeof(*value))
+			return NULL;
+		*value |= (size_t)(*p & 0x7f) << shift;
+		shift += 7;
+	} while (*p++ & 0x80);
+
+	return p;
+}
+
+/* Apply version 2 relocations, see rmodule-defs.h for the encoding. */
+static int rmodule_relocate_packed(const struct rmodule *module)
+{
+	const uint8_t *p = module->relocations;
+	const uint8_t *end = p + rmodule_relocations_size(module);
+	uintptr_t *loc = module->location;
+	uintptr_t *limit = loc + rmodule_memory_size(module) / sizeof(*loc);
+	uintptr_t adjustment;
+	size_t value, count;
+	size_t num_relocations = 0;
+
+	adjustment = (uintptr_t)rmodule_load_addr(module, 0);
+
+	while (p != end) {
+		p = rmodule_read_value(p, end, &value);
+		if (p == NULL)
+			return -1;
+		count = 1;
+		if (value & 1) {
+			p = rmodule_read_value(p, end, &count);
+			if (p == NULL)
+				return -1;
+			count += 2;
+		}
+
+		value >>= 1;
+		if (value > (size_t)(limit - loc) ||
+		    count > (size_t)(limit - loc) - value) {
+			printk(BIOS_ERR, "rmodule relocations out of bounds\n");
+			return -1;
+		}
+		loc += value;
+		num_relocations += count;
+
+		for (; count >= 4; count -= 4, loc += 4) {
+			loc[0] += adjustment;
+			loc[1] += adjustment;
+			loc[2] += adjustment;
+			loc[3] += adjustment;
+		}
+		while (count--)
+			*loc++ += adjustment;
+	}
+
+	printk(BIOS_DEBUG, "Processed %zu relocs. Offset value of 0x%08lx\n",
+	       num_relocations, (unsigned long)adjustment);
+
+	return 0;
+}
+
 int rmodule_load_alignment(const struct rmodule *module)
 {
 	/* The load alignment is the start of the program's linked address.
@@ -194,7 +263,10 @@ int rmodule_load(void *base, struct rmodule *module)
 	 */
 	module->location = base;
 	rmodule_copy_payload(module);
-	if (rmodule_relocate(module))
+	if (module->header->version == RMODULE_VERSION_2) {
+		if (rmodule_relocate_packed(module))
+			return -1;
+	} else if (rmodule_relocate(module))
 		return -1;
 	rmodule_clear_bss(module);
 
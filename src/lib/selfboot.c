@@ -30,6 +30,7 @@
 #include <symbols.h>
 #include <cbfs.h>
 #include <lib.h>
+#include <memclear.h>
 #include <timestamp.h>
 #include <arch_ops.h>
 
@@ -483,7 +484,7 @@ static int load_self_segments(
 					(unsigned long)middle, (unsigned long)(end - middle));
 
 				/* Zero the extra bytes */
-				memset(middle, 0, end - middle);
+				memclear(middle, end - middle);
 			}
 			/* Copy the data that's outside the area that shadows ramstage */
 			printk(BIOS_DEBUG, "dest %p, end %p, bouncebuffer %lx\n", dest, end, bounce_buffer);
@@ -34,14 +34,59 @@ enum {
 	MAX77621_GPU_I2C_ADDR = 0x1C,
 };
 
-struct max77620_init_reg {
-	u8 reg;
-	u8 val;
-	u8 delay;
+/* Restored first thing, in case the kernel changed them */
+static const struct i2c_reg_write init_list[] = {
+	/* TODO */
 };
 
-static struct max77620_init_reg init_list[] = {
-	/* TODO */
+/*
+ * The writes below are grouped by register so that i2c_write_sequence() can
+ * send neighbours in one burst. Only rail voltage changes wait for the
+ * output to settle.
+ */
+static const struct i2c_reg_write max77620_rails[] = {
+	/* Set SD0 to 1.0V - VDD_CORE */
+	{ MAX77620_SD0_REG, 0x20, 500 },
+	{ MAX77620_VDVSSD0_REG, 0x20, 500 },
+	/* GPIO 0,1,2,5,6,7 = GPIO, 3,4 = alt mode */
+	{ MAX77620_AME_GPIO, 0x18, 0 },
+	/* Disable SD1 Remote Sense, Set SD1 for LPDDR4 to 1.125V */
+	{ MAX77620_CNFG2SD_REG, 0x04, 0 },
+	{ MAX77620_SD1_REG, 0x2a, 500 },
+	/*
+	 * Set LDO2 output to 1.8V. LDO2 is used as always-on reference for
+	 * the droop alert circuit. Match this setting with what the kernel
+	 * expects.
+	 */
+	{ MAX77620_CNFG1_L2_REG, 0x14, 500 },
+};
+
+static const struct i2c_reg_write max77620_fps_slots[] = {
+	/* Move RTC to slot 7 */
+	{ MAX77620_FPS_L4_REG, 0x0F, 0 },
+	/* Move SOC to slot 7 */
+	{ MAX77620_FPS_SD0_REG, 0x4F, 0 },
+	/* Move DRAM-1.1V to slot 1 */
+	{ MAX77620_FPS_SD1_REG, 0x29, 0 },
+	/* Move 1.8V to slot 3 */
+	{ MAX77620_FPS_SD3_REG, 0x1B, 0 },
+	/* Move 3.3V to slot 2 */
+	{ MAX77620_FPS_GPIO3_REG, 0x22, 0 },
+};
+
+/* The CPU rail is off until EN_VDD_CPU, so none of these need to settle */
+static const struct i2c_reg_write max77621_cpu[] = {
+	/* Set VOUT_REG to 1.0V - CPU VREG */
+	{ MAX77621_VOUT_REG, 0xBF, 0 },
+	/* Set VOUT_DVC_REG to 1.0V - CPU VREG DVC */
+	{ MAX77621_VOUT_DVC_REG, 0xBF, 0 },
+	{ MAX77621_CONTROL1_REG, 0x38, 0 },
+	{ MAX77621_CONTROL2_REG, 0xD2, 0 },
+};
+
+static const struct i2c_reg_write max77620_cpu_enable[] = {
+	/* Setup/Enable GPIO5 - EN_VDD_CPU, which requires a delay of 2msec */
+	{ MAX77620_GPIO5_REG, 0x09, 2000 },
 };
 
 static void pmic_write_reg(unsigned bus, uint8_t chip, uint8_t reg, uint8_t val,
@@ -58,9 +103,26 @@ static void pmic_write_reg(unsigned bus, uint8_t chip, uint8_t reg, uint8_t val,
 	}
 }
 
-static int pmic_read_reg(unsigned bus, uint8_t chip, uint8_t reg, uint8_t *data)
+static void pmic_write_sequence(unsigned bus, uint8_t chip,
+				const struct i2c_reg_write *seq, int count)
+{
+	if (i2c_write_sequence(bus, chip, seq, count)) {
+		printk(BIOS_ERR, "%s: chip = 0x%02X, reg = 0x%02X.. failed!\n",
+			__func__, chip, seq[0].reg);
+		/* Reset the SoC on any PMIC write error */
+		cpu_reset();
+	}
+}
+
+static int pmic_read_regs(unsigned bus, uint8_t chip, uint8_t reg,
+			  uint8_t *data, int len)
 {
-	if (i2c_readb(bus, chip, reg, data)) {
+	struct i2c_seg seg[2] = {
+		{ .read = 0, .chip = chip, .buf = &reg, .len = 1 },
+		{ .read = 1, .chip = chip, .buf = data, .len = len },
+	};
+
+	if (i2c_transfer(bus, seg, ARRAY_SIZE(seg))) {
 		printk(BIOS_ERR, "%s: reg = 0x%02X read failed\n", __func__,
 		       reg);
 		return -1;
@@ -71,7 +133,7 @@ static int pmic_read_reg(unsigned bus, uint8_t chip, uint8_t reg, uint8_t *data)
 
 static int pmic_read_reg_77620(unsigned bus, uint8_t reg, uint8_t *data)
 {
-	return pmic_read_reg(bus, MAX77620_I2C_ADDR, reg, data);
+	return pmic_read_regs(bus, MAX77620_I2C_ADDR, reg, data, 1);
 }
 
 void pmic_write_reg_77620(unsigned bus, uint8_t reg, uint8_t val,
@@ -80,107 +142,68 @@ void pmic_write_reg_77620(unsigned bus, uint8_t reg, uint8_t val,
 	pmic_write_reg(bus, MAX77620_I2C_ADDR, reg, val, delay);
 }
 
-static inline void pmic_write_reg_77621(unsigned bus, uint8_t reg, uint8_t val,
-					int delay)
+static inline void pmic_write_sequence_77620(unsigned bus,
+		const struct i2c_reg_write *seq, int count)
 {
-	pmic_write_reg(bus, MAX77621_CPU_I2C_ADDR, reg, val, delay);
+	pmic_write_sequence(bus, MAX77620_I2C_ADDR, seq, count);
 }
 
 static void pmic_slam_defaults(unsigned bus)
 {
-	int i;
-	for (i = 0; i < ARRAY_SIZE(init_list); i++) {
-		struct max77620_init_reg *reg = &init_list[i];
-		pmic_write_reg_77620(bus, reg->reg, reg->val, reg->delay);
-	}
+	pmic_write_sequence_77620(bus, init_list, ARRAY_SIZE(init_list));
 }
 
 void pmic_init(unsigned bus)
 {
+	struct i2c_reg_write tfps[2];
+	uint8_t data[ARRAY_SIZE(tfps)];
+	int i;
+
 	/* Restore PMIC POR defaults, in case kernel changed 'em */
 	pmic_slam_defaults(bus);
 
 	/* MAX77620: Set I2C watchdog timer period to 35.7 ms */
-	uint8_t data;
-	if (pmic_read_reg_77620(bus, MAX77620_CNFGGLBL2_REG, &data) != 0)
+	if (pmic_read_reg_77620(bus, MAX77620_CNFGGLBL2_REG, data) != 0)
 		printk(BIOS_ERR, "PMIC Error: Cannot set PMIC I2CTWD.\n");
 	else {
-		data &= ~MAX77620_I2CTWD_MASK;
-		data |= MAX77620_I2CTWD_35_7_MS;
-		pmic_write_reg_77620(bus, MAX77620_CNFGGLBL2_REG, data, 1);
+		data[0] &= ~MAX77620_I2CTWD_MASK;
+		data[0] |= MAX77620_I2CTWD_35_7_MS;
+		pmic_write_reg_77620(bus, MAX77620_CNFGGLBL2_REG, data[0], 1);
 	}
 
-	/* MAX77620: Set SD0 to 1.0V - VDD_CORE */
-	pmic_write_reg_77620(bus, MAX77620_SD0_REG, 0x20, 1);
-	pmic_write_reg_77620(bus, MAX77620_VDVSSD0_REG, 0x20, 1);
-
-	/* MAX77620: GPIO 0,1,2,5,6,7 = GPIO, 3,4 = alt mode */
-	pmic_write_reg_77620(bus, MAX77620_AME_GPIO, 0x18, 1);
-
-	/* MAX77620: Disable SD1 Remote Sense, Set SD1 for LPDDR4 to 1.125V */
-	pmic_write_reg_77620(bus, MAX77620_CNFG2SD_REG, 0x04, 1);
-	pmic_write_reg_77620(bus, MAX77620_SD1_REG, 0x2a, 1);
-
-	/*
-	 * MAX77620: Set LDO2 output to 1.8V. LDO2 is used as always-on
-	 * reference for the droop alert circuit. Match this setting with what
-	 * the kernel expects.
-	 */
-	pmic_write_reg_77620(bus, MAX77620_CNFG1_L2_REG, 0x14, 1);
+	/* MAX77620: SD0, SD1 and LDO2 */
+	pmic_write_sequence_77620(bus, max77620_rails,
+				  ARRAY_SIZE(max77620_rails));
 
 	/*
 	 * MAX77620: Set TFPS0 and TFPS1 to 0x7 i.e. 5.120 ms. Required to
 	 * ensure that 1.8V rails decay prior to RTC turn off in power down
-	 * sequence.
+	 * sequence. Both registers are read and written back together.
 	 */
-	if (pmic_read_reg_77620(bus, MAX77620_CNFGFPS0_REG, &data) != 0)
-		printk(BIOS_ERR, "PMIC Error: Cannot set PMIC TFPS0.\n");
-	else {
-		data &= ~MAX77620_TFPS_MASK;
-		data |= (0x7 << MAX77620_TFPS_SHIFT);
-		pmic_write_reg_77620(bus, MAX77620_CNFGFPS0_REG, data, 1);
-	}
-
-	if (pmic_read_reg_77620(bus, MAX77620_CNFGFPS1_REG, &data) != 0)
-		printk(BIOS_ERR, "PMIC Error: Cannot set PMIC TFPS1.\n");
+	if (pmic_read_regs(bus, MAX77620_I2C_ADDR, MAX77620_CNFGFPS0_REG,
+			   data, ARRAY_SIZE(data)) != 0)
+		printk(BIOS_ERR, "PMIC Error: Cannot set PMIC TFPS0/1.\n");
 	else {
-		data &= ~MAX77620_TFPS_MASK;
-		data |= (0x7 << MAX77620_TFPS_SHIFT);
-		pmic_write_reg_77620(bus, MAX77620_CNFGFPS1_REG, data, 1);
+		for (i = 0; i < ARRAY_SIZE(tfps); i++) {
+			tfps[i].reg = MAX77620_CNFGFPS0_REG + i;
+			tfps[i].val = (data[i] & ~MAX77620_TFPS_MASK) |
+				      (0x7 << MAX77620_TFPS_SHIFT);
+			tfps[i].delay_us = 0;
+		}
+		pmic_write_sequence_77620(bus, tfps, ARRAY_SIZE(tfps));
 	}
 
-	/* MAX77620: Move RTC to slot 7 */
-	pmic_write_reg_77620(bus, MAX77620_FPS_L4_REG, 0x0F, 1);
-
-	/* MAX77620: Mov SOC to slot 7 */
-	pmic_write_reg_77620(bus, MAX77620_FPS_SD0_REG, 0x4F, 1);
-
-	/* MAX77620: Move DRAM-1.1V to slot 1 */
-	pmic_write_reg_77620(bus, MAX77620_FPS_SD1_REG, 0x29, 1);
-
-	/* MAX77620: Move 1.8V to slot 3 */
-	pmic_write_reg_77620(bus, MAX77620_FPS_SD3_REG, 0x1B, 1);
-
-	/* MAX77620: Move 3.3V to slot 2 */
-	pmic_write_reg_77620(bus, MAX77620_FPS_GPIO3_REG, 0x22, 1);
-
-	/* MAX77621: Set VOUT_REG to 1.0V - CPU VREG */
-	pmic_write_reg_77621(bus, MAX77621_VOUT_REG, 0xBF, 1);
-
-	/* MAX77621: Set VOUT_DVC_REG to 1.0V - CPU VREG DVC */
-	pmic_write_reg_77621(bus, MAX77621_VOUT_DVC_REG, 0xBF, 1);
-
-	/* MAX77621: Set CONTROL1 to 0x38 */
-	pmic_write_reg_77621(bus, MAX77621_CONTROL1_REG, 0x38, 1);
-
-	/* MAX77621: Set CONTROL2 to 0xD2 */
-	pmic_write_reg_77621(bus, MAX77621_CONTROL2_REG, 0xD2, 1);
+	/* MAX77620: Flexible power sequencer slots */
+	pmic_write_sequence_77620(bus, max77620_fps_slots,
+				  ARRAY_SIZE(max77620_fps_slots));
 
-	/* MAX77620: Setup/Enable GPIO5 - EN_VDD_CPU */
-	pmic_write_reg_77620(bus, MAX77620_GPIO5_REG, 0x09, 1);
+	/* MAX77621: CPU VREG, still disabled */
+	pmic_write_sequence(bus, MAX77621_CPU_I2C_ADDR, max77621_cpu,
+			    ARRAY_SIZE(max77621_cpu));
 
-	/* Required delay of 2msec */
-	udelay(2000);
+	/* MAX77620: Turn on the CPU VREG */
+	pmic_write_sequence_77620(bus, max77620_cpu_enable,
+				  ARRAY_SIZE(max77620_cpu_enable));
 
 	printk(BIOS_DEBUG, "PMIC init done\n");
 }
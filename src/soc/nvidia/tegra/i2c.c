@@ -17,6 +17,7 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <arch/cache.h>
 #include <arch/io.h>
 #include <console/console.h>
 #include <delay.h>
@@ -24,8 +25,19 @@
 #include <stdlib.h>
 #include <string.h>
 #include <soc/addressmap.h>
+#include <soc/dma.h>
+#include <thread.h>
+#include <timer.h>
 #include "i2c.h"
 
+/* At least this many cache line aligned payload bytes go by APB DMA */
+#define I2C_DMA_MIN_BYTES	64
+/* Allow 100us per byte (100kHz) on top of the fixed timeout */
+#define I2C_DMA_TIMEOUT_US	10000
+#define I2C_DMA_BYTE_US		100
+/* Poll interval, handed to other threads if there are any */
+#define I2C_DMA_POLL_US		10
+
 static int do_bus_clear(int bus)
 {
 	struct tegra_i2c_bus_info *info = &tegra_i2c_info[bus];
@@ -70,6 +82,50 @@ static int do_bus_clear(int bus)
 	}
 }
 
+/*
+ * Check the current packet for errors. On error the controller is reset
+ * and the result is the same as for tegra_i2c_send_recv().
+ */
+static int tegra_i2c_check_status(int bus)
+{
+	int ret;
+	struct tegra_i2c_bus_info *info = &tegra_i2c_info[bus];
+	struct tegra_i2c_regs * const regs = info->base;
+	uint32_t transfer_status = read32(&regs->packet_transfer_status);
+
+	if (transfer_status & I2C_PKT_STATUS_NOACK_ADDR) {
+		printk(BIOS_ERR,
+		       "%s: The address was not acknowledged.\n",
+		       __func__);
+		info->reset_func(info->reset_bit);
+		i2c_init(bus);
+		return -1;
+	} else if (transfer_status & I2C_PKT_STATUS_NOACK_DATA) {
+		printk(BIOS_ERR,
+		       "%s: The data was not acknowledged.\n",
+		       __func__);
+		info->reset_func(info->reset_bit);
+		i2c_init(bus);
+		return -1;
+	} else if (transfer_status & I2C_PKT_STATUS_ARB_LOST) {
+		printk(BIOS_ERR,
+		       "%s: Lost arbitration.\n",
+		       __func__);
+		info->reset_func(info->reset_bit);
+
+		/* Use Tegra bus clear registers to unlock SDA */
+		ret = do_bus_clear(bus);
+
+		/* re-init i2c controller */
+		i2c_init(bus);
+
+		/* Return w/error, let caller decide what to do */
+		return ret;
+	}
+
+	return 0;
+}
+
 /*
  * return:
  *  0 = Send/recv success
@@ -124,43 +180,179 @@ static int tegra_i2c_send_recv(int bus, int read,
 			}
 		}
 
-		uint32_t transfer_status =
-			read32(&regs->packet_transfer_status);
+		ret = tegra_i2c_check_status(bus);
+		if (ret)
+			return ret;
+	}
 
-		if (transfer_status & I2C_PKT_STATUS_NOACK_ADDR) {
-			printk(BIOS_ERR,
-			       "%s: The address was not acknowledged.\n",
-			       __func__);
-			info->reset_func(info->reset_bit);
-			i2c_init(bus);
-			return -1;
-		} else if (transfer_status & I2C_PKT_STATUS_NOACK_DATA) {
-			printk(BIOS_ERR,
-			       "%s: The data was not acknowledged.\n",
-			       __func__);
-			info->reset_func(info->reset_bit);
-			i2c_init(bus);
-			return -1;
-		} else if (transfer_status & I2C_PKT_STATUS_ARB_LOST) {
-			printk(BIOS_ERR,
-			       "%s: Lost arbitration.\n",
-			       __func__);
-			info->reset_func(info->reset_bit);
+	return 0;
+}
 
-			/* Use Tegra bus clear registers to unlock SDA */
-			ret = do_bus_clear(bus);
+/*
+ * Queue the packet headers without any payload, for transfers that move
+ * the payload by other means. Same return values as tegra_i2c_send_recv().
+ */
+static int tegra_i2c_send_headers(int bus, uint32_t *headers,
+				  int header_words)
+{
+	int ret;
+	struct tegra_i2c_bus_info *info = &tegra_i2c_info[bus];
+	struct tegra_i2c_regs * const regs = info->base;
 
-			/* re-init i2c controller */
-			i2c_init(bus);
+	while (header_words) {
+		uint32_t status = read32(&regs->fifo_status);
+		int tx_empty = status & I2C_FIFO_STATUS_TX_FIFO_EMPTY_CNT_MASK;
+		tx_empty >>= I2C_FIFO_STATUS_TX_FIFO_EMPTY_CNT_SHIFT;
 
-			/* Return w/error, let caller decide what to do */
-			return ret;
+		while (header_words && tx_empty) {
+			write32(&regs->tx_packet_fifo, *headers++);
+			header_words--;
+			tx_empty--;
 		}
+
+		ret = tegra_i2c_check_status(bus);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static void tegra_i2c_dma_setup(struct tegra_i2c_bus_info *info,
+				struct apb_dma_channel *dma, int read,
+				uint8_t *data, int bytes)
+{
+	struct tegra_i2c_regs * const regs = info->base;
+	struct apb_dma_channel_regs * const dregs = dma->regs;
+
+	if (read) {
+		/* avoid data collisions */
+		dcache_clean_invalidate_by_mva(data, bytes);
+		write32(&dregs->apb_ptr, (uintptr_t)&regs->rx_fifo);
+		clrbits_le32(&dregs->csr, APB_CSR_DIR);
+	} else {
+		/* ensure bytes to send will be visible to DMA controller */
+		dcache_clean_by_mva(data, bytes);
+		write32(&dregs->apb_ptr, (uintptr_t)&regs->tx_packet_fifo);
+		setbits_le32(&dregs->csr, APB_CSR_DIR);
 	}
+	write32(&dregs->ahb_ptr, (uintptr_t)data);
+
+	/* APB bus width = 32-bits, the FIFOs are word wide */
+	clrsetbits_le32(&dregs->apb_seq,
+			APB_BUS_WIDTH_MASK << APB_BUS_WIDTH_SHIFT,
+			2 << APB_BUS_WIDTH_SHIFT);
+	/* AHB 1 word burst, to match the default FIFO trigger of 1 word */
+	clrsetbits_le32(&dregs->ahb_seq, AHB_BURST_MASK << AHB_BURST_SHIFT,
+			4 << AHB_BURST_SHIFT);
+
+	/* Transfer one block with flow control from the controller */
+	clrbits_le32(&dregs->csr, APB_CSR_REQ_SEL_MASK << APB_CSR_REQ_SEL_SHIFT);
+	setbits_le32(&dregs->csr, APB_CSR_ONCE | APB_CSR_FLOW |
+		     (info->dma_req_sel << APB_CSR_REQ_SEL_SHIFT));
+
+	/* WCOUNT counts words starting at n-1, its low 2 bits are ignored */
+	write32(&dregs->wcount, bytes - TEGRA_DMA_ALIGN_BYTES);
+}
+
+/* Enable or disable secure access for the channel, on SoCs that have it. */
+static void tegra_i2c_dma_secure(struct apb_dma_channel *dma, int enable)
+{
+#ifdef SECURITY_EN_BIT
+	struct apb_dma * const apb_dma = (struct apb_dma *)TEGRA_APB_DMA_BASE;
+
+	if (enable)
+		setbits_le32(&apb_dma->security_reg, SECURITY_EN_BIT(dma->num));
+	else
+		clrbits_le32(&apb_dma->security_reg, SECURITY_EN_BIT(dma->num));
+#endif
+}
+
+/*
+ * Wait for a DMA transfer to finish. The controller is checked for errors
+ * meanwhile, and with cooperative multitasking other threads run between
+ * the polls. Same return values as tegra_i2c_send_recv().
+ */
+static int tegra_i2c_dma_wait(int bus, struct apb_dma_channel *dma,
+			      int bytes)
+{
+	struct stopwatch sw;
+	int ret;
+
+	stopwatch_init_usecs_expire(&sw, I2C_DMA_TIMEOUT_US +
+				    bytes * I2C_DMA_BYTE_US);
 
+	while (read32(&dma->regs->dma_byte_sta) < bytes || dma_busy(dma)) {
+		ret = tegra_i2c_check_status(bus);
+		if (ret)
+			return ret;
+		if (stopwatch_expired(&sw)) {
+			printk(BIOS_ERR, "%s: DMA timed out after %d of %d "
+			       "bytes.\n", __func__,
+			       read32(&dma->regs->dma_byte_sta), bytes);
+			return -1;
+		}
+		thread_yield_microseconds(I2C_DMA_POLL_US);
+	}
 	return 0;
 }
 
+/*
+ * Same as tegra_i2c_send_recv(), but the cache line aligned middle of the
+ * payload is moved by APB DMA. Cache maintenance on it then can't touch
+ * anything else sharing a line with the buffer. The headers and the bytes
+ * before and after the middle go through the FIFO directly. The payload
+ * has to be word aligned so the FIFO words line up with the middle. Falls
+ * back to PIO if the middle is too small or no DMA channel is free.
+ */
+static int tegra_i2c_send_recv_dma(int bus, int read,
+				   uint32_t *headers, int header_words,
+				   uint8_t *data, int data_len)
+{
+	struct tegra_i2c_bus_info *info = &tegra_i2c_info[bus];
+	const unsigned int line_size = dcache_line_bytes();
+	struct apb_dma_channel *dma = NULL;
+	uintptr_t start = ALIGN_UP((uintptr_t)data, line_size);
+	uintptr_t end = ALIGN_DOWN((uintptr_t)data + data_len, line_size);
+	uint8_t *middle = (uint8_t *)start;
+	int head = start - (uintptr_t)data;
+	int bytes = end > start ? end - start : 0;
+	int ret;
+
+	if (bytes >= I2C_DMA_MIN_BYTES)
+		dma = dma_claim();
+	if (!dma)
+		return tegra_i2c_send_recv(bus, read, headers, header_words,
+					   data, data_len);
+
+	/* The payload follows the headers and the head in the FIFOs */
+	ret = tegra_i2c_send_headers(bus, headers, header_words);
+	if (!ret)
+		ret = tegra_i2c_send_recv(bus, read, NULL, 0, data, head);
+	if (ret) {
+		dma_release(dma);
+		return ret;
+	}
+
+	tegra_i2c_dma_setup(info, dma, read, middle, bytes);
+	tegra_i2c_dma_secure(dma, 1);
+	dma_start(dma);
+	ret = tegra_i2c_dma_wait(bus, dma, bytes);
+	dma_stop(dma);
+	tegra_i2c_dma_secure(dma, 0);
+	dma_release(dma);
+
+	if (ret)
+		return ret;
+
+	/* Drop lines the CPU may have fetched while the DMA was running */
+	if (read)
+		dcache_invalidate_by_mva(middle, bytes);
+
+	return tegra_i2c_send_recv(bus, read, NULL, 0, middle + bytes,
+				   data_len - head - bytes);
+}
+
 static int tegra_i2c_request(int bus, unsigned chip, int cont, int restart,
 			     int read, void *data, int data_len)
 {
@@ -189,6 +381,12 @@ static int tegra_i2c_request(int bus, unsigned chip, int cont, int restart,
 	if (cont)
 		headers[2] |= IOHEADER_I2C_REQ_CONTINUE_XFER;
 
+	if (tegra_i2c_info[bus].dma_req_sel && data_len >= I2C_DMA_MIN_BYTES &&
+	    IS_ALIGNED((uintptr_t)data, TEGRA_DMA_ALIGN_BYTES))
+		return tegra_i2c_send_recv_dma(bus, read, headers,
+					       ARRAY_SIZE(headers), data,
+					       data_len);
+
 	return tegra_i2c_send_recv(bus, read, headers, ARRAY_SIZE(headers),
 				   data, data_len);
 }
@@ -132,6 +132,8 @@ struct tegra_i2c_bus_info {
 	void *base;
 	uint32_t reset_bit;
 	void (*reset_func)(u32 bit);
+	/* APB DMA request of the controller, 0 to always use PIO */
+	int dma_req_sel;
 };
 
 extern struct tegra_i2c_bus_info tegra_i2c_info[];
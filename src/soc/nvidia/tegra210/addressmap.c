@@ -30,6 +30,7 @@
 
 static uintptr_t tz_base_mib;
 static const size_t tz_size_mib = CONFIG_TRUSTZONE_CARVEOUT_SIZE_MB;
+static uintptr_t ramstage_cache_base_mib;
 
 /* returns total amount of DRAM (in MB) from memory controller registers */
 int sdram_size_mb(void)
@@ -135,6 +136,12 @@ void carveout_range(int id, uintptr_t *base_mib, size_t *size_mib)
 					read32(&mc->security_carveout4_bom_hi),
 					region_size_mb);
 		break;
+	case CARVEOUT_RAMSTAGE_CACHE:
+		/* Software only, set up in ramstage_cache_region_init. */
+		*base_mib = ramstage_cache_base_mib;
+		if (ramstage_cache_base_mib)
+			*size_mib = RAMSTAGE_CACHE_CARVEOUT_SIZE_MB;
+		break;
 	default:
 		break;
 	}
@@ -370,3 +377,17 @@ void vpr_region_init(void)
 	/* Set the locked bit. This will lock out any other writes! */
 	write32(&mc->video_protect_reg_ctrl, MC_VPR_WR_ACCESS_DISABLE);
 }
+
+void ramstage_cache_region_init(void)
+{
+	uintptr_t end = 4096;
+
+	if (!IS_ENABLED(CONFIG_RETAINED_RAMSTAGE_CACHE) ||
+	    ramstage_cache_base_mib != 0)
+		return;
+
+	/* Get memory layout below 4GiB */
+	memory_in_range(&ramstage_cache_base_mib, &end,
+			CARVEOUT_RAMSTAGE_CACHE);
+	ramstage_cache_base_mib = end - RAMSTAGE_CACHE_CARVEOUT_SIZE_MB;
+}
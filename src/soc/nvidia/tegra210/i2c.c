@@ -19,38 +19,45 @@
 
 #include <soc/addressmap.h>
 #include <soc/clock.h>
+#include <soc/dma.h>
 #include <soc/nvidia/tegra/i2c.h>
 
 struct tegra_i2c_bus_info tegra_i2c_info[] = {
 	{
 		.base = (void *)TEGRA_I2C1_BASE,
 		.reset_bit = CLK_L_I2C1,
-		.reset_func = &clock_reset_l
+		.reset_func = &clock_reset_l,
+		.dma_req_sel = APBDMA_SLAVE_I2C
 	},
 	{
 		.base = (void *)TEGRA_I2C2_BASE,
 		.reset_bit = CLK_H_I2C2,
-		.reset_func = &clock_reset_h
+		.reset_func = &clock_reset_h,
+		.dma_req_sel = APBDMA_SLAVE_I2C2
 	},
 	{
 		.base = (void *)TEGRA_I2C3_BASE,
 		.reset_bit = CLK_U_I2C3,
-		.reset_func = &clock_reset_u
+		.reset_func = &clock_reset_u,
+		.dma_req_sel = APBDMA_SLAVE_I2C3
 	},
 	{
 		.base = (void *)TEGRA_I2C4_BASE,
 		.reset_bit = CLK_V_I2C4,
-		.reset_func = &clock_reset_v
+		.reset_func = &clock_reset_v,
+		.dma_req_sel = APBDMA_SLAVE_I2C4
 	},
 	{
 		.base = (void *)TEGRA_I2C5_BASE,
 		.reset_bit = CLK_H_I2C5,
-		.reset_func = &clock_reset_h
+		.reset_func = &clock_reset_h,
+		.dma_req_sel = APBDMA_SLAVE_DVC_I2C
 	},
 	{
 		.base = (void *)TEGRA_I2C6_BASE,
 		.reset_bit = CLK_X_I2C6,
-		.reset_func = &clock_reset_x
+		.reset_func = &clock_reset_x,
+		.dma_req_sel = APBDMA_SLAVE_I2C6
 	}
 };
 
@@ -108,6 +108,7 @@ enum {
 #define NVDEC_CARVEOUT_SIZE_MB		1
 #define TSEC_CARVEOUT_SIZE_MB		2
 #define VPR_CARVEOUT_SIZE_MB		128
+#define RAMSTAGE_CACHE_CARVEOUT_SIZE_MB	1
 
 /* Return total size of DRAM memory configured on the platform. */
 int sdram_size_mb(void);
@@ -124,6 +125,7 @@ enum {
 	CARVEOUT_GPU,
 	CARVEOUT_NVDEC,
 	CARVEOUT_TSEC,
+	CARVEOUT_RAMSTAGE_CACHE,
 	CARVEOUT_NUM,
 };
 
@@ -150,5 +152,11 @@ void gpu_region_init(void);
 void nvdec_region_init(void);
 void tsec_region_init(void);
 void vpr_region_init(void);
+/*
+ * The ramstage cache region is not protected by the memory controller. It
+ * only keeps the OS away from it and is placed below all other carveouts,
+ * so call it after them in both romstage and ramstage.
+ */
+void ramstage_cache_region_init(void);
 
 #endif /* __SOC_NVIDIA_TEGRA210_INCLUDE_SOC_ADDRESS_MAP_H__ */
@@ -0,0 +1,76 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef __SOC_NVIDIA_TEGRA210_SOC_LP0_RESUME_TIMES_H__
+#define __SOC_NVIDIA_TEGRA210_SOC_LP0_RESUME_TIMES_H__
+
+#include <stdint.h>
+
+/*
+ * Timestamps taken by the LP0 resume blob (lp0/tegra_lp0_resume.c).
+ *
+ * The blob writes TIMERUS (microseconds) at the end of each step of the
+ * resume into a table at a fixed IRAM address, right below the blob's
+ * header. Nothing clears it afterwards, so code that runs after resume
+ * can read it until something else reuses that IRAM. At cold boot the
+ * bootblock occupies the same range, which is why a reader has to check
+ * the magic and the checksum. The checksum is written last, so a table
+ * that passes is complete and from a single resume.
+ *
+ * The stamps are raw TIMERUS values and wrap every 71 minutes. Only the
+ * differences between them mean anything.
+ */
+
+#define LP0_RESUME_TIMES_ADDR	0x4001FD80
+#define LP0_RESUME_TIMES_MAGIC	0x4c503054	/* "LP0T" */
+
+enum {
+	LP0_TIME_ENTRY,		/* blob entered */
+	LP0_TIME_CLOCKS_PADS,	/* oscillator, clocks and pads set up */
+	LP0_TIME_CPU_RAIL,	/* CPU rail on and settled */
+	LP0_TIME_CPU_CLAMP,	/* CPU partition clamp removed */
+	LP0_TIME_CPU_RESET,	/* about to release the CPU from reset */
+	LP0_TIME_NUM
+};
+
+struct lp0_resume_times {
+	uint32_t magic;
+	uint32_t stamp[LP0_TIME_NUM];
+	uint32_t checksum;	/* ~(magic + sum of the stamps) */
+};
+
+static inline uint32_t lp0_resume_times_checksum(
+	const struct lp0_resume_times *times)
+{
+	uint32_t sum = times->magic;
+	int i;
+
+	for (i = 0; i < LP0_TIME_NUM; i++)
+		sum += times->stamp[i];
+	return ~sum;
+}
+
+/* Returns 1 if the table holds a complete set of stamps, 0 otherwise. */
+static inline int lp0_resume_times_valid(const struct lp0_resume_times *times)
+{
+	return times->magic == LP0_RESUME_TIMES_MAGIC &&
+	       times->checksum == lp0_resume_times_checksum(times);
+}
+
+#endif /* __SOC_NVIDIA_TEGRA210_SOC_LP0_RESUME_TIMES_H__ */
@@ -21,12 +21,30 @@
 #define __SOC_NVIDIA_TEGRA210_MTC_H__
 
 #include <boot/coreboot_tables.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #if CONFIG_HAVE_MTC
 
 int tegra210_run_mtc(void);
 void soc_add_mtc(struct lb_header *header);
 
+#if CONFIG_MTC_CACHE
+uint32_t mtc_cache_hash(const void *data, size_t size);
+size_t mtc_cache_restore(uint32_t mtc_hash, size_t max_size);
+void mtc_cache_save(uint32_t mtc_hash, size_t table_size);
+#else
+static inline uint32_t mtc_cache_hash(const void *data, size_t size)
+{
+	return 0;
+}
+static inline size_t mtc_cache_restore(uint32_t mtc_hash, size_t max_size)
+{
+	return 0;
+}
+static inline void mtc_cache_save(uint32_t mtc_hash, size_t table_size) {}
+#endif
+
 #else
 
 static inline int tegra210_run_mtc(void) { return 0; }
@@ -15,6 +15,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <soc/lp0_resume_times.h>
 #include <stdint.h>
 
 /* Function unit addresses. */
@@ -460,13 +461,35 @@ static void __attribute__((noreturn)) reset(void)
 	halt();
 }
 
-static void udelay(unsigned usecs)
+static void udelay_since(uint32_t start, unsigned usecs)
 {
-	uint32_t start = read32(timer_us_ptr);
 	while (read32(timer_us_ptr) - start < usecs)
 		;
 }
 
+static void udelay(unsigned usecs)
+{
+	udelay_since(read32(timer_us_ptr), usecs);
+}
+
+/* Resume timing. */
+
+/* The table and its layout are described in soc/lp0_resume_times.h. */
+static struct lp0_resume_times *const lp0_resume_times =
+	(void *)LP0_RESUME_TIMES_ADDR;
+
+static void mark_time(int step)
+{
+	lp0_resume_times->stamp[step] = read32(timer_us_ptr);
+}
+
+static void seal_times(void)
+{
+	lp0_resume_times->magic = LP0_RESUME_TIMES_MAGIC;
+	lp0_resume_times->checksum =
+		lp0_resume_times_checksum(lp0_resume_times);
+}
+
 /* UART related defines */
 static uint32_t *uart_clk_out_enb_regs[4] = {
 	(uint32_t *)0x60006010,
@@ -911,11 +934,14 @@ static void i2c_send(uint32_t addr, uint32_t data)
 void lp0_resume(void)
 {
 	uint32_t orig_timer;
+	uint32_t rail_on;
 
 	/* If not on the AVP, reset. */
 	if (read32(up_tag_ptr) != UP_TAG_AVP)
 		reset();
 
+	mark_time(LP0_TIME_ENTRY);
+
 	/* Enable JTAG */
 	enable_jtag();
 
@@ -947,6 +973,8 @@ void lp0_resume(void)
 	/* Configure unused SDMMC1/3 pads for low power leakage */
 	low_power_sdmmc_pads();
 
+	mark_time(LP0_TIME_CLOCKS_PADS);
+
 	/*
 	 * Find out which CPU (slow or fast) to wake up. The default setting
 	 * in flow controller is to wake up GCPU
@@ -977,28 +1005,10 @@ void lp0_resume(void)
 	/* Set CAR2PMC_CPU_ACK_WIDTH to 0 */
 	clrbits32(CAR2PMC_CPU_ACK_WIDTH_MASK, clk_rst_cpu_softrst_ctrl2_ptr);
 
-	/* Clear PMC_SCRATCH190 */
-	clrbits32(1, pmc_scratch190_ptr);
-
 	/* Clear PMC_DPD_SAMPLE */
 	write32(pmc_dpd_sample_ptr, 0);
 	udelay(10);
 
-	/* Clear the MC_INTSTATUS if MC_INTMASK was 0. */
-	if (!read32(mc_intmask_ptr)) {
-		uint32_t mc_intst_val = read32(mc_intstatus_ptr);
-		if (mc_intst_val)
-			write32(mc_intstatus_ptr, mc_intst_val);
-	}
-
-	/*
-	 * Set both _ACCESS bits so that kernel/secure code
-	 * can reconfig VPR careveout as needed from the TrustZone.
-	 */
-	write32(mc_video_protect_size_mb_ptr, 0);
-	write32(mc_video_protect_reg_ctrl_ptr,
-		VPR_WR_ACCESS_DISABLE | VPR_ALLOW_TZ_WR_ACCESS);
-
 	/* Tristate CLDVFS PWM */
 	write32(pinmux_dvfs_pwm_ptr, (TRISTATE | PM_CLDVFS));
 
@@ -1036,9 +1046,35 @@ void lp0_resume(void)
 	/* Disable PWR I2C */
 	write32(clk_rst_rst_dev_h_set_ptr, I2C5_RST);
 	write32(clk_rst_clk_enb_h_clr_ptr, CLK_ENB_I2C5);
+	rail_on = read32(timer_us_ptr);
+
+	/*
+	 * The steps up to the delay don't involve the CPU rail, so they are
+	 * done while it ramps up.
+	 */
+
+	/* Clear PMC_SCRATCH190 */
+	clrbits32(1, pmc_scratch190_ptr);
+
+	/* Clear the MC_INTSTATUS if MC_INTMASK was 0. */
+	if (!read32(mc_intmask_ptr)) {
+		uint32_t mc_intst_val = read32(mc_intstatus_ptr);
+		if (mc_intst_val)
+			write32(mc_intstatus_ptr, mc_intst_val);
+	}
+
+	/*
+	 * Set both _ACCESS bits so that kernel/secure code
+	 * can reconfig VPR careveout as needed from the TrustZone.
+	 */
+	write32(mc_video_protect_size_mb_ptr, 0);
+	write32(mc_video_protect_reg_ctrl_ptr,
+		VPR_WR_ACCESS_DISABLE | VPR_ALLOW_TZ_WR_ACCESS);
 
-	/* Delay before removing clamp */
-	udelay(2000);
+	/* Delay before removing clamp, including the steps above */
+	udelay_since(rail_on, 2000);
+
+	mark_time(LP0_TIME_CPU_RAIL);
 
 	/*
 	 * Reprogram PMC_CPUPWRGOOD_TIMER register:
@@ -1067,6 +1103,8 @@ void lp0_resume(void)
 	while (read32(pmc_clamp_status_ptr) & (1 << PARTID_CRAIL))
 		;
 
+	mark_time(LP0_TIME_CPU_CLAMP);
+
 	/* Disable CLDVFS clock */
 	write32(clk_rst_clk_enb_w_clr_ptr, CLK_ENB_DVFS);
 
@@ -1094,6 +1132,9 @@ void lp0_resume(void)
 	/* Restore the original PMC_CPUPWRGOOD_TIMER. */
 	write32(pmc_cpupwrgood_timer_ptr, orig_timer);
 
+	mark_time(LP0_TIME_CPU_RESET);
+	seal_times();
+
 	/* Clear software controlled reset */
 	write32(clk_rst_cpug_cmplx_clr_ptr, (CLR_CPURESET0 | CLR_CORERESET0));
 
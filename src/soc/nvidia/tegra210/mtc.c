@@ -58,6 +58,7 @@ int tegra210_run_mtc(void)
 
 	size_t mtc_size = 0;
 	ssize_t mtc_offset = 0;
+	uint32_t mtc_hash;
 	const char *mtc_filename = CONFIG_CBFS_PREFIX"/tegra_mtc";
 
 	if (IS_ENABLED(CONFIG_VBOOT2_VERIFY_FIRMWARE)) {
@@ -92,6 +93,12 @@ int tegra210_run_mtc(void)
 	printk(BIOS_INFO, "MTC: %zu bytes loaded from offset %p @ %p\n", nread,
 	       (void *)mtc_offset, mtc);
 
+	/* Training results only change with the DRAM part or firmware. */
+	mtc_hash = mtc_cache_hash(mtc, mtc_size);
+	mtc_table_size = mtc_cache_restore(mtc_hash, MTC_TABLE_MAX_SIZE);
+	if (mtc_table_size)
+		return 0;
+
 	mtc_table_size = (*mtc_fw)(&dvfs_table);
 
 	if ((mtc_table_size == 0) || (mtc_table_size > MTC_TABLE_MAX_SIZE)) {
@@ -112,6 +119,8 @@ int tegra210_run_mtc(void)
 	printk(BIOS_INFO, "MTC: Copied 0x%zx bytes from %p to %p\n",
 	       mtc_table_size, dvfs_table, cbmem_tab);
 
+	mtc_cache_save(mtc_hash, mtc_table_size);
+
 	return 0;
 }
 
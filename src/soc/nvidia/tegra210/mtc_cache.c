@@ -0,0 +1,199 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Cache of the DVFS table produced by MTC training, kept in the
+ * RW_MTC_CACHE flash region. The table only depends on the DRAM part
+ * and on the MTC firmware, so as long as both match the cached copy
+ * can be used instead of training again.
+ */
+
+#include <bootstate.h>
+#include <cbfs.h>
+#include <cbmem.h>
+#include <console/console.h>
+#include <fmap.h>
+#include <ip_checksum.h>
+#include <soc/mtc.h>
+#include <soc/sdram.h>
+#include <spi_flash.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MTC_CACHE_SIGNATURE	0x4d544343	/* 'MTCC' */
+#define MTC_CACHE_REGION	"RW_MTC_CACHE"
+
+struct mtc_cache_header {
+	uint32_t signature;
+	uint32_t ram_code;
+	uint32_t mtc_hash;	/* of the firmware the table was trained by */
+	uint32_t table_size;
+	uint32_t checksum;	/* compute_ip_checksum() of the table */
+} __attribute__((packed));
+
+/* Set if the cache has to be written back to flash. */
+static struct mtc_cache_header pending;
+
+/* FNV-1a, only used to notice MTC firmware updates. */
+uint32_t mtc_cache_hash(const void *data, size_t size)
+{
+	const uint8_t *p = data;
+	uint32_t hash = 2166136261u;
+
+	while (size--)
+		hash = (hash ^ *p++) * 16777619;
+	return hash;
+}
+
+static int mtc_cache_region(uintptr_t *offset)
+{
+	void *region;
+	const int size = find_fmap_entry(MTC_CACHE_REGION, &region);
+
+	if (size <= 0) {
+		printk(BIOS_DEBUG, "MTC: no %s region\n", MTC_CACHE_REGION);
+		return -1;
+	}
+	/* Callers subtract the header size from the region size. */
+	if (size < sizeof(struct mtc_cache_header)) {
+		printk(BIOS_ERR, "MTC: %s is too small\n", MTC_CACHE_REGION);
+		return -1;
+	}
+	*offset = (uintptr_t)region;
+	return size;
+}
+
+/*
+ * Copy a cached table for the given firmware to CBMEM_ID_MTC.
+ * Returns the table size, or 0 if there is no matching table.
+ */
+size_t mtc_cache_restore(uint32_t mtc_hash, size_t max_size)
+{
+	struct mtc_cache_header header;
+	const struct cbmem_entry *entry;
+	struct cbfs_media media;
+	uintptr_t offset;
+	size_t nread;
+	void *table;
+	int size;
+
+	size = mtc_cache_region(&offset);
+	if (size < 0)
+		return 0;
+
+	if (init_default_cbfs_media(&media)) {
+		printk(BIOS_ERR, "MTC: failed to init default cbfs media\n");
+		return 0;
+	}
+
+	media.open(&media);
+	nread = media.read(&media, &header, offset, sizeof(header));
+	if (nread != sizeof(header) ||
+	    header.signature != MTC_CACHE_SIGNATURE ||
+	    header.ram_code != sdram_get_ram_code() ||
+	    header.mtc_hash != mtc_hash ||
+	    header.table_size == 0 || header.table_size > max_size ||
+	    header.table_size > size - sizeof(header)) {
+		printk(BIOS_INFO, "MTC: no matching cached training data\n");
+		media.close(&media);
+		return 0;
+	}
+
+	entry = cbmem_entry_add(CBMEM_ID_MTC, header.table_size);
+	if (entry == NULL) {
+		media.close(&media);
+		return 0;
+	}
+	table = cbmem_entry_start(entry);
+	nread = media.read(&media, table, offset + sizeof(header),
+			   header.table_size);
+	media.close(&media);
+
+	if (nread != header.table_size ||
+	    compute_ip_checksum(table, header.table_size) != header.checksum) {
+		printk(BIOS_ERR, "MTC: cached training data is corrupt\n");
+		cbmem_entry_remove(entry);
+		return 0;
+	}
+
+	printk(BIOS_INFO, "MTC: using cached training data (0x%x bytes)\n",
+	       header.table_size);
+	return header.table_size;
+}
+
+/* Schedule writing the table in CBMEM_ID_MTC back to flash. */
+void mtc_cache_save(uint32_t mtc_hash, size_t table_size)
+{
+	void *table = cbmem_find(CBMEM_ID_MTC);
+
+	if (table == NULL)
+		return;
+
+	pending.signature = MTC_CACHE_SIGNATURE;
+	pending.ram_code = sdram_get_ram_code();
+	pending.mtc_hash = mtc_hash;
+	pending.table_size = table_size;
+	pending.checksum = compute_ip_checksum(table, table_size);
+}
+
+static void update_mtc_cache(void *unused)
+{
+	struct spi_flash *flash;
+	uintptr_t offset;
+	size_t erase_size;
+	void *table;
+	int size;
+
+	if (pending.signature != MTC_CACHE_SIGNATURE)
+		return;
+
+	table = cbmem_find(CBMEM_ID_MTC);
+	size = mtc_cache_region(&offset);
+	if (table == NULL || size < 0)
+		return;
+	if (pending.table_size > size - sizeof(pending)) {
+		printk(BIOS_ERR, "MTC: table doesn't fit into %s\n",
+		       MTC_CACHE_REGION);
+		return;
+	}
+
+	flash = spi_flash_probe(CONFIG_BOOT_MEDIA_SPI_BUS, 0);
+	if (flash == NULL) {
+		printk(BIOS_ERR, "MTC: failed to probe spi flash\n");
+		return;
+	}
+
+	erase_size = ALIGN_UP(sizeof(pending) + pending.table_size,
+			      flash->sector_size);
+	if (erase_size > size)
+		erase_size = size;
+
+	printk(BIOS_DEBUG, "MTC: updating cached training data\n");
+	/* Write the header last, so an interrupted update is never used. */
+	if (flash->erase(flash, offset, erase_size) ||
+	    flash->write(flash, offset + sizeof(pending), pending.table_size,
+			 table) ||
+	    flash->write(flash, offset, sizeof(pending), &pending))
+		printk(BIOS_ERR, "MTC: failed to update cached data\n");
+}
+
+BOOT_STATE_INIT_ENTRIES(mtc_cache_update) = {
+	BOOT_STATE_INIT_ENTRY(BS_WRITE_TABLES, BS_ON_ENTRY,
+			      update_mtc_cache, NULL),
+};
@@ -56,6 +56,7 @@ void arm64_soc_init(void)
 	mselect_enable_wrap();
 
 	trustzone_region_init();
+	ramstage_cache_region_init();
 
 	tegra210_mmu_init();
 }
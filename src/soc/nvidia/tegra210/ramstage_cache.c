@@ -0,0 +1,69 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <arch/io.h>
+#include <ramstage_cache.h>
+#include <soc/addressmap.h>
+#include <soc/pmc.h>
+#include <stdlib.h>
+#include <symbols.h>
+
+static struct tegra_pmc_regs * const pmc = (void *)TEGRA_PMC_BASE;
+
+/*
+ * The digest is kept in PMC scratch registers not used by the boot ROM or
+ * the LP0 resume code. They keep their value across warm resets and read
+ * as zero after power-on reset, which no saved digest can match.
+ */
+#define DIGEST_MAGIC	0x52534331	/* "RSC1" */
+
+struct ramstage_cache *ramstage_cache_location(long *size)
+{
+	uintptr_t base_mib;
+	size_t size_mib;
+
+	carveout_range(CARVEOUT_RAMSTAGE_CACHE, &base_mib, &size_mib);
+	*size = size_mib * MiB;
+	if (size_mib == 0)
+		return NULL;
+
+	return (void *)(base_mib * MiB);
+}
+
+int ramstage_cache_load_digest(struct ramstage_cache_digest *digest)
+{
+	if (read32(&pmc->scratch250) != DIGEST_MAGIC)
+		return -1;
+
+	digest->source = (uint64_t)read32(&pmc->scratch252) << 32 |
+			 read32(&pmc->scratch251);
+	digest->image = (uint64_t)read32(&pmc->scratch254) << 32 |
+			read32(&pmc->scratch253);
+	return 0;
+}
+
+void ramstage_cache_save_digest(const struct ramstage_cache_digest *digest)
+{
+	/* An all zero digest only invalidates the saved one. */
+	write32(&pmc->scratch250, 0);
+	if (!digest->source && !digest->image)
+		return;
+
+	write32(&pmc->scratch251, digest->source);
+	write32(&pmc->scratch252, digest->source >> 32);
+	write32(&pmc->scratch253, digest->image);
+	write32(&pmc->scratch254, digest->image >> 32);
+	write32(&pmc->scratch250, DIGEST_MAGIC);
+}
@@ -110,6 +110,7 @@ void romstage(void)
 	nvdec_region_init();
 	tsec_region_init();
 	vpr_region_init();
+	ramstage_cache_region_init();
 
 	/*
 	 * When romstage is running it's always on the reboot path -- never a
@@ -19,8 +19,6 @@
 /* Currently we only support Google VPD 2.0, which has a fixed offset. */
 enum {
 	GOOGLE_VPD_2_0_OFFSET = 0x600,
-	CROSVPD_CBMEM_MAGIC = 0x43524f53,
-	CROSVPD_CBMEM_VERSION = 0x0001,
 };
 
 struct vpd_gets_arg {
@@ -30,17 +28,6 @@ struct vpd_gets_arg {
 	int matched;
 };
 
-struct vpd_cbmem {
-	uint32_t magic;
-	uint32_t version;
-	uint32_t ro_size;
-	uint32_t rw_size;
-	uint8_t blob[0];
-	/* The blob contains both RO and RW data. It starts with RO (0 ..
-	 * ro_size) and then RW (ro_size .. ro_size+rw_size).
-	 */
-};
-
 /* Finds the the VPD blob from CBFS media. */
 static int cros_vpd_find_blob(struct cbfs_media *media,
 			      const struct fmap_area *area,
@@ -73,6 +60,90 @@ static int cros_vpd_find_blob(struct cbfs_media *media,
 	return 0;
 }
 
+static uint32_t vpd_key_hash(const uint8_t *key, int32_t key_len)
+{
+	uint32_t hash = CROSVPD_INDEX_HASH_INIT;
+
+	while (key_len--) {
+		hash ^= *key++;
+		hash *= CROSVPD_INDEX_HASH_PRIME;
+	}
+	return hash;
+}
+
+static int vpd_index_before(const struct vpd_index_entry *a,
+			    const struct vpd_index_entry *b)
+{
+	if (a->hash != b->hash)
+		return a->hash < b->hash;
+	return a->key < b->key;
+}
+
+struct vpd_index_arg {
+	const uint8_t *blob;
+	struct vpd_index *index;
+};
+
+static int vpd_index_callback(const uint8_t *key, int32_t key_len,
+			      const uint8_t *value, int32_t value_len,
+			      void *arg)
+{
+	struct vpd_index_arg *ia = arg;
+	struct vpd_index_entry *e;
+
+	/* The first pass only counts the strings. */
+	if (!ia->index->magic) {
+		ia->index->count++;
+		return VPD_OK;
+	}
+
+	e = &ia->index->entries[ia->index->count++];
+	e->hash = vpd_key_hash(key, key_len);
+	e->key = key - ia->blob;
+	e->value = value - ia->blob;
+	e->key_len = key_len;
+	e->value_len = value_len;
+
+	/* Insertion sort, VPDs only hold a few dozen strings. */
+	for (; e > ia->index->entries && vpd_index_before(e, e - 1); e--) {
+		struct vpd_index_entry tmp = *e;
+
+		*e = e[-1];
+		e[-1] = tmp;
+	}
+	return VPD_OK;
+}
+
+/* Indexes the RO VPD strings so cros_vpd_find() does not walk the blob. */
+static void cbmem_add_cros_vpd_index(const struct vpd_cbmem *vpd)
+{
+	struct vpd_index count = { 0 };
+	struct vpd_index_arg arg = { .blob = vpd->blob, .index = &count };
+	int consumed = 0;
+
+	if (!vpd->ro_size)
+		return;
+
+	while (VPD_OK == decodeVpdString(vpd->ro_size, vpd->blob, &consumed,
+					 vpd_index_callback, &arg))
+		;
+
+	arg.index = cbmem_add(CBMEM_ID_VPD_INDEX, sizeof(*arg.index) +
+			      count.count * sizeof(arg.index->entries[0]));
+	if (!arg.index) {
+		printk(BIOS_ERR, "%s: Failed to allocate CBMEM for %u keys.\n",
+		       __func__, count.count);
+		return;
+	}
+
+	arg.index->magic = CROSVPD_INDEX_MAGIC;
+	arg.index->count = 0;
+	consumed = 0;
+	while (VPD_OK == decodeVpdString(vpd->ro_size, vpd->blob, &consumed,
+					 vpd_index_callback, &arg))
+		;
+}
+
 /* Loads VPD blob from CBFS media and save into CBMEM. */
 static void cbmem_add_cros_vpd(void)
 {
@@ -114,6 +185,8 @@ static void cbmem_add_cros_vpd(void)
 		printk(BIOS_INFO, "%s: RO (%#zx+%#zx), RW (%#zx+%#zx).\n",
 		       __func__, ro_base, ro_size, rw_base, rw_size);
 
+		cbmem_add_cros_vpd_index(vpd);
+
 	} else {
 		printk(BIOS_ERR, "%s: Failed to allocate CBMEM (%zu+%zu).\n",
 		       __func__, ro_size, rw_size);
@@ -138,11 +211,41 @@ static int vpd_gets_callback(const uint8_t *key, int32_t key_len,
 	return VPD_FAIL;
 }
 
+/* Binary search for the first entry with the key's hash, then compare. */
+static int vpd_index_find(const struct vpd_index *index, const uint8_t *blob,
+			  struct vpd_gets_arg *arg)
+{
+	const uint32_t hash = vpd_key_hash(arg->key, arg->key_len);
+	uint32_t lo = 0, hi = index->count, mid;
+	const struct vpd_index_entry *e;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (index->entries[mid].hash < hash)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (e = &index->entries[lo];
+	     e < &index->entries[index->count] && e->hash == hash; e++) {
+		if (e->key_len != arg->key_len ||
+		    memcmp(blob + e->key, arg->key, e->key_len) != 0)
+			continue;
+		arg->matched = 1;
+		arg->value = blob + e->value;
+		arg->value_len = e->value_len;
+		break;
+	}
+	return arg->matched;
+}
+
 const void *cros_vpd_find(const char *key, int *size)
 {
 	struct vpd_gets_arg arg = {0};
 	int consumed = 0;
 	const struct vpd_cbmem *vpd;
+	const struct vpd_index *index;
 
 	vpd = cbmem_find(CBMEM_ID_VPD);
 	if (!vpd || !vpd->ro_size)
@@ -151,6 +254,14 @@ const void *cros_vpd_find(const char *key, int *size)
 	arg.key = (const uint8_t *)key;
 	arg.key_len = strlen(key);
 
+	index = cbmem_find(CBMEM_ID_VPD_INDEX);
+	if (index && index->magic == CROSVPD_INDEX_MAGIC) {
+		if (!vpd_index_find(index, vpd->blob, &arg))
+			return NULL;
+		*size = arg.value_len;
+		return arg.value;
+	}
+
 	/* This API currently only supports reading RO VPD. */
 	while (VPD_OK == decodeVpdString(vpd->ro_size, vpd->blob, &consumed,
 					 vpd_gets_callback, &arg)) {
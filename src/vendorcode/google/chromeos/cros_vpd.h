@@ -7,6 +7,52 @@
 #ifndef __CROS_VPD_H__
 #define __CROS_VPD_H__
 
+#include <stdint.h>
+
+/*
+ * The VPD in CBMEM. Payloads find these entries through LB_TAG_VPD and
+ * LB_TAG_VPD_INDEX, libpayload keeps a copy of the layouts in vpd.h.
+ */
+enum {
+	CROSVPD_CBMEM_MAGIC = 0x43524f53,
+	CROSVPD_CBMEM_VERSION = 0x0001,
+	CROSVPD_INDEX_MAGIC = 0x56504449,
+};
+
+/* The index hashes keys with 32-bit FNV-1a. */
+#define CROSVPD_INDEX_HASH_INIT		2166136261u
+#define CROSVPD_INDEX_HASH_PRIME	16777619u
+
+struct vpd_cbmem {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t ro_size;
+	uint32_t rw_size;
+	uint8_t blob[0];
+	/* The blob contains both RO and RW data. It starts with RO (0 ..
+	 * ro_size) and then RW (ro_size .. ro_size+rw_size).
+	 */
+};
+
+/*
+ * Index of the RO VPD strings, in its own CBMEM entry. The entries are
+ * sorted by key hash and, for equal hashes, by position in the blob, so the
+ * first match of a lookup is the string a walk of the blob would find.
+ */
+struct vpd_index_entry {
+	uint32_t hash;		/* FNV-1a of the key */
+	uint32_t key;		/* offsets into the blob */
+	uint32_t value;
+	uint32_t key_len;
+	uint32_t value_len;
+};
+
+struct vpd_index {
+	uint32_t magic;
+	uint32_t count;
+	struct vpd_index_entry entries[0];
+};
+
 /*
  * Reads VPD string value by key.
  *
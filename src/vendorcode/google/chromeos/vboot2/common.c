@@ -52,7 +52,10 @@ void *vboot_load_stage(int stage_index,
 	/* we're making cbfs access offset outside of the region managed by
 	 * cbfs. this works because cbfs_load_stage_by_offset does not check
 	 * the offset. */
-	entry = cbfs_load_stage_by_offset(media, fc_addr);
+	if (stage_index == CONFIG_VBOOT_RAMSTAGE_INDEX)
+		entry = cbfs_load_ramstage_by_offset(media, fc_addr);
+	else
+		entry = cbfs_load_stage_by_offset(media, fc_addr);
 	if (entry == (void *)-1)
 		entry = NULL;
 	return entry;
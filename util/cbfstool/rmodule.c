@@ -345,6 +345,57 @@ static int collect_relocations(struct rmod_context *ctx)
 	return 0;
 }
 
+static size_t put_value(struct buffer *out, uint64_t val)
+{
+	size_t len = 0;
+
+	do {
+		uint8_t byte = val & 0x7f;
+
+		val >>= 7;
+		if (val)
+			byte |= 0x80;
+		if (out != NULL)
+			xdr_le.put8(out, byte);
+		len++;
+	} while (val);
+
+	return len;
+}
+
+ssize_t rmodule_pack_relocs(struct buffer *out, const Elf64_Addr *relocs,
+                            size_t nrelocs, Elf64_Addr link_addr,
+                            size_t ptr_size)
+{
+	Elf64_Addr cursor = link_addr;
+	size_t len = 0;
+	size_t i, count;
+
+	for (i = 0; i < nrelocs; i += count) {
+		uint64_t skip;
+
+		/* Duplicates and unaligned pointers need version 1. */
+		if (relocs[i] < cursor || (relocs[i] - link_addr) % ptr_size)
+			return -1;
+
+		count = 1;
+		while (i + count < nrelocs &&
+		       relocs[i + count] == relocs[i] + count * ptr_size)
+			count++;
+
+		skip = (relocs[i] - cursor) / ptr_size;
+		if (count == 1) {
+			len += put_value(out, skip << 1);
+		} else {
+			len += put_value(out, skip << 1 | 1);
+			len += put_value(out, count - 2);
+		}
+		cursor = relocs[i] + count * ptr_size;
+	}
+
+	return len;
+}
+
 static int
 populate_sym(struct rmod_context *ctx, const char *sym_name, Elf64_Addr *addr,
              int nsyms, const char *strtab)
@@ -464,7 +515,10 @@ write_elf(const struct rmod_context *ctx, const struct buffer *in,
 {
 	int ret;
 	int bit64;
+	int version;
 	size_t loc;
+	size_t ptr_size;
+	ssize_t relocs_size;
 	size_t rmod_data_size;
 	struct elf_writer *ew;
 	struct buffer rmod_data;
@@ -488,12 +542,21 @@ write_elf(const struct rmod_context *ctx, const struct buffer *in,
 	 * +------------------+
 	 */
 
+	/* Pack the relocations unless they cannot be expressed that way. */
+	ptr_size = bit64 ? sizeof(Elf64_Addr) : sizeof(Elf32_Addr);
+	version = RMODULE_VERSION_2;
+	relocs_size = rmodule_pack_relocs(NULL, ctx->emitted_relocs,
+					  ctx->nrelocs, ctx->link_addr,
+					  ptr_size);
+	if (relocs_size < 0) {
+		INFO("Relocations cannot be packed, using version 1.\n");
+		version = RMODULE_VERSION_1;
+		relocs_size = ctx->nrelocs * ptr_size;
+	}
+	INFO("%zd bytes of relocations.\n", relocs_size);
+
 	/* Create buffer for header and relocations. */
-	rmod_data_size = sizeof(struct rmodule_header);
-	if (bit64)
-		rmod_data_size += ctx->nrelocs * sizeof(Elf64_Addr);
-	else
-		rmod_data_size += ctx->nrelocs * sizeof(Elf32_Addr);
+	rmod_data_size = sizeof(struct rmodule_header) + relocs_size;
 
 	if (buffer_create(&rmod_data, rmod_data_size, "rmod"))
 		return -1;
@@ -523,7 +586,7 @@ write_elf(const struct rmod_context *ctx, const struct buffer *in,
 
 	/* Write out rmodule_header. */
 	ctx->xdr->put16(&rmod_header, RMODULE_MAGIC);
-	ctx->xdr->put8(&rmod_header, RMODULE_VERSION_1);
+	ctx->xdr->put8(&rmod_header, version);
 	ctx->xdr->put8(&rmod_header, 0);
 	/* payload_begin_offset */
 	loc = sizeof(struct rmodule_header);
@@ -534,10 +597,7 @@ write_elf(const struct rmod_context *ctx, const struct buffer *in,
 	/* relocations_begin_offset */
 	ctx->xdr->put32(&rmod_header, loc);
 	/* relocations_end_offset */
-	if (bit64)
-		loc += ctx->nrelocs * sizeof(Elf64_Addr);
-	else
-		loc += ctx->nrelocs * sizeof(Elf32_Addr);
+	loc += relocs_size;
 	ctx->xdr->put32(&rmod_header, loc);
 	/* module_link_start_address */
 	ctx->xdr->put32(&rmod_header, ctx->link_addr);
@@ -560,11 +620,18 @@ write_elf(const struct rmod_context *ctx, const struct buffer *in,
 	ctx->xdr->put32(&rmod_header, 0);
 
 	/* Write the relocations. */
-	for (unsigned i = 0; i < ctx->nrelocs; i++) {
-		if (bit64)
-			ctx->xdr->put64(&relocs, ctx->emitted_relocs[i]);
-		else
-			ctx->xdr->put32(&relocs, ctx->emitted_relocs[i]);
+	if (version == RMODULE_VERSION_2) {
+		rmodule_pack_relocs(&relocs, ctx->emitted_relocs,
+				    ctx->nrelocs, ctx->link_addr, ptr_size);
+	} else {
+		for (unsigned i = 0; i < ctx->nrelocs; i++) {
+			if (bit64)
+				ctx->xdr->put64(&relocs,
+						ctx->emitted_relocs[i]);
+			else
+				ctx->xdr->put32(&relocs,
+						ctx->emitted_relocs[i]);
+		}
 	}
 
 	total_size = 0;
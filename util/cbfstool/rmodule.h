@@ -27,4 +27,14 @@
  */
 int rmodule_create(const struct buffer *elfin, struct buffer *elfout);
 
+/*
+ * Pack the sorted relocation addresses as a version 2 relocation stream,
+ * see src/include/rmodule-defs.h. Nothing is written if out is NULL.
+ * Return the size of the stream, or < 0 if the relocations are not all
+ * unique and aligned to ptr_size from link_addr.
+ */
+ssize_t rmodule_pack_relocs(struct buffer *out, const Elf64_Addr *relocs,
+                            size_t nrelocs, Elf64_Addr link_addr,
+                            size_t ptr_size);
+
 #endif /* TOOL_RMODULE_H */
@@ -0,0 +1,307 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Host test for src/drivers/elog/elog.c.
+ *
+ * Every boot runs in a child process that initializes the log and adds a
+ * few events to a simulated SPI flash shared with the parent, which then
+ * parses the area the way an OS reader does. Events carry a sequence
+ * number, so the log must always hold an unbroken run of the most recent
+ * ones. Legacy logs without checkpoints must be picked up and converted,
+ * and a corrupted tail must be noticed.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <rtc.h>
+#include <spi_flash.h>
+#include <elog.h>
+#include "elog_internal.h"
+
+#define FLASH_SIZE	CONFIG_ROM_SIZE
+#define SECTOR_SIZE	4096
+#define AREA		(CONFIG_ELOG_FLASH_BASE)
+#define LOG_SIZE	(CONFIG_ELOG_AREA_SIZE - sizeof(struct elog_header))
+#define TEST_BOOTS	400
+
+static struct {
+	u8 flash[FLASH_SIZE];
+	unsigned long bytes_read;
+	unsigned long init_read;
+	int bad_writes;
+} *shared;
+
+static int failures;
+static u32 next_seq;
+static unsigned long init_read_total;
+static int boots;
+
+static int flash_read(struct spi_flash *flash, u32 offset, size_t len,
+		      void *buf)
+{
+	memcpy(buf, &shared->flash[offset], len);
+	shared->bytes_read += len;
+	return 0;
+}
+
+static int flash_write(struct spi_flash *flash, u32 offset, size_t len,
+		       const void *buf)
+{
+	const u8 *data = buf;
+	size_t i;
+
+	/* Programming can only clear bits */
+	for (i = 0; i < len; i++) {
+		if ((shared->flash[offset + i] & data[i]) != data[i])
+			shared->bad_writes++;
+		shared->flash[offset + i] &= data[i];
+	}
+	return 0;
+}
+
+static int flash_erase(struct spi_flash *flash, u32 offset, size_t len)
+{
+	if (offset % SECTOR_SIZE || len % SECTOR_SIZE)
+		shared->bad_writes++;
+	memset(&shared->flash[offset], 0xff, len);
+	return 0;
+}
+
+static struct spi_flash flash = {
+	.name = "sim",
+	.size = FLASH_SIZE,
+	.sector_size = SECTOR_SIZE,
+	.read = flash_read,
+	.write = flash_write,
+	.erase = flash_erase,
+};
+
+struct spi_flash *spi_flash_probe(unsigned int bus, unsigned int cs)
+{
+	return &flash;
+}
+
+int rtc_get(struct rtc_time *time)
+{
+	memset(time, 0, sizeof(*time));
+	time->year = 15;
+	time->mon = 6;
+	time->mday = 1;
+	return 0;
+}
+
+static void fail(const char *what)
+{
+	fprintf(stderr, "boot %d: %s\n", boots, what);
+	failures++;
+}
+
+/* Add 'count' events numbered from next_seq in a fresh process. */
+static void boot(int count)
+{
+	u8 data[MAX_EVENT_SIZE];
+	pid_t pid;
+	int i, j, status;
+
+	boots++;
+	fflush(stdout);
+	fflush(stderr);
+	pid = fork();
+	if (pid < 0)
+		exit(1);
+	if (pid == 0) {
+		shared->bytes_read = 0;
+		if (elog_init() < 0)
+			exit(1);
+		shared->init_read = shared->bytes_read;
+
+		for (i = 0; i < count; i++) {
+			u8 size = 4 + rand() % (MAX_EVENT_SIZE -
+					ELOG_MIN_EVENT_SIZE - 4 + 1);
+			u32 seq = next_seq + i;
+
+			memcpy(data, &seq, sizeof(seq));
+			for (j = 4; j < size; j++)
+				data[j] = rand();
+			elog_add_event_raw(ELOG_TYPE_OS_EVENT, data, size);
+		}
+		exit(0);
+	}
+
+	if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) ||
+	    WEXITSTATUS(status))
+		fail("elog_init failed");
+	next_seq += count;
+	init_read_total += shared->init_read;
+	/* Keep the children's random sequences apart */
+	rand();
+}
+
+/*
+ * Parse the area like an OS reader. Returns the number of test events,
+ * which must be the 'expected' most recent ones or more.
+ */
+static int check_log(int want_indexed, u32 expected)
+{
+	const struct elog_header *header = (void *)&shared->flash[AREA];
+	const u8 *log = &shared->flash[AREA + sizeof(*header)];
+	const int indexed = header->reserved[0] == ELOG_CHECKPOINT_SHIFT;
+	u32 offset, i, seq = 0, found = 0;
+	u8 length, sum;
+
+	if (shared->bad_writes) {
+		fail("flash written without erase");
+		shared->bad_writes = 0;
+	}
+	if (header->magic != ELOG_SIGNATURE || header->version != ELOG_VERSION
+	    || header->header_size != sizeof(*header))
+		fail("bad header");
+	if (want_indexed != indexed)
+		fail(indexed ? "log unexpectedly indexed" : "log not indexed");
+
+	for (offset = 0; log[offset] != ELOG_TYPE_EOL; offset += length) {
+		length = log[offset + 1];
+		if (length < ELOG_MIN_EVENT_SIZE || offset + length >= LOG_SIZE) {
+			fail("bad event length");
+			return -1;
+		}
+		for (i = 0, sum = 0; i < length; i++)
+			sum += log[offset + i];
+		if (sum)
+			fail("bad event checksum");
+		if (indexed && offset / ELOG_CHECKPOINT_SIZE !=
+		    (offset + length - 1) / ELOG_CHECKPOINT_SIZE)
+			fail("event straddles a checkpoint");
+		if (log[offset] != ELOG_TYPE_OS_EVENT)
+			continue;
+		if (found && log[offset + 8] + (log[offset + 9] << 8) +
+		    (log[offset + 10] << 16) + (log[offset + 11] << 24) !=
+		    seq + 1)
+			fail("events out of sequence");
+		memcpy(&seq, &log[offset + 8], sizeof(seq));
+		found++;
+	}
+	for (; offset < LOG_SIZE; offset++)
+		if (log[offset] != ELOG_TYPE_EOL)
+			fail("area not clear after the last event");
+
+	if (found < expected || (found && seq != next_seq - 1))
+		fail("recent events missing");
+	return found;
+}
+
+static void test_indexed(void)
+{
+	int i;
+
+	memset(shared->flash, 0xff, FLASH_SIZE);
+	next_seq = 0;
+	for (i = 0; i < TEST_BOOTS; i++) {
+		int count = rand() % 8;
+
+		boot(count);
+		check_log(1, count);
+	}
+	printf("indexed log: %lu bytes read per init, area is %u\n",
+	       init_read_total / TEST_BOOTS, CONFIG_ELOG_AREA_SIZE);
+}
+
+static void test_legacy(void)
+{
+	struct elog_header *header = (void *)&shared->flash[AREA];
+	u8 *log = &shared->flash[AREA + sizeof(*header)];
+	u32 offset = 0;
+	int i;
+
+	/* A log written before checkpoints, with events across them */
+	memset(shared->flash, 0xff, FLASH_SIZE);
+	header->magic = ELOG_SIGNATURE;
+	header->version = ELOG_VERSION;
+	header->header_size = sizeof(*header);
+	for (next_seq = 0; offset < LOG_SIZE - 1024; next_seq++) {
+		struct event_header *event = (void *)&log[offset];
+		u8 sum = 0;
+
+		memset(event, 0, sizeof(*event) + 5);
+		event->type = ELOG_TYPE_OS_EVENT;
+		event->length = sizeof(*event) + 5;
+		memcpy(&event[1], &next_seq, sizeof(next_seq));
+		for (i = 0; i < event->length; i++)
+			sum += log[offset + i];
+		log[offset + event->length - 1] = -sum;
+		offset += event->length;
+	}
+	check_log(0, next_seq);
+
+	init_read_total = 0;
+	boot(0);
+	check_log(0, next_seq);
+	if (init_read_total < CONFIG_ELOG_AREA_SIZE)
+		fail("legacy log not read in full");
+
+	/* The first shrink converts it */
+	for (i = 0; i < 40; i++)
+		boot(4);
+	check_log(1, 4);
+}
+
+static void test_corrupt(void)
+{
+	u8 *log = &shared->flash[AREA + sizeof(struct elog_header)];
+	u32 offset = 0, last = 0;
+
+	memset(shared->flash, 0xff, FLASH_SIZE);
+	next_seq = 0;
+	boot(20);
+	check_log(1, 20);
+
+	for (offset = 0; log[offset] != ELOG_TYPE_EOL; offset += log[offset + 1])
+		last = offset;
+	log[last + 4] ^= 0x10;
+
+	/* The area gets erased and starts over with a clear event */
+	fprintf(stderr, "(expecting an invalid flash area)\n");
+	boot(0);
+	if (check_log(1, 0) != 0)
+		fail("corrupted log kept");
+	if (log[0] != ELOG_TYPE_LOG_CLEAR)
+		fail("no clear event after corruption");
+}
+
+int main(int argc, char **argv)
+{
+	shared = mmap(NULL, sizeof(*shared), PROT_READ | PROT_WRITE,
+		      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (shared == MAP_FAILED)
+		return 1;
+
+	srand(1);
+	test_indexed();
+	test_legacy();
+	test_corrupt();
+
+	if (failures) {
+		fprintf(stderr, "%d failure(s)\n", failures);
+		return 1;
+	}
+	printf("elog tests passed\n");
+	return 0;
+}
@@ -0,0 +1,34 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/* Build configuration for elog.c on the host: a fixed area, no FMAP. */
+
+#ifndef ELOGTEST_CONFIG_H
+#define ELOGTEST_CONFIG_H
+
+#define CONFIG_ELOG 1
+#define CONFIG_ELOG_DEBUG 0
+#define CONFIG_ELOG_CBMEM 0
+#define CONFIG_ELOG_GSMI 0
+#define CONFIG_ELOG_BOOT_COUNT 0
+#define CONFIG_ELOG_AREA_SIZE 0x1000
+#define CONFIG_ELOG_FLASH_BASE 0x1000
+#define CONFIG_USE_FMAP 0
+#define CONFIG_ARCH_X86 0
+#define CONFIG_HAVE_ACPI_RESUME 0
+#define CONFIG_BOOT_MEDIA_SPI_BUS 0
+#define CONFIG_ROM_SIZE 0x10000
+
+#endif
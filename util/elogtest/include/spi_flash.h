@@ -0,0 +1,41 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/* Host replacement for coreboot's spi_flash.h, used by elog.c. */
+
+#ifndef _SPI_FLASH_H_
+#define _SPI_FLASH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct spi_flash {
+	const char	*name;
+	u32		size;
+	u32		sector_size;
+	int		(*read)(struct spi_flash *flash, u32 offset,
+				size_t len, void *buf);
+	int		(*write)(struct spi_flash *flash, u32 offset,
+				size_t len, const void *buf);
+	int		(*erase)(struct spi_flash *flash, u32 offset,
+				size_t len);
+};
+
+struct spi_flash *spi_flash_probe(unsigned int bus, unsigned int cs);
+
+int spi_flash_update(struct spi_flash *flash, u32 offset, size_t len,
+		     const void *buf);
+
+#endif
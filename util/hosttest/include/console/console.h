@@ -0,0 +1,45 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * printk() for the host tests. Messages up to HOSTTEST_LOGLEVEL go to
+ * stderr, the default only shows errors since the tests provoke some on
+ * purpose. Not format checked: coreboot's uint64_t is unsigned long long.
+ */
+
+#ifndef HOSTTEST_CONSOLE_H
+#define HOSTTEST_CONSOLE_H
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <console/loglevel.h>
+
+#ifndef HOSTTEST_LOGLEVEL
+#define HOSTTEST_LOGLEVEL	BIOS_ERR
+#endif
+
+static inline void printk(int level, const char *fmt, ...)
+{
+	va_list args;
+
+	if (level > HOSTTEST_LOGLEVEL)
+		return;
+
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+}
+
+#endif
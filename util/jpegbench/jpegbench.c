@@ -0,0 +1,180 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Decodes a boot splash with coreboot's JPEG decoder on the host and
+ * reports how long that took at every supported depth and scale. The
+ * decoded image can be written out to compare decoder changes.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "jpeg.h"
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [-r runs] [-d depth -s scale -o out.raw] file.jpg\n"
+		"\n"
+		"  -r runs   decode every configuration this many times\n"
+		"  -d depth  only decode at 16, 24 or 32 bits per pixel\n"
+		"  -s scale  only decode at 1/1, 1/2, 1/4 or 1/8 of the size\n"
+		"  -o file   write the last decoded picture to file\n",
+		name);
+	exit(1);
+}
+
+static unsigned char *read_file(const char *name, long *size_out)
+{
+	unsigned char *buf;
+	FILE *f;
+	long size;
+
+	f = fopen(name, "rb");
+	if (!f) {
+		perror(name);
+		exit(1);
+	}
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	/* The decoder may read a few bytes past the end of the data. */
+	buf = calloc(1, size + 16);
+	if (!buf || fread(buf, 1, size, f) != size) {
+		fprintf(stderr, "%s: read failed\n", name);
+		exit(1);
+	}
+	fclose(f);
+	*size_out = size;
+	return buf;
+}
+
+/* Get the picture size from the baseline frame header. */
+static int frame_size(const unsigned char *jpeg, long size, int *width,
+		      int *height)
+{
+	long i;
+
+	for (i = 2; i + 9 < size; i += 2 + (jpeg[i + 2] << 8 | jpeg[i + 3])) {
+		if (jpeg[i] != 0xff)
+			return -1;
+		if (jpeg[i + 1] == 0xc0) {
+			*height = jpeg[i + 5] << 8 | jpeg[i + 6];
+			*width = jpeg[i + 7] << 8 | jpeg[i + 8];
+			return 0;
+		}
+	}
+	return -1;
+}
+
+int main(int argc, char **argv)
+{
+	static const int depths[] = { 16, 24, 32 };
+	static const int scales[] = { 1, 2, 4, 8 };
+	struct jpeg_decdata *decdata;
+	unsigned char *jpeg, *fb = NULL;
+	const char *out = NULL;
+	int runs = 10, depth = 0, scale = 0;
+	int width, height, stride = 0, size = 0;
+	int d, s, i, ret, opt;
+	long len;
+	double start, t;
+
+	while ((opt = getopt(argc, argv, "r:d:s:o:h")) != -1) {
+		switch (opt) {
+		case 'r':
+			runs = atoi(optarg);
+			break;
+		case 'd':
+			depth = atoi(optarg);
+			break;
+		case 's':
+			scale = atoi(optarg);
+			break;
+		case 'o':
+			out = optarg;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (optind != argc - 1 || runs < 1)
+		usage(argv[0]);
+
+	jpeg = read_file(argv[optind], &len);
+	if (frame_size(jpeg, len, &width, &height) ||
+	    !jpeg_check_size(jpeg, width, height)) {
+		fprintf(stderr, "%s: not a baseline JPEG\n", argv[optind]);
+		return 1;
+	}
+	decdata = malloc(sizeof(*decdata));
+	fb = malloc(width * height * 4);
+	if (!decdata || !fb)
+		return 1;
+	printf("%dx%d, %d runs\n", width, height, runs);
+
+	for (d = 0; d < 3; d++) {
+		if (depth && depth != depths[d])
+			continue;
+		for (s = 0; s < 4; s++) {
+			if (scale && scale != scales[s])
+				continue;
+			stride = width / scales[s] * depths[d] / 8;
+			size = stride * (height / scales[s]);
+			start = now();
+			for (i = 0; i < runs; i++) {
+				ret = jpeg_decode_fb(jpeg, fb, width, height,
+						     depths[d], stride,
+						     scales[s], decdata);
+				if (ret) {
+					fprintf(stderr, "decode failed: %d\n",
+						ret);
+					return 1;
+				}
+			}
+			t = (now() - start) / runs;
+			printf("%2d bpp 1/%d: %8.3f ms %8.1f Mpixel/s\n",
+			       depths[d], scales[s], t * 1000,
+			       width * height / t / 1e6);
+		}
+	}
+
+	if (out) {
+		FILE *f = fopen(out, "wb");
+
+		if (!f || fwrite(fb, 1, size, f) != size) {
+			perror(out);
+			return 1;
+		}
+		fclose(f);
+	}
+
+	free(fb);
+	free(decdata);
+	free(jpeg);
+	return 0;
+}
@@ -0,0 +1,246 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Host test and benchmark for src/lib/memrange.c.
+ *
+ * Random sequences of inserts, holes and hole fills are applied both to a
+ * memranges and to a page map of the same address space. After every
+ * operation the list must describe exactly the page map, be sorted and
+ * merged, and the search tree must hold the same entries in the same
+ * order. The benchmark then times the operations on a large map.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <memrange.h>
+
+#define PAGE_SIZE	4096
+#define MODEL_PAGES	16384
+#define TEST_ROUNDS	200
+#define TEST_OPS	200
+#define BENCH_RANGES	20000
+
+static unsigned long model[MODEL_PAGES];
+static int failures;
+
+/* memranges_init() pulls in device resources. There are none here. */
+void search_global_resources(unsigned long type_mask, unsigned long type,
+			     resource_search_t search, void *gp)
+{
+}
+
+static void fail(const char *what, int round, int op)
+{
+	fprintf(stderr, "round %d op %d: %s\n", round, op, what);
+	failures++;
+}
+
+static void model_set(resource_t base, resource_t size, unsigned long tag)
+{
+	resource_t page;
+	resource_t first = base / PAGE_SIZE;
+	resource_t last = (base + size + PAGE_SIZE - 1) / PAGE_SIZE;
+
+	if (size == 0)
+		return;
+	for (page = first; page < last && page < MODEL_PAGES; page++)
+		model[page] = tag;
+}
+
+static void model_fill_holes(resource_t limit, unsigned long tag)
+{
+	resource_t page;
+
+	/* Holes are only filled from the first entry onwards. */
+	for (page = 0; page < MODEL_PAGES && !model[page]; page++)
+		;
+	for (; page < limit / PAGE_SIZE; page++)
+		if (!model[page])
+			model[page] = tag;
+}
+
+static int tree_check(const struct range_entry *t,
+		      const struct range_entry **next)
+{
+	int ret = 0;
+
+	if (t == NULL)
+		return 0;
+	if ((t->left && t->left->priority > t->priority) ||
+	    (t->right && t->right->priority > t->priority))
+		ret = -1;
+	if (tree_check(t->left, next))
+		ret = -1;
+	/* In-order walk must visit the entries in list order. */
+	if (*next != t)
+		ret = -1;
+	*next = t->next;
+	if (tree_check(t->right, next))
+		ret = -1;
+	return ret;
+}
+
+static void check(struct memranges *ranges, int round, int op)
+{
+	const struct range_entry *r, *prev = NULL;
+	const struct range_entry *next;
+	resource_t page = 0;
+
+	memranges_each_entry(r, ranges) {
+		if (r->end < r->begin)
+			fail("inverted entry", round, op);
+		if (prev && prev->end >= r->begin)
+			fail("unsorted or overlapping entries", round, op);
+		if (prev && prev->end + 1 == r->begin && prev->tag == r->tag)
+			fail("unmerged neighbors", round, op);
+
+		for (; page < range_entry_base(r) / PAGE_SIZE; page++)
+			if (model[page])
+				fail("page missing from ranges", round, op);
+		for (; page < range_entry_end(r) / PAGE_SIZE; page++)
+			if (model[page] != range_entry_tag(r))
+				fail("page tag mismatch", round, op);
+		prev = r;
+	}
+	for (; page < MODEL_PAGES; page++)
+		if (model[page])
+			fail("page missing from ranges", round, op);
+
+	next = ranges->entries;
+	if (tree_check(ranges->root, &next) || next != NULL)
+		fail("search tree does not match list", round, op);
+}
+
+static resource_t last_end(struct memranges *ranges)
+{
+	const struct range_entry *r, *last = NULL;
+
+	memranges_each_entry(r, ranges)
+		last = r;
+	return last ? range_entry_end(last) : 0;
+}
+
+static resource_t random_addr(void)
+{
+	return (resource_t)(rand() % (MODEL_PAGES * 4)) * (PAGE_SIZE / 4);
+}
+
+static void test_random(void)
+{
+	struct memranges ranges;
+	int round, op;
+
+	for (round = 0; round < TEST_ROUNDS; round++) {
+		memranges_init(&ranges, 0, 0, 0);
+		memset(model, 0, sizeof(model));
+
+		for (op = 0; op < TEST_OPS; op++) {
+			resource_t base = random_addr();
+			resource_t size = rand() % 4 ? rand() % (64 * PAGE_SIZE)
+						     : random_addr();
+			unsigned long tag = 1 + rand() % 3;
+
+			if (base + size > (resource_t)MODEL_PAGES * PAGE_SIZE)
+				size = (resource_t)MODEL_PAGES * PAGE_SIZE - base;
+
+			switch (rand() % 8) {
+			case 0:
+			case 1:
+				memranges_create_hole(&ranges, base, size);
+				model_set(base, size, 0);
+				break;
+			case 2:
+				/* Limits inside the last entry are not
+				 * supported, so fill up to beyond it. */
+				base = ALIGN_UP(base, PAGE_SIZE);
+				if (base < last_end(&ranges))
+					base = last_end(&ranges);
+				memranges_fill_holes_up_to(&ranges, base, tag);
+				model_fill_holes(base, tag);
+				break;
+			default:
+				memranges_insert(&ranges, base, size, tag);
+				model_set(base, size, tag);
+				break;
+			}
+			check(&ranges, round, op);
+		}
+		memranges_teardown(&ranges);
+		if (ranges.entries != NULL || ranges.root != NULL)
+			fail("teardown left entries behind", round, op);
+	}
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench(void)
+{
+	struct memranges ranges;
+	double start;
+	int i, count = 0;
+	const struct range_entry *r;
+
+	memranges_init_empty(&ranges);
+
+	/* Every other slot, alternating tags, so nothing merges. */
+	start = now();
+	for (i = 0; i < BENCH_RANGES; i++)
+		memranges_insert(&ranges, (resource_t)(rand() % BENCH_RANGES)
+				 * 4 * PAGE_SIZE, PAGE_SIZE, 1 + i % 2);
+	printf("%d inserts:    %8.3f ms\n", BENCH_RANGES,
+	       (now() - start) * 1000);
+
+	start = now();
+	for (i = 0; i < BENCH_RANGES; i++)
+		memranges_create_hole(&ranges, (resource_t)(rand() %
+				      BENCH_RANGES) * 4 * PAGE_SIZE + 1024,
+				      PAGE_SIZE / 2);
+	printf("%d holes:      %8.3f ms\n", BENCH_RANGES,
+	       (now() - start) * 1000);
+
+	start = now();
+	memranges_fill_holes_up_to(&ranges,
+				   (resource_t)BENCH_RANGES * 4 * PAGE_SIZE, 3);
+	printf("fill holes:       %8.3f ms\n", (now() - start) * 1000);
+
+	memranges_each_entry(r, &ranges)
+		count++;
+	printf("%d entries left\n", count);
+	memranges_teardown(&ranges);
+}
+
+int main(int argc, char **argv)
+{
+	srand(1);
+	test_random();
+	bench();
+
+	if (failures) {
+		fprintf(stderr, "%d failure(s)\n", failures);
+		return 1;
+	}
+	printf("memrange tests passed\n");
+	return 0;
+}
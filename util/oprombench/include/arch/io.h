@@ -0,0 +1,31 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Host replacement for the port I/O functions. x86emu's default port
+ * handlers use them, oprombench installs its own handlers instead.
+ */
+
+#ifndef __ARCH_IO_H__
+#define __ARCH_IO_H__
+
+static inline void outb(unsigned char val, unsigned short port) {}
+static inline void outw(unsigned short val, unsigned short port) {}
+static inline void outl(unsigned int val, unsigned short port) {}
+static inline unsigned char inb(unsigned short port) { return 0xff; }
+static inline unsigned short inw(unsigned short port) { return 0xffff; }
+static inline unsigned int inl(unsigned short port) { return 0xffffffff; }
+
+#endif
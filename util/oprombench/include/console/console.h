@@ -0,0 +1,28 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/* Host replacement for coreboot's console, used by the x86emu sources. */
+
+#ifndef __CONSOLE_CONSOLE_H__
+#define __CONSOLE_CONSOLE_H__
+
+#include <stdio.h>
+
+#define BIOS_DEBUG	7
+
+void printk(int msg_level, const char *fmt, ...)
+	__attribute__((format(printf, 2, 3)));
+
+#endif
@@ -0,0 +1,33 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * The host's endian.h plus the conversion helpers of coreboot's, used by
+ * the YABEL sources. The bench only runs on little endian hosts.
+ */
+
+#ifndef __OPROMBENCH_ENDIAN_H__
+#define __OPROMBENCH_ENDIAN_H__
+
+#include_next <endian.h>
+
+#if __BYTE_ORDER != __LITTLE_ENDIAN
+#error "oprombench needs a little endian host"
+#endif
+
+#define cpu_to_le16(x)	((uint16_t)(x))
+#define cpu_to_le32(x)	((uint32_t)(x))
+
+#endif
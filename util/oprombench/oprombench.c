@@ -0,0 +1,832 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Runs a VGA option ROM in coreboot's x86emu on the host and reports how
+ * fast it was emulated. The system around the emulator is kept minimal:
+ * 1MB of real mode memory set up like YABEL does it, a PCI config space
+ * built from the ROM's PCI data structure, plain RAM behind the memory
+ * BARs, and an I/O port space that just remembers the last value written.
+ *
+ * With -c, the ROM is also run by a second build of the bench (normally
+ * one without the fetch cache) and the register state of both emulators
+ * is compared before every instruction. The other build is started with
+ * -T and sends its trace through a pipe.
+ *
+ * Built with OPROMBENCH_YABEL, the emulated memory accesses go through
+ * YABEL's mem.c instead, with a translate_address_array laid out like
+ * biosemu_dev_get_addr_info() does it, so that its address translation
+ * is measured as well.
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <x86emu/x86emu.h>
+#include <x86emu/regs.h>
+#include "../../src/device/oprom/x86emu/ops.h"
+#include "../../src/device/oprom/x86emu/prim_ops.h"
+#if OPROMBENCH_YABEL
+#include <device/resource.h>
+#include "../../src/device/oprom/yabel/device.h"
+#include "../../src/device/oprom/yabel/mem.h"
+#include "../../src/device/oprom/yabel/compat/time.h"
+#endif
+
+#define MEM_SIZE		(1024 * 1024)
+#define ROM_SEGMENT		0xc000
+#define STACK_SEGMENT		0x1000
+#define STACK_START_OFFSET	0xfffe
+#define DATA_SEGMENT		0x2000
+#define EBDA_SEGMENT		0x9fc0
+
+#define PCI_BUS			1
+#define PCI_DEVFN		0x00
+
+struct bar {
+	u32 base;
+	u32 size;
+	u32 flags;		/* low bits of the BAR register */
+	u8 *data;		/* backing RAM, NULL for I/O BARs */
+};
+
+static struct bar bars[6] = {
+	{ 0xd0000000, 16 * 1024 * 1024, 0x8 },	/* prefetchable framebuffer */
+	{ 0 },
+	{ 0xd1000000, 512 * 1024, 0x0 },	/* registers */
+	{ 0 },
+	{ 0x2000, 256, 0x1 },			/* I/O */
+	{ 0 },
+};
+
+static u8 *mem;
+static u8 cfg[256];
+static u8 ports[0x10000];
+static u32 cf8;
+
+static unsigned long long op_count[256];
+static unsigned long long op2_count[256];
+static unsigned long long port_reads[0x10000];
+static unsigned long long port_writes[0x10000];
+static unsigned long long unmapped_accesses;
+static unsigned long long instructions;
+static unsigned long long max_instructions;
+
+static FILE *trace_out, *trace_in;
+static unsigned long long mismatches;
+
+struct trace_regs {
+	u32 eax, ebx, ecx, edx, esi, edi, ebp, esp, eip, flags;
+	u16 cs, ds, es, ss, fs, gs;
+};
+
+static void (*orig_optab[256])(u8 op1);
+static void (*orig_optab2[256])(u8 op2);
+
+void printk(int msg_level, const char *fmt, ...)
+{
+	va_list args;
+
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+}
+
+/* Memory */
+
+static u8 *mem_ptr(u32 addr, int size)
+{
+	int i;
+
+	if (addr <= MEM_SIZE - size)
+		return mem + addr;
+	for (i = 0; i < 6; i++) {
+		if (bars[i].data && addr >= bars[i].base &&
+		    addr - bars[i].base <= bars[i].size - size)
+			return bars[i].data + addr - bars[i].base;
+	}
+	unmapped_accesses++;
+	return NULL;
+}
+
+#if !OPROMBENCH_YABEL
+static u8 mem_rdb(u32 addr)
+{
+	u8 *p = mem_ptr(addr, 1);
+
+	return p ? *p : 0xff;
+}
+
+static u16 mem_rdw(u32 addr)
+{
+	u8 *p = mem_ptr(addr, 2);
+
+	return p ? p[0] | p[1] << 8 : 0xffff;
+}
+
+static u32 mem_rdl(u32 addr)
+{
+	u8 *p = mem_ptr(addr, 4);
+
+	return p ? p[0] | p[1] << 8 | p[2] << 16 | (u32)p[3] << 24
+		 : 0xffffffff;
+}
+#endif
+
+static void mem_wrb(u32 addr, u8 val)
+{
+	u8 *p = mem_ptr(addr, 1);
+
+	if (p)
+		p[0] = val;
+}
+
+static void mem_wrw(u32 addr, u16 val)
+{
+	u8 *p = mem_ptr(addr, 2);
+
+	if (p) {
+		p[0] = val;
+		p[1] = val >> 8;
+	}
+}
+
+static void mem_wrl(u32 addr, u32 val)
+{
+	u8 *p = mem_ptr(addr, 4);
+
+	if (p) {
+		p[0] = val;
+		p[1] = val >> 8;
+		p[2] = val >> 16;
+		p[3] = val >> 24;
+	}
+}
+
+#if OPROMBENCH_YABEL
+/* What YABEL's device.c and compat code provide for mem.c */
+
+translate_address_t translate_address_array[13];
+u8 taa_last_entry;
+
+/* A clock that stands still, so that the BDA timer reads stay the same. */
+unsigned long tb_freq = 1000;
+
+u64 get_time(void)
+{
+	return 0;
+}
+
+/* Same as in YABEL's device.c, for the coreboot build. */
+u8 biosemu_dev_translate_address(int type, unsigned long *addr)
+{
+	int i = 0;
+	translate_address_t ta;
+
+	for (i = 0; i <= taa_last_entry; i++) {
+		ta = translate_address_array[i];
+		if ((*addr >= ta.address) && (*addr <= (ta.address + ta.size))
+		    && (ta.info & type)) {
+			*addr += ta.address_offset;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void taa_add(int *index, unsigned long info, u8 cfg_space_offset,
+		    u32 address, u32 size, const u8 *host)
+{
+	translate_address_t *ta = &translate_address_array[(*index)++];
+
+	ta->info = info;
+	ta->bus = PCI_BUS;
+	ta->devfn = PCI_DEVFN;
+	ta->cfg_space_offset = cfg_space_offset;
+	ta->address = address;
+	ta->size = size;
+	ta->address_offset = (unsigned long)host - address;
+}
+
+/*
+ * Set up the translations like biosemu_dev_get_addr_info() and biosemu()
+ * do: the BARs, the legacy VGA ranges and the "special memory". Where
+ * coreboot maps 1:1, the bench maps to the host memory backing the range.
+ */
+static void taa_init(void)
+{
+	int i, n = 0;
+
+	for (i = 0; i < 6; i++) {
+		if (!bars[i].size)
+			continue;
+		if (bars[i].data)
+			taa_add(&n, IORESOURCE_MEM, 0x10 + i * 4, bars[i].base,
+				bars[i].size, bars[i].data);
+		else
+			taa_add(&n, IORESOURCE_IO, 0x10 + i * 4, bars[i].base,
+				bars[i].size, (u8 *)(unsigned long)bars[i].base);
+	}
+	taa_add(&n, IORESOURCE_IO, 0, 0x3b0, 0xc, (u8 *)0x3b0);
+	taa_add(&n, IORESOURCE_IO, 0, 0x3c0, 0x20, (u8 *)0x3c0);
+	taa_add(&n, IORESOURCE_MEM, 0, 0xa0000, 0x20000, mem + 0xa0000);
+	taa_add(&n, IORESOURCE_MEM, 0, 0, 0x500, mem);
+	taa_add(&n, IORESOURCE_MEM, 0, ROM_SEGMENT << 4, 0x10000,
+		mem + (ROM_SEGMENT << 4));
+	taa_last_entry = n - 1;
+	biosemu_mem_tlb_flush();
+}
+
+#endif
+
+static X86EMU_memFuncs mem_funcs = {
+#if OPROMBENCH_YABEL
+	my_rdb, my_rdw, my_rdl, my_wrb, my_wrw, my_wrl
+#else
+	mem_rdb, mem_rdw, mem_rdl, mem_wrb, mem_wrw, mem_wrl
+#endif
+};
+
+/* PCI config space */
+
+static u32 cfg_read(u8 bus, u8 devfn, u8 offs, int size)
+{
+	u32 val = 0;
+	int i;
+
+	if (bus != PCI_BUS || devfn != PCI_DEVFN)
+		return 0xffffffff >> (32 - size * 8);
+	for (i = 0; i < size && offs + i < 256; i++)
+		val |= cfg[offs + i] << (i * 8);
+	return val;
+}
+
+static void cfg_write(u8 bus, u8 devfn, u8 offs, u32 val, int size)
+{
+	int i, bar;
+	u32 reg;
+
+	if (bus != PCI_BUS || devfn != PCI_DEVFN)
+		return;
+	/* the IDs and the class code are read-only */
+	for (i = 0; i < size && offs + i < 256; i++)
+		if (offs + i >= 0x04 && offs + i < 0x08)
+			cfg[offs + i] = val >> (i * 8);
+	if (offs < 0x10 || offs >= 0x28)
+		return;
+
+	/* BARs, including sizing */
+	bar = (offs - 0x10) / 4;
+	reg = cfg_read(bus, devfn, offs & ~3, 4);
+	for (i = 0; i < size; i++) {
+		reg &= ~(0xff << ((offs + i) % 4 * 8));
+		reg |= (val & 0xff) << ((offs + i) % 4 * 8);
+		val >>= 8;
+	}
+	if (bars[bar].size) {
+		bars[bar].base = reg & ~(bars[bar].size - 1);
+		reg = bars[bar].base | bars[bar].flags;
+	} else {
+		reg = 0;
+	}
+	for (i = 0; i < 4; i++)
+		cfg[(offs & ~3) + i] = reg >> (i * 8);
+#if OPROMBENCH_YABEL
+	/* YABEL flushes its TLB on BAR writes too, see io.c */
+	taa_init();
+#endif
+}
+
+static void cfg_init(const u8 *rom)
+{
+	const u8 *pcir = rom + (rom[0x18] | rom[0x19] << 8);
+	int i;
+
+	memset(cfg, 0, sizeof(cfg));
+	memcpy(&cfg[0x00], pcir + 4, 4);	/* vendor and device ID */
+	memcpy(&cfg[0x09], pcir + 0xd, 3);	/* class code */
+	cfg[0x04] = 0x03;			/* I/O and memory decode */
+	cfg[0x0e] = 0x00;			/* header type */
+	for (i = 0; i < 6; i++) {
+		u32 reg = bars[i].base | bars[i].flags;
+		cfg[0x10 + i * 4] = reg;
+		cfg[0x11 + i * 4] = reg >> 8;
+		cfg[0x12 + i * 4] = reg >> 16;
+		cfg[0x13 + i * 4] = reg >> 24;
+	}
+}
+
+/* I/O ports */
+
+static u32 port_read(X86EMU_pioAddr addr, int size)
+{
+	u32 val = 0;
+	int i;
+
+	port_reads[addr]++;
+	if (addr == 0xcf8 && size == 4)
+		return cf8;
+	if (addr >= 0xcfc && addr <= 0xcff) {
+		if (!(cf8 & 0x80000000))
+			return 0xffffffff >> (32 - size * 8);
+		return cfg_read(cf8 >> 16, cf8 >> 8,
+				(cf8 & 0xfc) + (addr & 3), size);
+	}
+
+	/* Let status bits toggle so polling loops terminate. */
+	if (addr == 0x3da || addr == 0x3ba)
+		ports[addr] ^= 0x09;	/* display enable, vertical retrace */
+	else if (addr == 0x61)
+		ports[addr] ^= 0x10;	/* refresh */
+
+	for (i = 0; i < size; i++)
+		val |= ports[(u16)(addr + i)] << (i * 8);
+	return val;
+}
+
+static void port_write(X86EMU_pioAddr addr, u32 val, int size)
+{
+	int i;
+
+	port_writes[addr]++;
+	if (addr == 0xcf8 && size == 4) {
+		cf8 = val;
+		return;
+	}
+	if (addr >= 0xcfc && addr <= 0xcff) {
+		if (cf8 & 0x80000000)
+			cfg_write(cf8 >> 16, cf8 >> 8,
+				  (cf8 & 0xfc) + (addr & 3), val, size);
+		return;
+	}
+	for (i = 0; i < size; i++)
+		ports[(u16)(addr + i)] = val >> (i * 8);
+}
+
+static u8 io_inb(X86EMU_pioAddr addr) { return port_read(addr, 1); }
+static u16 io_inw(X86EMU_pioAddr addr) { return port_read(addr, 2); }
+static u32 io_inl(X86EMU_pioAddr addr) { return port_read(addr, 4); }
+static void io_outb(X86EMU_pioAddr addr, u8 val) { port_write(addr, val, 1); }
+static void io_outw(X86EMU_pioAddr addr, u16 val) { port_write(addr, val, 2); }
+static void io_outl(X86EMU_pioAddr addr, u32 val) { port_write(addr, val, 4); }
+
+static X86EMU_pioFuncs pio_funcs = {
+	io_inb, io_inw, io_inl, io_outb, io_outw, io_outl
+};
+
+/* PCI BIOS (int 1a, ax = b1xx) */
+
+static void int1a_handler(int num)
+{
+	u8 bus = M.x86.R_BH, devfn = M.x86.R_BL;
+	u32 class;
+
+	if (M.x86.R_AH != 0xb1) {
+		SET_FLAG(F_CF);
+		return;
+	}
+
+	CLEAR_FLAG(F_CF);
+	switch (M.x86.R_AL) {
+	case 0x01:	/* installation check */
+		M.x86.R_AX = 0x0001;
+		M.x86.R_BX = 0x0210;
+		M.x86.R_CX = PCI_BUS;
+		M.x86.R_EDX = 0x20494350;	/* "PCI " */
+		return;
+	case 0x02:	/* find device */
+		if (M.x86.R_SI == 0 &&
+		    M.x86.R_DX == (cfg[0] | cfg[1] << 8) &&
+		    M.x86.R_CX == (cfg[2] | cfg[3] << 8)) {
+			M.x86.R_BH = PCI_BUS;
+			M.x86.R_BL = PCI_DEVFN;
+			M.x86.R_AH = 0x00;
+			return;
+		}
+		break;
+	case 0x03:	/* find class code */
+		class = cfg[9] | cfg[10] << 8 | cfg[11] << 16;
+		if (M.x86.R_SI == 0 && (M.x86.R_ECX & 0xffffff) == class) {
+			M.x86.R_BH = PCI_BUS;
+			M.x86.R_BL = PCI_DEVFN;
+			M.x86.R_AH = 0x00;
+			return;
+		}
+		break;
+	case 0x08:
+		M.x86.R_CL = cfg_read(bus, devfn, M.x86.R_DI, 1);
+		M.x86.R_AH = 0x00;
+		return;
+	case 0x09:
+		M.x86.R_CX = cfg_read(bus, devfn, M.x86.R_DI, 2);
+		M.x86.R_AH = 0x00;
+		return;
+	case 0x0a:
+		M.x86.R_ECX = cfg_read(bus, devfn, M.x86.R_DI, 4);
+		M.x86.R_AH = 0x00;
+		return;
+	case 0x0b:
+		cfg_write(bus, devfn, M.x86.R_DI, M.x86.R_CL, 1);
+		M.x86.R_AH = 0x00;
+		return;
+	case 0x0c:
+		cfg_write(bus, devfn, M.x86.R_DI, M.x86.R_CX, 2);
+		M.x86.R_AH = 0x00;
+		return;
+	case 0x0d:
+		cfg_write(bus, devfn, M.x86.R_DI, M.x86.R_ECX, 4);
+		M.x86.R_AH = 0x00;
+		return;
+	default:
+		M.x86.R_AH = 0x81;	/* function not supported */
+		SET_FLAG(F_CF);
+		return;
+	}
+	M.x86.R_AH = 0x86;		/* device not found */
+	SET_FLAG(F_CF);
+}
+
+/* Register traces */
+
+static void get_regs(struct trace_regs *r)
+{
+	memset(r, 0, sizeof(*r));
+	r->eax = M.x86.R_EAX;
+	r->ebx = M.x86.R_EBX;
+	r->ecx = M.x86.R_ECX;
+	r->edx = M.x86.R_EDX;
+	r->esi = M.x86.R_ESI;
+	r->edi = M.x86.R_EDI;
+	r->ebp = M.x86.R_EBP;
+	r->esp = M.x86.R_ESP;
+	r->eip = M.x86.R_EIP;
+	r->flags = M.x86.R_EFLG;
+	r->cs = M.x86.R_CS;
+	r->ds = M.x86.R_DS;
+	r->es = M.x86.R_ES;
+	r->ss = M.x86.R_SS;
+	r->fs = M.x86.R_FS;
+	r->gs = M.x86.R_GS;
+}
+
+static void print_regs(const char *name, const struct trace_regs *r)
+{
+	fprintf(stderr, "  %-6s %04x:%08x eax %08x ebx %08x ecx %08x edx %08x\n"
+		"         esi %08x edi %08x ebp %08x esp %08x flags %08x\n"
+		"         ds %04x es %04x ss %04x fs %04x gs %04x\n",
+		name, r->cs, r->eip, r->eax, r->ebx, r->ecx, r->edx,
+		r->esi, r->edi, r->ebp, r->esp, r->flags,
+		r->ds, r->es, r->ss, r->fs, r->gs);
+}
+
+/*
+ * Called before every instruction. Writes the state to the trace, or
+ * compares it with the next state of the other emulator. Only the first
+ * few differences are printed, the run stops at the first one.
+ */
+static void trace_step(u8 op1)
+{
+	struct trace_regs mine, theirs;
+
+	get_regs(&mine);
+	if (trace_out) {
+		fwrite(&mine, sizeof(mine), 1, trace_out);
+		return;
+	}
+	if (fread(&theirs, sizeof(theirs), 1, trace_in) != 1) {
+		fprintf(stderr, "Trace ends before instruction %llu.\n",
+			instructions);
+		mismatches++;
+		X86EMU_halt_sys();
+		return;
+	}
+	if (!memcmp(&mine, &theirs, sizeof(mine)))
+		return;
+	fprintf(stderr, "Register state differs before instruction %llu "
+		"(opcode %02x):\n", instructions, op1);
+	print_regs("this", &mine);
+	print_regs("other", &theirs);
+	mismatches++;
+	X86EMU_halt_sys();
+}
+
+/* Instruction counting */
+
+static void count_op(u8 op1)
+{
+	op_count[op1]++;
+	if (trace_out || trace_in)
+		trace_step(op1);
+	if (++instructions == max_instructions)
+		X86EMU_halt_sys();
+	orig_optab[op1](op1);
+}
+
+static void count_op2(u8 op2)
+{
+	op2_count[op2]++;
+	orig_optab2[op2](op2);
+}
+
+static void hook_optabs(void)
+{
+	int i;
+
+	for (i = 0; i < 256; i++) {
+		orig_optab[i] = x86emu_optab[i];
+		x86emu_optab[i] = count_op;
+		orig_optab2[i] = x86emu_optab2[i];
+		x86emu_optab2[i] = count_op2;
+	}
+}
+
+/* Setup like YABEL's biosemu() */
+
+static void setup_machine(const u8 *rom, size_t rom_size)
+{
+	static const struct {
+		u8 num;
+		u32 vector;
+	} default_vectors[] = {
+		{ 0x10, 0xf000f065 }, { 0x11, 0xf000f84d },
+		{ 0x12, 0xf000f841 }, { 0x13, 0xf000ec59 },
+		{ 0x14, 0xf000e739 }, { 0x15, 0xf000f859 },
+		{ 0x16, 0xf000e82e }, { 0x17, 0xf000efd2 },
+		{ 0x1a, 0xf000fe6e },
+	};
+	X86EMU_intrFuncs intr_funcs[256];
+	size_t i;
+
+	memset(mem, 0xf4, MEM_SIZE);		/* HLT everywhere */
+	memset(mem, 0, 0x500);			/* IVT + BDA */
+	memcpy(mem + (ROM_SEGMENT << 4), rom, rom_size);
+	X86EMU_setMemBase(mem, MEM_SIZE);
+
+	/* every default handler is a single IRET */
+	for (i = 0; i < sizeof(default_vectors) / sizeof(default_vectors[0]);
+	     i++) {
+		u32 v = default_vectors[i].vector;
+		mem_wrl(default_vectors[i].num * 4, v);
+		mem_wrb((v >> 16 << 4) + (v & 0xffff), 0xcf);
+	}
+	mem_wrw(0x413, 640);				/* base memory in KB */
+	mem_wrw(0x40e, EBDA_SEGMENT);
+	memset(mem + (EBDA_SEGMENT << 4), 0, 0x400);
+	mem_wrw(EBDA_SEGMENT << 4, 1);			/* EBDA size in KB */
+	memcpy(mem + 0xffff5, "06/11/99", 8);
+	memcpy(mem + 0xfffd9, "PCI_ISA", 7);
+	mem[0xffffe] = 0xfc;				/* IBM AT */
+
+	for (i = 0; i < 6; i++) {
+		free(bars[i].data);
+		bars[i].data = NULL;
+		if (bars[i].size && !(bars[i].flags & 1))
+			bars[i].data = calloc(1, bars[i].size);
+	}
+	cfg_init(rom);
+	memset(ports, 0, sizeof(ports));
+	cf8 = 0;
+
+	memset(intr_funcs, 0, sizeof(intr_funcs));
+	intr_funcs[0x1a] = int1a_handler;
+	X86EMU_setupIntrFuncs(intr_funcs);
+	X86EMU_setupPioFuncs(&pio_funcs);
+#if OPROMBENCH_YABEL
+	taa_init();
+#endif
+	X86EMU_setupMemFuncs(&mem_funcs);
+
+	memset(&M.x86, 0, sizeof(M.x86));
+	M.x86.R_AH = PCI_BUS;
+	M.x86.R_AL = PCI_DEVFN;
+	M.x86.R_DX = 0x80;
+	M.x86.R_EIP = 3;
+	M.x86.R_CS = ROM_SEGMENT;
+	M.x86.R_SS = STACK_SEGMENT;
+	M.x86.R_SP = STACK_START_OFFSET;
+	M.x86.R_DS = DATA_SEGMENT;
+
+	/* a far return from the ROM lands on a HLT */
+	push_word(0xf4f4);
+	push_word(M.x86.R_SS);
+	push_word(M.x86.R_SP + 2);
+}
+
+/* Reporting */
+
+static void print_top(const char *title, const unsigned long long *count,
+		      int n, int entries, const char *fmt)
+{
+	int i, j, best;
+	char *done = calloc(entries, 1);
+
+	if (!done)
+		return;
+	printf("\n%s\n", title);
+	for (i = 0; i < n; i++) {
+		best = -1;
+		for (j = 0; j < entries; j++)
+			if (!done[j] && count[j] &&
+			    (best < 0 || count[j] > count[best]))
+				best = j;
+		if (best < 0)
+			break;
+		done[best] = 1;
+		printf(fmt, best);
+		printf("  %14llu  %5.1f%%\n", count[best],
+		       instructions ? 100.0 * count[best] / instructions : 0);
+	}
+	free(done);
+}
+
+static void print_ports(int n)
+{
+	static unsigned long long total[0x10000];
+	int i;
+
+	for (i = 0; i < 0x10000; i++)
+		total[i] = port_reads[i] + port_writes[i];
+	print_top("I/O ports (reads + writes):", total, n, 0x10000,
+		  "  %04x   ");
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [-n max_instructions] [-r runs] [-t top] "
+		"[-c other | -T] rom.bin\n"
+		"\n"
+		"  -n  stop after this many instructions (default: unlimited)\n"
+		"  -r  run the ROM this many times, report the fastest run\n"
+		"  -t  number of histogram entries to show (default 20, "
+		"0 to disable)\n"
+		"  -c  run the ROM in the bench binary 'other' as well and\n"
+		"      compare the registers before every instruction\n"
+		"  -T  write the register trace to stdout, used by -c\n", name);
+	exit(1);
+}
+
+static FILE *start_other(const char *other, const char *rom)
+{
+	char cmd[4096];
+	FILE *f;
+
+	if (max_instructions)
+		snprintf(cmd, sizeof(cmd), "'%s' -T -n %llu '%s'", other,
+			 max_instructions, rom);
+	else
+		snprintf(cmd, sizeof(cmd), "'%s' -T '%s'", other, rom);
+	f = popen(cmd, "r");
+	if (!f)
+		fprintf(stderr, "Couldn't run %s: %s\n", other,
+			strerror(errno));
+	return f;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+	FILE *f;
+	u8 *rom;
+	long rom_size;
+	const char *other = NULL;
+	int opt, runs = 1, top = 20, run;
+	double start, best = 0;
+
+	while ((opt = getopt(argc, argv, "c:n:r:t:Th")) != -1) {
+		switch (opt) {
+		case 'n':
+			max_instructions = strtoull(optarg, NULL, 0);
+			break;
+		case 'r':
+			runs = atoi(optarg);
+			break;
+		case 't':
+			top = atoi(optarg);
+			break;
+		case 'c':
+			other = optarg;
+			break;
+		case 'T':
+			trace_out = stdout;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (optind != argc - 1 || runs < 1 || (other && trace_out))
+		usage(argv[0]);
+	if (other || trace_out)
+		runs = 1;
+
+	f = fopen(argv[optind], "rb");
+	if (!f) {
+		fprintf(stderr, "%s: %s\n", argv[optind], strerror(errno));
+		return 1;
+	}
+	fseek(f, 0, SEEK_END);
+	rom_size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	if (rom_size < 0x1a || rom_size > 0x10000) {
+		fprintf(stderr, "Bad ROM size %ld.\n", rom_size);
+		return 1;
+	}
+	rom = malloc(rom_size);
+	mem = malloc(MEM_SIZE);
+	if (!rom || !mem || fread(rom, rom_size, 1, f) != 1) {
+		fprintf(stderr, "Couldn't read %s.\n", argv[optind]);
+		return 1;
+	}
+	fclose(f);
+	if (rom[0] != 0x55 || rom[1] != 0xaa ||
+	    (rom[0x18] | rom[0x19] << 8) + 0x10 > rom_size) {
+		fprintf(stderr, "No valid option ROM header.\n");
+		return 1;
+	}
+
+	if (other) {
+		trace_in = start_other(other, argv[optind]);
+		if (!trace_in)
+			return 1;
+	}
+
+	hook_optabs();
+	for (run = 0; run < runs; run++) {
+		memset(op_count, 0, sizeof(op_count));
+		memset(op2_count, 0, sizeof(op2_count));
+		memset(port_reads, 0, sizeof(port_reads));
+		memset(port_writes, 0, sizeof(port_writes));
+		unmapped_accesses = 0;
+		instructions = 0;
+
+		setup_machine(rom, rom_size);
+		start = now();
+		X86EMU_exec();
+		start = now() - start;
+		if (run == 0 || start < best)
+			best = start;
+	}
+
+	if (trace_out)
+		return fflush(trace_out) ? 1 : 0;
+	if (trace_in) {
+		struct trace_regs extra;
+
+		if (!mismatches &&
+		    fread(&extra, sizeof(extra), 1, trace_in) == 1) {
+			fprintf(stderr, "Trace of %s continues after "
+				"instruction %llu.\n", other, instructions);
+			mismatches++;
+		}
+		pclose(trace_in);
+	}
+
+	printf("Exit status:        %04x (CS:IP %04x:%04x)\n",
+	       M.x86.R_AX, M.x86.R_CS, M.x86.R_IP);
+	if (max_instructions && instructions >= max_instructions)
+		printf("Stopped after the instruction limit.\n");
+	printf("Instructions:       %llu\n", instructions);
+	printf("Time:               %.3f ms\n", best * 1000);
+	printf("Instructions/s:     %.0f\n", instructions / best);
+	printf("Unmapped accesses:  %llu\n", unmapped_accesses);
+
+	if (top > 0) {
+		print_top("Opcodes (prefixes count as instructions):",
+			  op_count, top, 256, "  %02x     ");
+		print_top("Two-byte opcodes:", op2_count, top, 256,
+			  "  0f %02x  ");
+		print_ports(top);
+	}
+	if (other) {
+		printf("\nCompared with %s: %s\n", other,
+		       mismatches ? "DIFFERENT" : "same register state "
+		       "before every instruction");
+		return mismatches ? 1 : 0;
+	}
+	return 0;
+}
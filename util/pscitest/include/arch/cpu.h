@@ -0,0 +1,43 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Host replacement for the arm64 cpu.h. Every CPU is a thread of the test,
+ * which also provides the functions declared here.
+ */
+
+#ifndef __ARCH_CPU_H__
+#define __ARCH_CPU_H__
+
+#include <stdint.h>
+#include <arch/mpidr.h>
+
+struct cpu_action {
+	void (*run)(void *arg);
+	void *arg;
+};
+
+struct cpu_info {
+	unsigned int id;
+	uint64_t mpidr;
+};
+
+struct cpu_info *cpu_info(void);
+
+int arch_run_on_cpu(unsigned int cpu, struct cpu_action *action);
+int arch_run_on_cpu_async(unsigned int cpu, struct cpu_action *action);
+int arch_run_on_all_cpus_async(struct cpu_action *action);
+
+#endif
@@ -0,0 +1,32 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/* The system registers psci.c and mpidr.h read, as seen by the test. */
+
+#ifndef __ARCH_LIB_HELPERS_H__
+#define __ARCH_LIB_HELPERS_H__
+
+#include <stdint.h>
+
+#define SCR_HVC_ENABLE	(1 << 8)
+
+static inline uint64_t raw_read_scr_el3(void)
+{
+	return 0;
+}
+
+uint64_t raw_read_mpidr_el1(void);
+
+#endif
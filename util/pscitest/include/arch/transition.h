@@ -0,0 +1,45 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Host replacement for the exception level transition library. Entering
+ * the OS is modelled by the test, see transition_with_entry() there.
+ */
+
+#ifndef __ARCH_TRANSITION_H__
+#define __ARCH_TRANSITION_H__
+
+#include <stdint.h>
+
+#define EL1		1
+#define EL2		2
+#define SPSR_USE_H	1
+
+struct elx_state {
+	uint64_t spsr;
+};
+
+struct exc_state {
+	struct elx_state elx;
+};
+
+static inline uint8_t get_eret_el(uint8_t el, uint8_t l_or_h)
+{
+	return el << 2 | l_or_h;
+}
+
+void transition_with_entry(void *entry, void *arg, struct exc_state *exc_state);
+
+#endif
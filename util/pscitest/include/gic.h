@@ -0,0 +1,29 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/* The GIC is not modelled, the test has no interrupts. */
+
+#ifndef PSCITEST_GIC_H
+#define PSCITEST_GIC_H
+
+static inline void gic_enable(void)
+{
+}
+
+static inline void gic_disable(void)
+{
+}
+
+#endif
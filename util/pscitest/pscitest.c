@@ -0,0 +1,421 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Host stress test for the PSCI node locking in secmon/psci.c.
+ *
+ * Every CPU of a two cluster system is a thread. The CPUs keep turning
+ * each other on, turning themselves off and entering standby. Powering
+ * off parks the thread until another CPU turns it on again, at which
+ * point it jumps back into its loop like a CPU entering the OS.
+ *
+ * The SoC's prepare() checks that the nodes psci.c claims to hold are not
+ * held by any other CPU and that the chosen ancestor is the right one for
+ * the states found in the tree. In the end every node has to be on.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <arch/cpu.h>
+#include <arch/psci.h>
+#include <arch/transition.h>
+#include "../../src/arch/arm64/armv8/secmon/secmon.h"
+
+#define NUM_CLUSTERS	2
+#define CLUSTER_CORES	4
+#define NUM_CPUS	(NUM_CLUSTERS * CLUSTER_CORES)
+#define TEST_OPS	1000000
+
+struct test_cpu {
+	struct cpu_info info;
+	pthread_t thread;
+	/* Where the CPU lands when it enters the OS. */
+	jmp_buf os_entry;
+	/* Action queued by arch_run_on_cpu_async(). */
+	struct cpu_action action;
+	int pending;
+	/* Set while the CPU is off or on its way there. */
+	int parked;
+	unsigned int seed;
+};
+
+static struct test_cpu cpus[NUM_CPUS];
+static __thread struct test_cpu *self;
+static int (*psci_handler)(struct smc_call *);
+static int stop;
+static int running;
+static int failures;
+static int in_prepare;
+static int max_in_prepare;
+static unsigned long transitions;
+static struct psci_node *root;
+
+static void fail(const char *what)
+{
+	fprintf(stderr, "cpu %u: %s\n", self->info.id, what);
+	__atomic_add_fetch(&failures, 1, __ATOMIC_RELAXED);
+}
+
+/* Stands in for the OS entry point passed to CPU_ON and CPU_SUSPEND. */
+static void os_entry(void)
+{
+}
+
+struct cpu_info *cpu_info(void)
+{
+	return &self->info;
+}
+
+uint64_t raw_read_mpidr_el1(void)
+{
+	return self->info.mpidr;
+}
+
+int arch_run_on_cpu(unsigned int cpu, struct cpu_action *action)
+{
+	if (&cpus[cpu] != self) {
+		fail("synchronous action for another CPU");
+		return -1;
+	}
+	action->run(action->arg);
+	return 0;
+}
+
+int arch_run_on_cpu_async(unsigned int cpu, struct cpu_action *action)
+{
+	struct test_cpu *c = &cpus[cpu];
+
+	if (__atomic_load_n(&c->pending, __ATOMIC_ACQUIRE))
+		return -1;
+	c->action = *action;
+	__atomic_store_n(&c->pending, 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+int arch_run_on_all_cpus_async(struct cpu_action *action)
+{
+	struct test_cpu *saved = self;
+	int i;
+
+	for (i = 0; i < NUM_CPUS; i++) {
+		self = &cpus[i];
+		action->run(action->arg);
+	}
+	self = saved;
+	return 0;
+}
+
+void secmon_wait_for_action(void)
+{
+	struct cpu_action action;
+
+	while (!__atomic_load_n(&self->pending, __ATOMIC_ACQUIRE))
+		sched_yield();
+	action = self->action;
+	__atomic_store_n(&self->pending, 0, __ATOMIC_RELEASE);
+
+	action.run(action.arg);
+	fail("action returned");
+	abort();
+}
+
+void transition_with_entry(void *entry, void *arg, struct exc_state *exc_state)
+{
+	if (entry != (void *)&os_entry || (uintptr_t)arg != self->info.mpidr)
+		fail("entered the OS with the wrong entry point");
+	longjmp(self->os_entry, 1);
+}
+
+int smc_register_range(uint32_t min, uint32_t max, int (*h)(struct smc_call *))
+{
+	psci_handler = h;
+	return 0;
+}
+
+void psci_soc_init(uintptr_t cpu_on_entry)
+{
+}
+
+static size_t children_at_level(int parent_level, uint64_t mpidr)
+{
+	switch (parent_level) {
+	case PSCI_AFFINITY_ROOT:
+	case PSCI_AFFINITY_LEVEL_3:
+		return 1;
+	case PSCI_AFFINITY_LEVEL_2:
+		return NUM_CLUSTERS;
+	case PSCI_AFFINITY_LEVEL_1:
+		return CLUSTER_CORES;
+	default:
+		return 0;
+	}
+}
+
+/* Are all children of n's parent but n itself off? */
+static int siblings_off(const struct psci_node *n)
+{
+	const struct psci_node *p = psci_node_parent(n);
+	size_t i;
+
+	for (i = 0; i < p->children.num; i++)
+		if (&p->children.nodes[i] != n &&
+		    p->children.nodes[i].state != PSCI_STATE_OFF)
+			return 0;
+	return 1;
+}
+
+static void check_ancestor(struct psci_cmd *cmd)
+{
+	struct psci_node *e = cmd->target;
+	struct psci_node *a = cmd->ancestor;
+	struct psci_node *end = psci_node_parent(a);
+	struct psci_node *n;
+
+	if (e->state != (cmd->type == PSCI_CMD_ON ? PSCI_STATE_OFF :
+						     PSCI_STATE_ON))
+		fail("target in the wrong state");
+
+	if (cmd->type == PSCI_CMD_OFF) {
+		/* Nodes go off with their last child, and no sooner. */
+		for (n = e; n != a; n = psci_node_parent(n))
+			if (!siblings_off(n))
+				fail("node turned off with children on");
+		if (end != NULL && siblings_off(a))
+			fail("last child off but parent left on");
+		return;
+	}
+
+	/* Nodes that are off come on with their first child. */
+	for (n = psci_node_parent(e); n != end; n = psci_node_parent(n))
+		if (n->state != PSCI_STATE_OFF)
+			fail("node turned on twice");
+	if (end != NULL && end->state == PSCI_STATE_OFF)
+		fail("node turned on below a node that is off");
+}
+
+/* Mark or unmark the nodes psci.c says it holds, from target upwards. */
+static void claim_nodes(struct psci_cmd *cmd, int inc)
+{
+	struct psci_node *end = psci_node_parent(cmd->ancestor);
+	struct psci_node *n;
+
+	for (n = cmd->target; n != NULL; n = psci_node_parent(n)) {
+		if (__atomic_fetch_add(&n->soc_state, inc, __ATOMIC_RELAXED) !=
+		    (inc > 0 ? 0 : 1))
+			fail("node held by two CPUs");
+		if (n == end)
+			break;
+	}
+}
+
+static int cmd_prepare(struct psci_cmd *cmd)
+{
+	int cur, max;
+	volatile int i;
+
+	claim_nodes(cmd, 1);
+	check_ancestor(cmd);
+
+	for (root = cmd->target; !psci_root_node(root);
+	     root = psci_node_parent(root))
+		;
+
+	cur = __atomic_add_fetch(&in_prepare, 1, __ATOMIC_RELAXED);
+	max = __atomic_load_n(&max_in_prepare, __ATOMIC_RELAXED);
+	while (cur > max && !__atomic_compare_exchange_n(&max_in_prepare, &max,
+				cur, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+
+	/* Keep the nodes a while, so other CPUs can run into them. */
+	for (i = 0; i < 100; i++)
+		;
+
+	__atomic_sub_fetch(&in_prepare, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&transitions, 1, __ATOMIC_RELAXED);
+	claim_nodes(cmd, -1);
+	return PSCI_RET_SUCCESS;
+}
+
+static int cmd_commit(struct psci_cmd *cmd)
+{
+	/* Powered off until another CPU turns this one on. */
+	if (cmd->type == PSCI_CMD_OFF)
+		psci_cpu_entry();
+
+	/* Standby wakes up right away. */
+	return PSCI_RET_SUCCESS;
+}
+
+struct psci_soc_ops soc_psci_ops = {
+	.children_at_level = &children_at_level,
+	.cmd_prepare = &cmd_prepare,
+	.cmd_commit = &cmd_commit,
+};
+
+static int smc(uint32_t func, uint64_t arg0, uint64_t arg1, uint64_t arg2)
+{
+	struct smc_call call = {
+		.args = { func, arg0, arg1, arg2 },
+	};
+
+	psci_handler(&call);
+	return (int32_t)call.results[0];
+}
+
+/* Like an OS, only turn on CPUs that were turned off before. */
+static void cpu_on(struct test_cpu *c)
+{
+	int ret;
+
+	if (!__atomic_exchange_n(&c->parked, 0, __ATOMIC_ACQ_REL))
+		return;
+
+	/* Until it actually got to turning itself off. */
+	while ((ret = smc(PSCI_CPU_ON64, c->info.mpidr, (uintptr_t)&os_entry,
+			  c->info.mpidr)) == PSCI_RET_ALREADY_ON)
+		sched_yield();
+	if (ret != PSCI_RET_SUCCESS)
+		fail("CPU_ON failed");
+}
+
+static void cpu_off(void)
+{
+	__atomic_store_n(&self->parked, 1, __ATOMIC_RELEASE);
+	smc(PSCI_CPU_OFF32, 0, 0, 0);
+	fail("CPU_OFF returned");
+}
+
+static void cpu_standby(void)
+{
+	uint32_t power_state = PSCI_POWER_STATE_TYPE_STANDBY <<
+				PSCI_0_2_POWER_STATE_TYPE_SHIFT;
+
+	if (smc(PSCI_CPU_SUSPEND64, power_state, (uintptr_t)&os_entry,
+		self->info.mpidr) != PSCI_RET_SUCCESS)
+		fail("CPU_SUSPEND failed");
+}
+
+static void random_op(void)
+{
+	switch (rand_r(&self->seed) % 4) {
+	case 0:
+	case 1:
+		cpu_on(&cpus[rand_r(&self->seed) % NUM_CPUS]);
+		break;
+	case 2:
+		cpu_standby();
+		break;
+	default:
+		/* The boot CPU stays on to end the test. */
+		if (self != &cpus[0])
+			cpu_off();
+		break;
+	}
+}
+
+static void *cpu_thread(void *arg)
+{
+	int i;
+
+	self = arg;
+
+	/* All but the boot CPU start out off. */
+	if (!setjmp(self->os_entry) && self != &cpus[0])
+		psci_cpu_entry();
+
+	if (self != &cpus[0]) {
+		while (!__atomic_load_n(&stop, __ATOMIC_ACQUIRE))
+			random_op();
+		__atomic_sub_fetch(&running, 1, __ATOMIC_RELEASE);
+		return NULL;
+	}
+
+	for (i = 0; i < TEST_OPS; i++)
+		random_op();
+	__atomic_store_n(&stop, 1, __ATOMIC_RELEASE);
+
+	/* Bring everyone back so they can see the test is over. */
+	while (__atomic_load_n(&running, __ATOMIC_ACQUIRE) > 1)
+		for (i = 1; i < NUM_CPUS; i++)
+			cpu_on(&cpus[i]);
+	return NULL;
+}
+
+static void check_tree(const struct psci_node *n)
+{
+	size_t i;
+
+	if (n->state != PSCI_STATE_ON)
+		fail("node left off");
+	if (n->level == PSCI_AFFINITY_LEVEL_0)
+		return;
+	for (i = 0; i < n->children.num; i++)
+		check_tree(&n->children.nodes[i]);
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+	double start;
+	int i;
+
+	for (i = 0; i < NUM_CPUS; i++) {
+		cpus[i].info.id = i;
+		cpus[i].info.mpidr = mpidr_mask(0, 0, i / CLUSTER_CORES,
+						i % CLUSTER_CORES);
+		cpus[i].seed = i + 1;
+		cpus[i].parked = i != 0;
+	}
+
+	self = &cpus[0];
+	psci_init(0);
+	if (psci_handler == NULL) {
+		fprintf(stderr, "PSCI did not initialize\n");
+		return 1;
+	}
+
+	start = now();
+	running = NUM_CPUS;
+	for (i = 0; i < NUM_CPUS; i++)
+		pthread_create(&cpus[i].thread, NULL, cpu_thread, &cpus[i]);
+	for (i = 0; i < NUM_CPUS; i++)
+		pthread_join(cpus[i].thread, NULL);
+
+	if (root == NULL) {
+		fprintf(stderr, "No transitions\n");
+		return 1;
+	}
+	check_tree(root);
+
+	printf("%lu transitions on %d CPUs in %.3f s, up to %d in parallel\n",
+	       transitions, NUM_CPUS, now() - start, max_in_prepare);
+	if (failures) {
+		fprintf(stderr, "%d failure(s)\n", failures);
+		return 1;
+	}
+	printf("PSCI tests passed\n");
+	return 0;
+}
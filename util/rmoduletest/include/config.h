@@ -0,0 +1,24 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/* Build configuration for rmodule.c on the host: no stage loading. */
+
+#ifndef RMODULETEST_CONFIG_H
+#define RMODULETEST_CONFIG_H
+
+#define CONFIG_DYNAMIC_CBMEM 0
+#define CONFIG_RELOCATABLE_MODULES 0
+
+#endif
@@ -0,0 +1,240 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Host test and benchmark for the packed rmodule relocations.
+ *
+ * Random programs with random relocation sets are turned into a version 1
+ * rmodule with a flat relocation array and a version 2 rmodule whose
+ * relocations are packed by rmodtool's encoder. Both are loaded with
+ * src/lib/rmodule.c at a random address and must produce byte identical
+ * images. Streams that are cut short or point outside the program must be
+ * rejected. The benchmark then times both on a ramstage sized program.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <rmodule.h>
+#include "../cbfstool/rmodule.h"
+
+#define LINK_ADDR	0x100000
+#define MAX_WORDS	65536
+#define TEST_ROUNDS	500
+#define BENCH_WORDS	65536
+#define BENCH_RELOCS	12000
+#define BENCH_LOOPS	200
+
+static uintptr_t program[MAX_WORDS];
+static Elf64_Addr relocs[MAX_WORDS];
+static uintptr_t flat[MAX_WORDS];
+static uintptr_t load[MAX_WORDS + 1024] __attribute__((aligned(4096)));
+static uintptr_t image[MAX_WORDS];
+static int failures;
+
+void arch_program_segment_loaded(uintptr_t start, size_t size)
+{
+}
+
+static void fail(const char *what, int round)
+{
+	fprintf(stderr, "round %d: %s\n", round, what);
+	failures++;
+}
+
+/* Sorted unique relocations, a mix of lone pointers and pointer tables. */
+static size_t random_relocs(size_t words, size_t max)
+{
+	size_t n = 0, w = rand() % 8, run;
+
+	while (n < max && w < words) {
+		run = rand() % 4 ? 1 : 1 + rand() % 40;
+		for (; run && n < max && w < words; run--, w++)
+			relocs[n++] = LINK_ADDR + w * sizeof(uintptr_t);
+		w += rand() % 16 ? rand() % 16 : rand() % 1024;
+	}
+	return n;
+}
+
+/* Lay out an rmodule of either version in 'blob'. */
+static void *make_rmodule(struct buffer *blob, int version, size_t words,
+			  size_t nrelocs)
+{
+	struct rmodule_header *hdr;
+	size_t payload = words * sizeof(uintptr_t);
+	size_t relocs_size, i;
+	struct buffer out;
+
+	if (version == RMODULE_VERSION_2)
+		relocs_size = rmodule_pack_relocs(NULL, relocs, nrelocs,
+						  LINK_ADDR, sizeof(uintptr_t));
+	else
+		relocs_size = nrelocs * sizeof(uintptr_t);
+
+	buffer_create(blob, sizeof(*hdr) + payload + relocs_size, "rmodule");
+	hdr = (void *)blob->data;
+	memset(hdr, 0, sizeof(*hdr));
+	hdr->magic = RMODULE_MAGIC;
+	hdr->version = version;
+	hdr->payload_begin_offset = sizeof(*hdr);
+	hdr->payload_end_offset = sizeof(*hdr) + payload;
+	hdr->relocations_begin_offset = hdr->payload_end_offset;
+	hdr->relocations_end_offset = hdr->payload_end_offset + relocs_size;
+	hdr->module_link_start_address = LINK_ADDR;
+	hdr->module_program_size = payload;
+	hdr->module_entry_point = LINK_ADDR;
+	hdr->bss_begin = hdr->bss_end = LINK_ADDR + payload;
+	memcpy(&blob->data[sizeof(*hdr)], program, payload);
+
+	buffer_splice(&out, blob, hdr->relocations_begin_offset, relocs_size);
+	buffer_set_size(&out, 0);
+	if (version == RMODULE_VERSION_2) {
+		rmodule_pack_relocs(&out, relocs, nrelocs, LINK_ADDR,
+				    sizeof(uintptr_t));
+	} else {
+		for (i = 0; i < nrelocs; i++)
+			flat[i] = relocs[i];
+		memcpy(out.data, flat, relocs_size);
+	}
+	return hdr;
+}
+
+static int load_rmodule(void *blob, uintptr_t *dest)
+{
+	struct rmodule module;
+
+	if (rmodule_parse(blob, &module))
+		return -1;
+	return rmodule_load(dest, &module);
+}
+
+static void test_random(void)
+{
+	struct buffer v1, v2;
+	struct rmodule_header *hdr;
+	size_t words, nrelocs, i, offset;
+	int round;
+
+	for (round = 0; round < TEST_ROUNDS; round++) {
+		words = 1 + rand() % MAX_WORDS;
+		for (i = 0; i < words; i++)
+			program[i] = (uintptr_t)rand() << 16 ^ rand();
+		nrelocs = random_relocs(words, rand() % 2 ? words : 64);
+
+		make_rmodule(&v1, RMODULE_VERSION_1, words, nrelocs);
+		hdr = make_rmodule(&v2, RMODULE_VERSION_2, words, nrelocs);
+		if (v2.size > v1.size)
+			fail("packed relocations are larger", round);
+
+		/* Both at the same address, the image depends on it. */
+		offset = rand() % 1024;
+		if (load_rmodule(v1.data, &load[offset]))
+			fail("version 1 load failed", round);
+		memcpy(image, &load[offset], words * sizeof(uintptr_t));
+		if (load_rmodule(v2.data, &load[offset]))
+			fail("version 2 load failed", round);
+		else if (memcmp(image, &load[offset],
+				words * sizeof(uintptr_t)))
+			fail("images differ", round);
+
+		/* Cut the stream inside the last value. */
+		if (nrelocs) {
+			hdr->relocations_end_offset--;
+			if (!load_rmodule(v2.data, &load[offset]) &&
+			    (v2.data[hdr->relocations_end_offset - 1] & 0x80))
+				fail("truncated stream accepted", round);
+			hdr->relocations_end_offset++;
+		}
+
+		/* The last relocation must lie within the program. */
+		if (nrelocs) {
+			hdr->module_program_size = relocs[nrelocs - 1] -
+						   LINK_ADDR;
+			if (!load_rmodule(v2.data, &load[offset]))
+				fail("relocation past the end accepted", round);
+		}
+
+		buffer_delete(&v1);
+		buffer_delete(&v2);
+	}
+
+	/* Duplicates and unaligned relocations cannot be packed. */
+	relocs[0] = relocs[1] = LINK_ADDR;
+	if (rmodule_pack_relocs(NULL, relocs, 2, LINK_ADDR,
+				sizeof(uintptr_t)) >= 0)
+		fail("duplicate relocations packed", 0);
+	relocs[1] = LINK_ADDR + 1;
+	if (rmodule_pack_relocs(NULL, relocs, 2, LINK_ADDR,
+				sizeof(uintptr_t)) >= 0)
+		fail("unaligned relocation packed", 0);
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench(void)
+{
+	const size_t hdr_size = sizeof(struct rmodule_header);
+	struct buffer v1, v2;
+	size_t nrelocs;
+	double start;
+	int i;
+
+	memset(program, 0, sizeof(program));
+	nrelocs = random_relocs(BENCH_WORDS, BENCH_RELOCS);
+	make_rmodule(&v1, RMODULE_VERSION_1, BENCH_WORDS, nrelocs);
+	make_rmodule(&v2, RMODULE_VERSION_2, BENCH_WORDS, nrelocs);
+
+	printf("%zu relocs: %zu bytes flat, %zu bytes packed\n", nrelocs,
+	       nrelocs * sizeof(uintptr_t), v2.size - v1.size +
+	       nrelocs * sizeof(uintptr_t));
+
+	/* Loaded in place, so only the relocations are timed. */
+	start = now();
+	for (i = 0; i < BENCH_LOOPS; i++)
+		load_rmodule(v1.data, (void *)&v1.data[hdr_size]);
+	printf("version 1 relocation: %8.3f us\n",
+	       (now() - start) * 1e6 / BENCH_LOOPS);
+
+	start = now();
+	for (i = 0; i < BENCH_LOOPS; i++)
+		load_rmodule(v2.data, (void *)&v2.data[hdr_size]);
+	printf("version 2 relocation: %8.3f us\n",
+	       (now() - start) * 1e6 / BENCH_LOOPS);
+
+	buffer_delete(&v1);
+	buffer_delete(&v2);
+}
+
+int main(int argc, char **argv)
+{
+	srand(1);
+	test_random();
+	bench();
+
+	if (failures) {
+		fprintf(stderr, "%d failure(s)\n", failures);
+		return 1;
+	}
+	printf("rmodule tests passed\n");
+	return 0;
+}
@@ -1065,6 +1065,20 @@ struct basic_blocks {
 	int last_vertex;
 };
 #define MAX_PP_IF_DEPTH 63
+/* Compiler phases timed by -ftime-report */
+enum time_phase {
+	PHASE_PARSE,
+	PHASE_SSA,
+	PHASE_OPTIMIZE,
+	PHASE_ARCH,
+	PHASE_LIVENESS,
+	PHASE_INTERFERENCE,
+	PHASE_COALESCE,
+	PHASE_COLOR,
+	PHASE_REGALLOC,
+	PHASE_CODEGEN,
+	PHASE_COUNT,
+};
 struct compile_state {
 	struct compiler_state *compiler;
 	struct arch_state *arch;
@@ -1106,6 +1120,9 @@ struct compile_state {
 	struct triple *global_pool;
 	struct basic_blocks bb;
 	int functions_joined;
+	enum time_phase phase;
+	clock_t phase_start;
+	clock_t phase_time[PHASE_COUNT];
 };
 
 /* visibility global/local */
@@ -1396,6 +1413,7 @@ static void print_dominance_frontiers(struct compile_state *state,
 #define COMPILER_SIMPLIFY_LOGICAL          0x00004000
 #define COMPILER_SIMPLIFY_BITFIELD         0x00008000
 
+#define COMPILER_TIME_REPORT               0x20000000
 #define COMPILER_TRIGRAPHS                 0x40000000
 #define COMPILER_PP_ONLY                   0x80000000
 
@@ -1582,6 +1600,7 @@ static int append_undef(struct compiler_state *compiler, const char *str)
 static const struct compiler_flag romcc_flags[] = {
 	{ "trigraphs",                 COMPILER_TRIGRAPHS },
 	{ "pp-only",                   COMPILER_PP_ONLY },
+	{ "time-report",               COMPILER_TIME_REPORT },
 	{ "eliminate-inefectual-code", COMPILER_ELIMINATE_INEFECTUAL_CODE },
 	{ "simplify",                  COMPILER_SIMPLIFY },
 	{ "scc-transform",             COMPILER_SCC_TRANSFORM },
@@ -13565,6 +13584,9 @@ struct reg_block {
 	struct triple_reg_set *in;
 	struct triple_reg_set *out;
 	int vertex;
+	/* Liveness iteration stamps, see compute_variable_lifetimes */
+	unsigned visited;
+	unsigned changed;
 };
 static void setup_basic_blocks(struct compile_state *, struct basic_blocks *bb);
 static void analyze_basic_blocks(struct compile_state *state, struct basic_blocks *bb);
@@ -17609,23 +17631,47 @@ static struct reg_block *compute_variable_lifetimes(
 	struct compile_state *state, struct basic_blocks *bb)
 {
 	struct reg_block *blocks;
+	unsigned stamp;
 	int change;
 	blocks = xcmalloc(
 		sizeof(*blocks)*(bb->last_vertex + 1), "reg_block");
 	initialize_regblock(blocks, bb->last_block, 0);
+	/* Iterate to a fixed point, but only look at the successors
+	 * whose input set has changed since a block was last visited.
+	 * Nothing else can add to the block's sets, so the result and
+	 * the order of the sets is the same as when every block is
+	 * recomputed on every iteration.
+	 */
+	stamp = 0;
 	do {
 		int i;
 		change = 0;
 		for(i = 1; i <= bb->last_vertex; i++) {
 			struct block_set *edge;
 			struct reg_block *rb;
+			unsigned visited;
+			int rb_change;
 			rb = &blocks[i];
+			visited = rb->visited;
+			rb->visited = ++stamp;
+			rb_change = 0;
 			/* Add the all successor's input set to in */
 			for(edge = rb->block->edges; edge; edge = edge->next) {
-				change |= reg_in(state, blocks, rb, edge->member);
+				struct reg_block *suc;
+				suc = &blocks[edge->member->vertex];
+				if (visited && (suc->changed < visited)) {
+					continue;
+				}
+				rb_change |= reg_in(state, blocks, rb, edge->member);
+			}
+			/* Add use to in, the uses never change... */
+			if (!visited) {
+				rb_change |= use_in(state, rb);
 			}
-			/* Add use to in... */
-			change |= use_in(state, rb);
+			if (rb_change) {
+				rb->changed = stamp;
+			}
+			change |= rb_change;
 		}
 	} while(change);
 	return blocks;
@@ -18198,16 +18244,13 @@ struct live_range_def {
 	unsigned orig_id;
 };
 
-#define LRE_HASH_SIZE 2048
-struct lre_hash {
-	struct lre_hash *next;
-	struct live_range *left;
-	struct live_range *right;
-};
-
-
 struct reg_state {
-	struct lre_hash *hash[LRE_HASH_SIZE];
+	/* Interference bit matrix, the lower triangle is indexed by
+	 * live range number.  See lre_bit().
+	 */
+	unsigned long *lre_bits;
+	/* Edges are recycled instead of freed, there are a lot of them */
+	struct live_range_edge *free_edges;
 	struct reg_block *blocks;
 	struct live_range_def *lrd;
 	struct live_range *lr;
@@ -18416,65 +18459,73 @@ static void reg_inc_used(struct compile_state *state, char *used, int reg)
 	return;
 }
 
-static unsigned int hash_live_edge(
+#define LRE_BITS_PER_WORD (sizeof(unsigned long)*8)
+
+static size_t lre_bit(struct reg_state *rstate,
 	struct live_range *left, struct live_range *right)
 {
-	unsigned int hash, val;
-	unsigned long lval, rval;
-	lval = ((unsigned long)left)/sizeof(struct live_range);
-	rval = ((unsigned long)right)/sizeof(struct live_range);
-	hash = 0;
-	while(lval) {
-		val = lval & 0xff;
-		lval >>= 8;
-		hash = (hash *263) + val;
+	size_t lval, rval;
+	lval = left - rstate->lr;
+	rval = right - rstate->lr;
+	/* Ensure left < right */
+	if (lval > rval) {
+		size_t tmp;
+		tmp = lval;
+		lval = rval;
+		rval = tmp;
 	}
-	while(rval) {
-		val = rval & 0xff;
-		rval >>= 8;
-		hash = (hash *263) + val;
-	}
-	hash = hash & (LRE_HASH_SIZE - 1);
-	return hash;
+	return ((rval * (rval - 1)) / 2) + lval;
 }
 
-static struct lre_hash **lre_probe(struct reg_state *rstate,
+static int interfere(struct reg_state *rstate,
 	struct live_range *left, struct live_range *right)
 {
-	struct lre_hash **ptr;
-	unsigned int index;
-	/* Ensure left <= right */
-	if (left > right) {
-		struct live_range *tmp;
-		tmp = left;
-		left = right;
-		right = tmp;
+	size_t bit;
+	if (left == right) {
+		return 0;
 	}
-	index = hash_live_edge(left, right);
+	bit = lre_bit(rstate, left, right);
+	return (rstate->lre_bits[bit / LRE_BITS_PER_WORD] >>
+		(bit % LRE_BITS_PER_WORD)) & 1;
+}
 
-	ptr = &rstate->hash[index];
-	while(*ptr) {
-		if (((*ptr)->left == left) && ((*ptr)->right == right)) {
-			break;
-		}
-		ptr = &(*ptr)->next;
+static void set_interfere(struct reg_state *rstate,
+	struct live_range *left, struct live_range *right, int value)
+{
+	unsigned long mask;
+	size_t bit;
+	bit = lre_bit(rstate, left, right);
+	mask = 1UL << (bit % LRE_BITS_PER_WORD);
+	if (value) {
+		rstate->lre_bits[bit / LRE_BITS_PER_WORD] |= mask;
+	} else {
+		rstate->lre_bits[bit / LRE_BITS_PER_WORD] &= ~mask;
 	}
-	return ptr;
 }
 
-static int interfere(struct reg_state *rstate,
-	struct live_range *left, struct live_range *right)
+static struct live_range_edge *alloc_live_edge(struct reg_state *rstate)
 {
-	struct lre_hash **ptr;
-	ptr = lre_probe(rstate, left, right);
-	return ptr && *ptr;
+	struct live_range_edge *edge;
+	edge = rstate->free_edges;
+	if (edge) {
+		rstate->free_edges = edge->next;
+	} else {
+		edge = xmalloc(sizeof(*edge), "live_range_edge");
+	}
+	return edge;
+}
+
+static void free_live_edge(struct reg_state *rstate,
+	struct live_range_edge *edge)
+{
+	edge->node = 0;
+	edge->next = rstate->free_edges;
+	rstate->free_edges = edge;
 }
 
 static void add_live_edge(struct reg_state *rstate,
 	struct live_range *left, struct live_range *right)
 {
-	/* FIXME the memory allocation overhead is noticeable here... */
-	struct lre_hash **ptr, *new_hash;
 	struct live_range_edge *edge;
 
 	if (left == right) {
@@ -18490,27 +18541,22 @@ static void add_live_edge(struct reg_state *rstate,
 		left = right;
 		right = tmp;
 	}
-	ptr = lre_probe(rstate, left, right);
-	if (*ptr) {
+	if (interfere(rstate, left, right)) {
 		return;
 	}
 #if 0
 	fprintf(state->errout, "new_live_edge(%p, %p)\n",
 		left, right);
 #endif
-	new_hash = xmalloc(sizeof(*new_hash), "lre_hash");
-	new_hash->next  = *ptr;
-	new_hash->left  = left;
-	new_hash->right = right;
-	*ptr = new_hash;
+	set_interfere(rstate, left, right, 1);
 
-	edge = xmalloc(sizeof(*edge), "live_range_edge");
+	edge = alloc_live_edge(rstate);
 	edge->next   = left->edges;
 	edge->node   = right;
 	left->edges  = edge;
 	left->degree += 1;
 
-	edge = xmalloc(sizeof(*edge), "live_range_edge");
+	edge = alloc_live_edge(rstate);
 	edge->next    = right->edges;
 	edge->node    = left;
 	right->edges  = edge;
@@ -18521,21 +18567,16 @@ static void remove_live_edge(struct reg_state *rstate,
 	struct live_range *left, struct live_range *right)
 {
 	struct live_range_edge *edge, **ptr;
-	struct lre_hash **hptr, *entry;
-	hptr = lre_probe(rstate, left, right);
-	if (!hptr || !*hptr) {
+	if (!interfere(rstate, left, right)) {
 		return;
 	}
-	entry = *hptr;
-	*hptr = entry->next;
-	xfree(entry);
+	set_interfere(rstate, left, right, 0);
 
 	for(ptr = &left->edges; *ptr; ptr = &(*ptr)->next) {
 		edge = *ptr;
 		if (edge->node == right) {
 			*ptr = edge->next;
-			memset(edge, 0, sizeof(*edge));
-			xfree(edge);
+			free_live_edge(rstate, edge);
 			right->degree--;
 			break;
 		}
@@ -18544,23 +18585,13 @@ static void remove_live_edge(struct reg_state *rstate,
 		edge = *ptr;
 		if (edge->node == left) {
 			*ptr = edge->next;
-			memset(edge, 0, sizeof(*edge));
-			xfree(edge);
+			free_live_edge(rstate, edge);
 			left->degree--;
 			break;
 		}
 	}
 }
 
-static void remove_live_edges(struct reg_state *rstate, struct live_range *range)
-{
-	struct live_range_edge *edge, *next;
-	for(edge = range->edges; edge; edge = next) {
-		next = edge->next;
-		remove_live_edge(rstate, range, edge->node);
-	}
-}
-
 static void transfer_live_edges(struct reg_state *rstate,
 	struct live_range *dest, struct live_range *src)
 {
@@ -18584,8 +18615,8 @@ static void transfer_live_edges(struct reg_state *rstate,
  * degree(g, x) --- Return the degree of the node x in the graph g
  * neighbors(g, x, f) --- Apply function f to each neighbor of node x in the graph g
  *
- * Implement with a hash table && a set of adjcency vectors.
- * The hash table supports constant time implementations of add and interfere.
+ * Implement with a bit matrix && a set of adjcency vectors.
+ * The bit matrix supports constant time implementations of add and interfere.
  * The adjacency vectors support an efficient implementation of neighbors.
  */
 
@@ -18851,6 +18882,11 @@ static void initialize_live_ranges(
 	} while(ins != first);
 	rstate->ranges = i;
 
+	/* Allocate the interference bit matrix */
+	size = lre_bit(rstate, &rstate->lr[0], &rstate->lr[rstate->ranges + 1]);
+	size = (size / LRE_BITS_PER_WORD) + 1;
+	rstate->lre_bits = xcmalloc(size * sizeof(unsigned long), "lre_bits");
+
 	/* Make a second pass to handle achitecture specific register
 	 * constraints.
 	 */
@@ -20038,16 +20074,27 @@ static void ids_from_rstate(struct compile_state *state,
 
 static void cleanup_live_edges(struct reg_state *rstate)
 {
+	struct live_range_edge *edge, *next;
 	int i;
-	/* Free the edges on each node */
+	/* Free the edges on each node.  Every edge is freed from
+	 * both ends, so the adjacency lists don't need to be searched.
+	 */
 	for(i = 1; i <= rstate->ranges; i++) {
-		remove_live_edges(rstate, &rstate->lr[i]);
+		struct live_range *range = &rstate->lr[i];
+		for(edge = range->edges; edge; edge = next) {
+			next = edge->next;
+			set_interfere(rstate, range, edge->node, 0);
+			free_live_edge(rstate, edge);
+		}
+		range->edges = 0;
+		range->degree = 0;
 	}
 }
 
 static void cleanup_rstate(struct compile_state *state, struct reg_state *rstate)
 {
 	cleanup_live_edges(rstate);
+	xfree(rstate->lre_bits);
 	xfree(rstate->lrd);
 	xfree(rstate->lr);
 
@@ -20057,12 +20104,64 @@ static void cleanup_rstate(struct compile_state *state, struct reg_state *rstate
 	}
 	rstate->defs = 0;
 	rstate->ranges = 0;
+	rstate->lre_bits = 0;
 	rstate->lrd = 0;
 	rstate->lr = 0;
 	rstate->blocks = 0;
 }
 
 static void verify_consistency(struct compile_state *state);
+static const char *phase_names[PHASE_COUNT] = {
+	[PHASE_PARSE]        = "parse",
+	[PHASE_SSA]          = "ssa",
+	[PHASE_OPTIMIZE]     = "optimize",
+	[PHASE_ARCH]         = "arch instructions",
+	[PHASE_LIVENESS]     = "liveness",
+	[PHASE_INTERFERENCE] = "interference",
+	[PHASE_COALESCE]     = "coalescing",
+	[PHASE_COLOR]        = "coloring",
+	[PHASE_REGALLOC]     = "register allocation",
+	[PHASE_CODEGEN]      = "code generation",
+};
+
+/* Charge the time since the last phase switch to the current phase
+ * and start timing the next one.
+ */
+static void time_phase(struct compile_state *state, enum time_phase phase)
+{
+	clock_t now;
+	if (!(state->compiler->flags & COMPILER_TIME_REPORT)) {
+		return;
+	}
+	now = clock();
+	state->phase_time[state->phase] += now - state->phase_start;
+	state->phase = phase;
+	state->phase_start = now;
+}
+
+static void print_time_report(struct compile_state *state)
+{
+	clock_t total;
+	int i;
+	if (!(state->compiler->flags & COMPILER_TIME_REPORT)) {
+		return;
+	}
+	time_phase(state, state->phase);
+	total = 0;
+	for(i = 0; i < PHASE_COUNT; i++) {
+		total += state->phase_time[i];
+	}
+	fprintf(state->errout, "Execution times (seconds)\n");
+	for(i = 0; i < PHASE_COUNT; i++) {
+		fprintf(state->errout, " %-20s: %8.3f (%3.0f%%)\n",
+			phase_names[i],
+			(double)state->phase_time[i] / CLOCKS_PER_SEC,
+			total ? 100.0 * state->phase_time[i] / total : 0.0);
+	}
+	fprintf(state->errout, " %-20s: %8.3f\n", "TOTAL",
+		(double)total / CLOCKS_PER_SEC);
+}
+
 static void allocate_registers(struct compile_state *state)
 {
 	struct reg_state rstate;
@@ -20090,7 +20189,9 @@ static void allocate_registers(struct compile_state *state)
 		cleanup_rstate(state, &rstate);
 
 		/* Compute the variable lifetimes */
+		time_phase(state, PHASE_LIVENESS);
 		rstate.blocks = compute_variable_lifetimes(state, &state->bb);
+		time_phase(state, PHASE_REGALLOC);
 
 		/* Fix invalid mandatory live range coalesce conflicts */
 		correct_coalesce_conflicts(state, rstate.blocks);
@@ -20126,9 +20227,11 @@ static void allocate_registers(struct compile_state *state)
 			cleanup_live_edges(&rstate);
 
 			/* Compute the interference graph */
+			time_phase(state, PHASE_INTERFERENCE);
 			walk_variable_lifetimes(
 				state, &state->bb, rstate.blocks,
 				graph_ins, &rstate);
+			time_phase(state, PHASE_REGALLOC);
 
 			/* Display the interference graph if desired */
 			if (state->compiler->debug & DEBUG_INTERFERENCE) {
@@ -20139,7 +20242,9 @@ static void allocate_registers(struct compile_state *state)
 					print_interference_ins, &rstate);
 			}
 
+			time_phase(state, PHASE_COALESCE);
 			coalesced = coalesce_live_ranges(state, &rstate);
+			time_phase(state, PHASE_REGALLOC);
 
 			if (state->compiler->debug & DEBUG_COALESCING) {
 				fprintf(state->errout, "coalesced: %d\n", coalesced);
@@ -20207,7 +20312,9 @@ static void allocate_registers(struct compile_state *state)
 			}
 		}
 		/* Color the live_ranges */
+		time_phase(state, PHASE_COLOR);
 		colored = color_graph(state, &rstate);
+		time_phase(state, PHASE_REGALLOC);
 		rstate.passes++;
 	} while (!colored);
 
@@ -20219,6 +20326,12 @@ static void allocate_registers(struct compile_state *state)
 
 	/* Cleanup the temporary data structures */
 	cleanup_rstate(state, &rstate);
+	while(rstate.free_edges) {
+		struct live_range_edge *edge;
+		edge = rstate.free_edges;
+		rstate.free_edges = edge->next;
+		xfree(edge);
+	}
 
 	/* Display the new graph */
 	print_blocks(state, __func__, state->dbgout);
@@ -21576,6 +21689,7 @@ static void verify_consistency(struct compile_state *state) {}
 static void optimize(struct compile_state *state)
 {
 	/* Join all of the functions into one giant function */
+	time_phase(state, PHASE_SSA);
 	join_functions(state);
 
 	/* Dump what the instruction graph intially looks like */
@@ -21603,6 +21717,7 @@ static void optimize(struct compile_state *state)
 	verify_consistency(state);
 
 	/* Remove dead code */
+	time_phase(state, PHASE_OPTIMIZE);
 	eliminate_inefectual_code(state);
 	verify_consistency(state);
 
@@ -21619,6 +21734,7 @@ static void optimize(struct compile_state *state)
 	/* Select architecture instructions and an initial partial
 	 * coloring based on architecture constraints.
 	 */
+	time_phase(state, PHASE_ARCH);
 	transform_to_arch_instructions(state);
 	verify_consistency(state);
 
@@ -21633,6 +21749,7 @@ static void optimize(struct compile_state *state)
 	insert_mandatory_copies(state);
 	verify_consistency(state);
 
+	time_phase(state, PHASE_REGALLOC);
 	allocate_registers(state);
 	verify_consistency(state);
 
@@ -24870,6 +24987,7 @@ static void print_instructions(struct compile_state *state)
 
 static void generate_code(struct compile_state *state)
 {
+	time_phase(state, PHASE_CODEGEN);
 	generate_local_labels(state);
 	print_instructions(state);
 
@@ -24946,6 +25064,8 @@ static void compile(const char *filename,
 	state.compiler = compiler;
 	state.arch     = arch;
 	state.file = 0;
+	state.phase = PHASE_PARSE;
+	state.phase_start = clock();
 	for(i = 0; i < sizeof(state.token)/sizeof(state.token[0]); i++) {
 		memset(&state.token[i], 0, sizeof(state.token[i]));
 		state.token[i].tok = -1;
@@ -25040,6 +25160,7 @@ static void compile(const char *filename,
 	optimize(&state);
 
 	generate_code(&state);
+	print_time_report(&state);
 	if (state.compiler->debug) {
 		fprintf(state.errout, "done\n");
 	}
@@ -0,0 +1,108 @@
+#!/bin/bash
+#
+# Compile the romcc test corpus with two romcc binaries, compare the
+# generated assembly and report how long each of them took.
+#
+# usage: tests/compare.sh <old> [<new>]
+#
+# <old> and <new> are romcc binaries or git revisions to build romcc.c
+# from. Without <new>, romcc.c in the working tree is built. Both are
+# built with the same $CC and $CFLAGS. Run it from util/romcc, e.g.
+# "tests/compare.sh HEAD~1" to check the last change.
+#
+# Every source of the Makefile's test target is compiled with each set
+# of options in OPTIONS. The script fails if any output differs.
+
+OPTIONS=("-O" "-O2 -mmmx" "-O2 -mmmx -msse")
+ROMCC_OPTS="-fmax-allocation-passes=8 -Itests/include"
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:--g -Wall}
+
+if [ -z "$1" ] || [ ! -f tests/ldscript.ld ]; then
+	echo "usage: tests/compare.sh <old> [<new>], run from util/romcc"
+	exit 1
+fi
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+# Turn a binary, a git revision or nothing (the working tree) into the
+# path of a romcc binary.
+get_romcc() {
+	local name=$1 out=$2
+
+	if [ -n "$name" ] && [ -x "$name" ] && [ -f "$name" ]; then
+		echo "$name"
+		return
+	fi
+	if [ -n "$name" ]; then
+		git show "$name:./romcc.c" > "$out.c" || exit 1
+	else
+		cp romcc.c "$out.c"
+	fi
+	$CC $CFLAGS -o "$out" "$out.c" || exit 1
+	echo "$out"
+}
+
+old=$(get_romcc "$1" "$tmp/romcc-old") || exit 1
+new=$(get_romcc "$2" "$tmp/romcc-new") || exit 1
+
+srcs=$(make -s echo | sed -n 's/^TEST_SRCS=//p')
+if [ -z "$srcs" ]; then
+	echo "No test sources found."
+	exit 1
+fi
+# The assembly of these changes with the time of day.
+timed=$(grep -l '__DATE__\|__TIME__' $srcs)
+for src in $timed; do
+	echo "Not comparing the assembly of $src, it uses __DATE__/__TIME__."
+done
+
+now() {
+	date +%s%N
+}
+
+# Compile every source with one romcc and one set of options into $dir,
+# the assembly into .S files and the messages into .err files. Prints the
+# time it took in ms.
+run() {
+	local romcc=$1 opts=$2 dir=$3 src start
+
+	mkdir -p "$dir"
+	start=$(now)
+	for src in $srcs; do
+		ALLOC_CHECK_=2 "$romcc" $ROMCC_OPTS $opts \
+			-o "$dir/$(basename "$src" .c).S" "$src" \
+			> /dev/null 2> "$dir/$(basename "$src" .c).err"
+	done
+	echo $((($(now) - start) / 1000000))
+	# Some warnings print heap addresses, which change from run to run.
+	sed -i 's/0x[0-9a-f]\{8,\}/0x.../g' "$dir"/*.err
+	for src in $timed; do
+		rm -f "$dir/$(basename "$src" .c).S"
+	done
+}
+
+printf "%-20s %10s %10s %8s\n" "options" "old (ms)" "new (ms)" "outputs"
+status=0
+total_old=0
+total_new=0
+for i in "${!OPTIONS[@]}"; do
+	opts=${OPTIONS[$i]}
+	t_old=$(run "$old" "$opts" "$tmp/old$i")
+	t_new=$(run "$new" "$opts" "$tmp/new$i")
+	total_old=$((total_old + t_old))
+	total_new=$((total_new + t_new))
+	if diff -r "$tmp/old$i" "$tmp/new$i" > "$tmp/diff$i"; then
+		result=same
+	else
+		result=DIFFER
+		status=1
+		sed -n 's/^Files \(.*\) and .* differ$/  \1/p; s/^Only in /  only in /p' \
+			"$tmp/diff$i"
+	fi
+	printf "%-20s %10d %10d %8s\n" "$opts" "$t_old" "$t_new" "$result"
+done
+printf "%-20s %10d %10d\n" "total" "$total_old" "$total_new"
+
+exit $status
@@ -0,0 +1,206 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * Copyright 2015 Google Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Host test for spi_flash_update() in src/drivers/spi/spi_flash_update.c.
+ *
+ * Random updates are applied to a simulated flash that only clears bits
+ * when programmed. Each must leave the range holding the new data, keep
+ * everything outside it, erase exactly the sectors that cannot be reached
+ * by clearing bits, and leave unchanged pages alone. An update that would
+ * have to erase data outside its range must be refused.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <spi_flash.h>
+
+#define SECTOR_SIZE	4096
+#define SECTORS		16
+#define FLASH_SIZE	(SECTORS * SECTOR_SIZE)
+#define PAGE_SIZE	256
+#define TEST_ROUNDS	20000
+
+static u8 flash_data[FLASH_SIZE];
+static u8 page_written[FLASH_SIZE / PAGE_SIZE];
+static int erases, bad_ops, failures;
+
+static int flash_read(struct spi_flash *flash, u32 offset, size_t len,
+		      void *buf)
+{
+	memcpy(buf, &flash_data[offset], len);
+	return 0;
+}
+
+static int flash_write(struct spi_flash *flash, u32 offset, size_t len,
+		       const void *buf)
+{
+	const u8 *data = buf;
+	size_t i;
+
+	/* Page programs must not cross pages, and can only clear bits */
+	if (offset / PAGE_SIZE != (offset + len - 1) / PAGE_SIZE)
+		bad_ops++;
+	page_written[offset / PAGE_SIZE] = 1;
+	for (i = 0; i < len; i++) {
+		if ((flash_data[offset + i] & data[i]) != data[i])
+			bad_ops++;
+		flash_data[offset + i] &= data[i];
+	}
+	return 0;
+}
+
+static int flash_erase(struct spi_flash *flash, u32 offset, size_t len)
+{
+	if (offset % SECTOR_SIZE || len % SECTOR_SIZE)
+		bad_ops++;
+	memset(&flash_data[offset], 0xff, len);
+	erases++;
+	return 0;
+}
+
+static struct spi_flash flash = {
+	.name = "sim",
+	.size = FLASH_SIZE,
+	.sector_size = SECTOR_SIZE,
+	.read = flash_read,
+	.write = flash_write,
+	.erase = flash_erase,
+};
+
+static void fail(const char *what, int round)
+{
+	fprintf(stderr, "round %d: %s\n", round, what);
+	failures++;
+}
+
+static int is_erased(const u8 *data, size_t size)
+{
+	while (size--)
+		if (*data++ != 0xff)
+			return 0;
+	return 1;
+}
+
+static void test_random(void)
+{
+	static u8 before[FLASH_SIZE], want[FLASH_SIZE];
+	int round, ret, erase_runs, refuse;
+	u32 offset, len, i, sector, lo, hi;
+	int prev_erase, any;
+
+	for (round = 0; round < TEST_ROUNDS; round++) {
+		/* Some erased sectors, some with data */
+		if (round % 16 == 0)
+			for (sector = 0; sector < SECTORS; sector++)
+				for (i = 0; i < SECTOR_SIZE; i++)
+					flash_data[sector * SECTOR_SIZE + i] =
+						rand() % 2 ? 0xff : rand();
+
+		offset = rand() % FLASH_SIZE;
+		if (rand() % 2)
+			offset -= offset % SECTOR_SIZE;
+		len = 1 + rand() % (FLASH_SIZE - offset);
+		if (rand() % 2 && offset + len < FLASH_SIZE)
+			len += SECTOR_SIZE - (offset + len) % SECTOR_SIZE;
+
+		/* New contents: bits cleared, and in half the rounds
+		 * anything else as well */
+		memcpy(before, flash_data, FLASH_SIZE);
+		memcpy(want, flash_data, FLASH_SIZE);
+		any = rand() % 2;
+		for (i = offset; i < offset + len; i++) {
+			switch (rand() % 256) {
+			case 0:
+				if (any)
+					want[i] = rand();
+				break;
+			case 1:
+			case 2:
+				want[i] &= rand();
+				break;
+			}
+		}
+
+		/* What the update has to do per sector */
+		erase_runs = 0;
+		refuse = 0;
+		prev_erase = 0;
+		for (sector = offset / SECTOR_SIZE;
+		     sector * SECTOR_SIZE < offset + len; sector++) {
+			const u32 base = sector * SECTOR_SIZE;
+			int erase = 0;
+
+			lo = base > offset ? base : offset;
+			hi = base + SECTOR_SIZE < offset + len ?
+				base + SECTOR_SIZE : offset + len;
+			for (i = lo; i < hi; i++)
+				if ((before[i] & want[i]) != want[i])
+					erase = 1;
+			if (erase && (!is_erased(&before[base], lo - base) ||
+				      !is_erased(&before[hi],
+						 base + SECTOR_SIZE - hi)))
+				refuse = 1;
+			if (erase && !prev_erase)
+				erase_runs++;
+			prev_erase = erase;
+		}
+
+		erases = 0;
+		memset(page_written, 0, sizeof(page_written));
+		ret = spi_flash_update(&flash, offset, len, &want[offset]);
+
+		if (bad_ops) {
+			fail("bad flash operation", round);
+			bad_ops = 0;
+		}
+		if (refuse) {
+			if (ret == 0)
+				fail("update erased data outside its range",
+				     round);
+			memcpy(flash_data, before, FLASH_SIZE);
+			continue;
+		}
+		if (ret) {
+			fail("update failed", round);
+			continue;
+		}
+		if (memcmp(flash_data, want, FLASH_SIZE))
+			fail("wrong contents", round);
+		if (erases != erase_runs)
+			fail("wrong number of erases", round);
+		/* Without erases only changed pages get programmed */
+		for (i = 0; i < FLASH_SIZE / PAGE_SIZE && !erases; i++)
+			if (page_written[i] &&
+			    !memcmp(&before[i * PAGE_SIZE], &want[i * PAGE_SIZE],
+				    PAGE_SIZE))
+				fail("unchanged page programmed", round);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	srand(1);
+	test_random();
+
+	if (failures) {
+		fprintf(stderr, "%d failure(s)\n", failures);
+		return 1;
+	}
+	printf("spi_flash_update tests passed\n");
+	return 0;
+}